@@ -4,36 +4,54 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "hardware/gpio.h"
 #include "hardware/watchdog.h"
 #include "hardware/structs/watchdog.h"
 #include "hardware/i2c.h"
+#include "lib/hw_config.h"
 #include "lib/custom_ir.h"
 #include "lib/ssd1306.h"
+#include "lib/wdt_lease.h"
+#include "lib/kv_store.h"
+#include "lib/scrubber.h"
+#include "lib/power_monitor.h"
+#include "lib/powerfail_log.h"
+#include "lib/fleet.h"
+#include "lib/ir_planner.h"
+#include "lib/ir_queue.h"
+#include "lib/oled_asset.h"
+#include "lib/ui_pacer.h"
+#include "lib/display_bus.h"
+#include "lib/fb_mirror.h"
+#include "lib/oled_graph.h"
+#include "lib/input_trace.h"
+#include "lib/ac_profile.h"
+#include "lib/rule_engine.h"
+#include "lib/usb_msc.h"
+#include "screens.h"          // gerado no build (tools/render_screens.py)
+#include "assets.h"           // gerado no build (tools/img2oled.py)
 
-// ===================== PINOS BITDOGLAB =====================
-#define LED_BOOT_RED     13   // LED vermelho: indica boot/reset
-#define LED_OK_GREEN     11   // LED verde: operao normal
-#define LED_TRAVA_BLUE   12   // LED azul: falha/travamento
-#define BOTAO_A           5   // Boto A: falha proposital
-#define BOTAO_B          6   // Boto B: comandos IR
+// Pinos, display e I2C: lib/hw_config.h (conferidos na compilao)
 
-// ===================== PINOS IR =====================
-#define IR_PIN           16   // Pino para sada IR
-#define LED_PIN          25   // LED onboard do Pico
+// ===================== WATCHDOG =====================
+// Timeout curto: cobre s a cadncia do loop principal. Operaes longas
+// (flush do display, flash) abrem um lease com o prprio prazo
+// (wdt_lease.h); o IR sai pela fila e no segura o loop
+#define WDT_TIMEOUT_MS   1000  // 1 segundo
 
-// ===================== DISPLAY =====================
-#define I2C_PORT_DISP    i2c1
-#define SDA_DISP         14
-#define SCL_DISP         15
-#define DISPLAY_ADDR     0x3C
+// Prazos mximos declarados pelas operaes longas
+#define LEASE_DISPLAY_MS  250  // flush: ~10ms em 1MHz, ~93ms em 100kHz (+1 repetio)
 
-// ===================== WATCHDOG =====================
-// Timeout ajustado para latncia das operaes IR (transmisso + resposta AC)
-// Operao IR tpica: ~500ms, adicionamos margem para UART e display
-#define WDT_TIMEOUT_MS   5000  // 5 segundos de margem segura
+// Corrente dos LEDs IR e quanto a fonte aguenta sem derrubar o OLED
+#define IR_LED_CURRENT_MA    100
+#define IR_SUPPLY_BUDGET_MA  250
+
+// Os valores acima so padres: podem ser trocados em campo pelo
+// comando 'c' do console (gravados no kv_store, valem no prximo boot)
 
 // Cdigos de falha nos scratch registers
 #define FALHA_BOTAO_A    0x01  // Falha induzida manualmente (loop infinito)
@@ -51,12 +69,164 @@ typedef enum {
 } system_state_t;
 
 static system_state_t current_state = STATE_OFF;
-static system_state_t last_display_state = STATE_MAX; // fora atualizao inicial
+static system_state_t last_display_state = STATE_MAX; // ltimo estado marcado p/ desenho
+
+static const char *const state_names[STATE_MAX] = {
+    [STATE_OFF] = "OFF", [STATE_ON] = "ON", [STATE_TEMP_20] = "20C",
+    [STATE_TEMP_22] = "22C", [STATE_FAN_1] = "FAN1", [STATE_FAN_2] = "FAN2",
+};
+
+// O que cada estado significa para o aparelho (o perfil do emissor
+// transforma isso no quadro do modelo)
+static const ac_setting_t state_settings[STATE_MAX] = {
+    [STATE_OFF]     = { .power = false },
+    [STATE_ON]      = { .power = true, .mode = AC_MODE_COOL },
+    [STATE_TEMP_20] = { .power = true, .mode = AC_MODE_COOL, .temp_c = 20 },
+    [STATE_TEMP_22] = { .power = true, .mode = AC_MODE_COOL, .temp_c = 22 },
+    [STATE_FAN_1]   = { .power = true, .mode = AC_MODE_FAN, .fan = 1 },
+    [STATE_FAN_2]   = { .power = true, .mode = AC_MODE_FAN, .fan = 2 },
+};
+
+// ===================== FROTA =====================
+// Unidades controladas. O emissor 0  o IR_PIN; salas com vrios aparelhos
+// acrescentam linhas aqui (emissores extras via custom_ir_add_emitter).
+// O modelo do aparelho vem do perfil do emissor (comando 'l')
+typedef struct {
+    uint8_t emitter;
+    char zone;
+} fleet_layout_t;
+
+static const fleet_layout_t fleet_layout[] = {
+    { .emitter = 0, .zone = 'A' },   // unidade 0 = AC principal
+};
+
+// Pgina exibida no OLED
+typedef enum {
+    UI_PAGE_STATUS,
+    UI_PAGE_FLEET,
+    UI_PAGE_TRENDS,
+    UI_PAGE_COUNT
+} ui_page_t;
+
+static ui_page_t ui_page = UI_PAGE_STATUS;
+
+// Regras: temperatura entregue em passos de meio grau (rudo do sensor
+// no reavalia as regras a cada leitura)
+#define RULE_TEMP_HYST_C10  5
+
+// Tendncias (uma coluna por segundo): pico do tempo de loop e quadros IR
+#define TREND_INTERVAL_MS  1000
+#define TREND_X            44
+#define TREND_WIDTH        76
+static oled_graph_t graph_loop;     // us, mximo do intervalo
+static oled_graph_t graph_cmd;      // quadros IR iniciados no intervalo
+
+// ===================== CONFIGURAO EM FLASH =====================
+typedef struct {
+    uint ir_pin;
+    uint sda_disp;
+    uint scl_disp;
+    uint8_t display_addr;
+    uint32_t wdt_timeout_ms;
+    uint32_t ir_carrier_freq;
+    uint8_t ui_fps;
+    bool trace_rec;
+    uint32_t reassert_s;
+} app_config_t;
+
+typedef struct {
+    const char *name;
+    uint16_t key;
+    uint32_t def;
+    uint32_t min, max;
+} config_item_t;
+
+static const config_item_t config_items[] = {
+    { "ir_pin",    KV_KEY_IR_PIN,          IR_PIN,         0,     HW_GPIO_COUNT - 1 },
+    { "sda",       KV_KEY_SDA_DISP,        SDA_DISP,       0,     HW_GPIO_COUNT - 1 },
+    { "scl",       KV_KEY_SCL_DISP,        SCL_DISP,       0,     HW_GPIO_COUNT - 1 },
+    { "disp_addr", KV_KEY_DISPLAY_ADDR,    DISPLAY_ADDR,   0x08,  0x77  },
+    { "wdt_ms",    KV_KEY_WDT_TIMEOUT_MS,  WDT_TIMEOUT_MS, 100,   8000  },
+    { "carrier",   KV_KEY_IR_CARRIER_FREQ, IR_CARRIER_FREQ, IR_CARRIER_MIN_HZ, IR_CARRIER_MAX_HZ },
+    { "ui_fps",    KV_KEY_UI_FPS,          UI_PACER_DEFAULT_FPS, 1, UI_PACER_MAX_FPS },
+    { "trace_rec", KV_KEY_TRACE_REC,       0,              0,     1     },
+    { "reassert_s", KV_KEY_REASSERT_S,     0,              0,     86400 },  // 0 = desligada
+};
+
+static app_config_t cfg;
 
 // ===================== VARIVEIS GLOBAIS =====================
 static ssd1306_t ssd;
 static uint32_t last_operation_time = 0;
 static bool ir_operation_pending = false;
+static uint32_t last_input_ms = 0;          // ltimo boto ou comando do console
+static int16_t rule_temp_c10 = INT16_MIN;   // temperatura entregue s regras
+
+// ===================== FROTA: REAFIRMAO =====================
+// Reenvio peridico do estado (fleet_reassert) pela classe de fundo da
+// fila IR. As repeties do perfil saem uma de cada vez, com o intervalo
+// do modelo entre elas; qualquer comando do usurio corta o que restar.
+// O tempo no ar  o medido pela fila (repeties cortadas contam s o
+// que saiu)
+static struct {
+    const ac_frame_t *frame;
+    uint8_t emitter;
+    uint8_t left;           // repeties ainda no enfileiradas
+    uint16_t gap_ms;
+    uint32_t next_ms;       // quando a prxima pode entrar na fila
+    uint32_t airtime_us;    // tempo no ar da classe de fundo j repassado  frota
+} reassert_tx;
+
+static void reassert_poll(uint32_t now_ms) {
+    ir_queue_stats_t q;
+    ir_queue_get_stats(&q);
+    if (q.airtime_us[IR_PRIO_BACKGROUND] != reassert_tx.airtime_us) {
+        fleet_add_reassert_airtime(q.airtime_us[IR_PRIO_BACKGROUND] - reassert_tx.airtime_us);
+        reassert_tx.airtime_us = q.airtime_us[IR_PRIO_BACKGROUND];
+    }
+    if (reassert_tx.left == 0 || (int32_t)(now_ms - reassert_tx.next_ms) < 0 || !ir_queue_idle()) {
+        return;
+    }
+    const ac_frame_t *f = reassert_tx.frame;
+    ir_queue_item_t item = {
+        .emitter = reassert_tx.emitter,
+        .prio = IR_PRIO_BACKGROUND,
+        .key = f->key,
+        .signal = f->timings,
+        .length = f->length,
+    };
+    if (!ir_queue_submit(&item)) {
+        reassert_tx.left = 0;
+        return;
+    }
+    reassert_tx.left--;
+    reassert_tx.next_ms = now_ms + ir_signal_duration_us(f->timings, f->length) / 1000 + 1 +
+                          reassert_tx.gap_ms;
+}
+
+// fleet_send_fn: s enfileira; o airtime chega depois por reassert_poll
+static bool reassert_send(uint8_t emitter, uint8_t protocol, uint8_t state, uint32_t *airtime_us) {
+    (void)protocol;
+    const ac_frame_t *f = ac_profile_frame(emitter, state);
+    const ac_compiled_t *c = ac_profile_compiled(emitter);
+    if (!f || reassert_tx.left > 0) {
+        return false;
+    }
+    reassert_tx.frame = f;
+    reassert_tx.emitter = emitter;
+    reassert_tx.left = c->repeat;
+    reassert_tx.gap_ms = c->gap_ms;
+    reassert_tx.next_ms = to_ms_since_boot(get_absolute_time());
+    *airtime_us = 0;
+    reassert_poll(reassert_tx.next_ms);
+    return true;
+}
+
+// Antes de um envio direto: o emissor fica livre na hora
+static void reassert_cancel(void) {
+    reassert_tx.left = 0;
+    ir_queue_flush(IR_PRIO_BACKGROUND);
+}
 
 // ===================== HELPERS GPIO =====================
 static void init_gpio(void) {
@@ -83,29 +253,28 @@ static void init_gpio(void) {
 
 // ===================== HELPERS DISPLAY =====================
 static void init_display(ssd1306_t *ssd) {
-    i2c_init(I2C_PORT_DISP, 400 * 1000);
-    gpio_set_function(SDA_DISP, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_DISP, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_DISP);
-    gpio_pull_up(SCL_DISP);
+    gpio_set_function(cfg.sda_disp, GPIO_FUNC_I2C);
+    gpio_set_function(cfg.scl_disp, GPIO_FUNC_I2C);
+    gpio_pull_up(cfg.sda_disp);
+    gpio_pull_up(cfg.scl_disp);
+
+    // Sonda a maior velocidade estvel (at 1MHz) antes de configurar
+    display_bus_init(I2C_PORT_DISP, cfg.display_addr);
 
-    ssd1306_init(ssd, WIDTH, HEIGHT, false, DISPLAY_ADDR, I2C_PORT_DISP);
+    ssd1306_init(ssd, WIDTH, HEIGHT, false, cfg.display_addr, I2C_PORT_DISP);
     ssd1306_config(ssd);
 }
 
-static void draw_frame_base(ssd1306_t *ssd, bool cor) {
-    ssd1306_fill(ssd, !cor);
-    ssd1306_rect(ssd, 3, 3, 122, 60, cor, !cor);
-    ssd1306_line(ssd, 3, 25, 123, 25, cor);
-    ssd1306_line(ssd, 3, 37, 123, 37, cor);
+// Camada esttica (moldura, ttulos e rtulos) pr-renderizada no build
+static void load_screen(ssd1306_t *ssd, screen_id_t id) {
+    ssd1306_load(ssd, screen_layers[id]);
 }
 
 // Tela de diagnstico de boot
 static void show_boot_diag(ssd1306_t *ssd, bool reboot_wdt, uint32_t count, uint32_t fault) {
     char line[22];
-    draw_frame_base(ssd, true);
+    load_screen(ssd, SCREEN_BOOT);
 
-    ssd1306_draw_string(ssd, "IR + WDT SYSTEM", 6, 6);
     ssd1306_draw_string(ssd, reboot_wdt ? "RESET WATCHDOG" : "RESET NORMAL", 10, 16);
 
     snprintf(line, sizeof(line), "COUNT: %lu", (unsigned long)count);
@@ -114,62 +283,142 @@ static void show_boot_diag(ssd1306_t *ssd, bool reboot_wdt, uint32_t count, uint
     snprintf(line, sizeof(line), "FAULT: 0x%02lX", (unsigned long)fault);
     ssd1306_draw_string(ssd, line, 10, 40);
     
-    snprintf(line, sizeof(line), "TIMEOUT: %dms", WDT_TIMEOUT_MS);
+    snprintf(line, sizeof(line), "TIMEOUT: %lums", (unsigned long)cfg.wdt_timeout_ms);
     ssd1306_draw_string(ssd, line, 10, 52);
 
-    ssd1306_send_data(ssd);
+    display_bus_flush(ssd);
 }
 
-// Tela de operao mostrando estado do AC
-static void show_running_state(ssd1306_t *ssd, system_state_t state) {
-    char line[22];
-    draw_frame_base(ssd, true);
+// Dgitos grandes da tela de operao (assets/oled/digit_N.png)
+static const oled_asset_t *const big_digits[10] = {
+    &asset_digit_0, &asset_digit_1, &asset_digit_2, &asset_digit_3, &asset_digit_4,
+    &asset_digit_5, &asset_digit_6, &asset_digit_7, &asset_digit_8, &asset_digit_9,
+};
+
+// Faixa do estado na tela de operao (entre o ttulo e a divisria)
+#define STATUS_ICON_X   10
+#define STATUS_ICON_Y   16
+#define STATUS_VALUE_X  40
+#define STATUS_VALUE_Y  16
+#define STATUS_TEXT_Y   22      // texto 8x8 centralizado na faixa
 
-    ssd1306_draw_string(ssd, "AC CONTROL+WDT", 12, 6);
+// Tela de operao mostrando estado do AC: cone do modo + valor grande
+static bool show_running_state(ssd1306_t *ssd, system_state_t state) {
+    uint8_t w;
+    load_screen(ssd, SCREEN_RUNNING);
     
     // Mostra estado atual do AC
     switch (state) {
         case STATE_OFF:
-            ssd1306_draw_string(ssd, "AC: DESLIGADO", 10, 16);
+            oled_asset_draw(ssd, &asset_icon_power, STATUS_ICON_X, STATUS_ICON_Y);
+            ssd1306_draw_string(ssd, "DESLIGADO", STATUS_VALUE_X, STATUS_TEXT_Y);
             break;
         case STATE_ON:
-            ssd1306_draw_string(ssd, "AC: LIGADO", 10, 16);
+            oled_asset_draw(ssd, &asset_icon_power, STATUS_ICON_X, STATUS_ICON_Y);
+            ssd1306_draw_string(ssd, "LIGADO", STATUS_VALUE_X, STATUS_TEXT_Y);
             break;
         case STATE_TEMP_20:
-            ssd1306_draw_string(ssd, "AC: 20C", 10, 16);
-            break;
         case STATE_TEMP_22:
-            ssd1306_draw_string(ssd, "AC: 22C", 10, 16);
+            oled_asset_draw(ssd, &asset_icon_snow, STATUS_ICON_X, STATUS_ICON_Y);
+            w = oled_asset_draw_number(ssd, big_digits, state == STATE_TEMP_20 ? 20 : 22,
+                                       STATUS_VALUE_X, STATUS_VALUE_Y, 3);
+            ssd1306_draw_string(ssd, "C", STATUS_VALUE_X + w + 3, STATUS_VALUE_Y);
             break;
         case STATE_FAN_1:
-            ssd1306_draw_string(ssd, "AC: FAN NIVEL 1", 10, 16);
-            break;
         case STATE_FAN_2:
-            ssd1306_draw_string(ssd, "AC: FAN NIVEL 2", 10, 16);
+            oled_asset_draw(ssd, &asset_icon_fan, STATUS_ICON_X, STATUS_ICON_Y);
+            w = oled_asset_draw_number(ssd, big_digits, state == STATE_FAN_1 ? 1 : 2,
+                                       STATUS_VALUE_X, STATUS_VALUE_Y, 3);
+            ssd1306_draw_string(ssd, "FAN", STATUS_VALUE_X + w + 6, STATUS_TEXT_Y);
             break;
         default:
-            ssd1306_draw_string(ssd, "AC: UNKNOWN", 10, 16);
+            ssd1306_draw_string(ssd, "AC: UNKNOWN", 10, STATUS_TEXT_Y);
             break;
     }
 
-    ssd1306_draw_string(ssd, "BTN A=FALHA", 10, 28);
-    ssd1306_draw_string(ssd, "BTN B=NEXT CMD", 10, 40);
-    ssd1306_draw_string(ssd, "WDT: ATIVO", 10, 52);
-
-    ssd1306_send_data(ssd);
+    return display_bus_flush(ssd);
 }
 
 // Tela de falha
 static void show_fault_mode(ssd1306_t *ssd, const char* msg) {
-    draw_frame_base(ssd, true);
+    char line[22];
+    load_screen(ssd, SCREEN_FAULT);
 
-    ssd1306_draw_string(ssd, "FALHA INDUZIDA", 12, 6);
     ssd1306_draw_string(ssd, msg, 10, 16);
-    ssd1306_draw_string(ssd, "Sem feed WDT", 10, 28);
-    ssd1306_draw_string(ssd, "Aguard. reset", 10, 40);
-    ssd1306_draw_string(ssd, "em ~5 seg...", 10, 52);
+    snprintf(line, sizeof(line), "em ~%lu ms", (unsigned long)cfg.wdt_timeout_ms);
+    ssd1306_draw_string(ssd, line, 10, 52);
+
+    display_bus_flush(ssd);
+}
+
+// Tela da frota: uma linha por unidade ("> " = transmisso pendente)
+static bool show_fleet_state(ssd1306_t *ssd) {
+    char line[22];
+    load_screen(ssd, SCREEN_FLEET);
+
+    uint8_t shown = 0;
+    for (uint8_t i = 0; i < fleet_count() && shown < 4; i++, shown++) {
+        const fleet_unit_t *u = fleet_get(i);
+        const char *desired = u->desired < STATE_MAX ? state_names[u->desired] : "--";
+        snprintf(line, sizeof(line), "%u%c %-4s %s", i, u->zone, desired,
+                 u->desired == u->sent ? "OK" : (u->failures ? "ERR" : ">"));
+        // Linhas abaixo da divisria (y=16, 28, 40, 52)
+        ssd1306_draw_string(ssd, line, 10, 16 + shown * 12);
+    }
+
+    return display_bus_flush(ssd);
+}
 
-    ssd1306_send_data(ssd);
+// Valores atuais ao lado dos grficos (8 colunas x 4 caracteres)
+static void draw_trend_values(ssd1306_t *ssd) {
+    char line[8];
+    unsigned long loop_ms = (unsigned long)(oled_graph_last(&graph_loop) / 1000);
+    unsigned long per_min = (unsigned long)oled_graph_sum(&graph_cmd, 60);   // ltimo minuto
+
+    // Sempre 4 caracteres: o grfico comea na coluna 44
+    if (loop_ms > 99) {
+        snprintf(line, sizeof(line), ">99 ");
+    } else {
+        snprintf(line, sizeof(line), "%2lums", loop_ms);
+    }
+    ssd1306_draw_string(ssd, line, 8, 24);
+    snprintf(line, sizeof(line), "%-4lu", per_min > 9999 ? 9999 : per_min);
+    ssd1306_draw_string(ssd, line, 8, 48);
+}
+
+// Tela de tendncias completa (troca de pgina ou mudana de escala)
+static bool show_trends(ssd1306_t *ssd) {
+    load_screen(ssd, SCREEN_TRENDS);
+    draw_trend_values(ssd);
+    oled_graph_draw(&graph_loop, ssd);
+    oled_graph_draw(&graph_cmd, ssd);
+    return display_bus_flush(ssd);
+}
+
+// Fecha o segundo dos grficos; na tela de tendncias s rola os grficos
+static void trends_tick(ssd1306_t *ssd) {
+    static uint32_t last_started = 0;
+    ir_tx_stats_t tx;
+    custom_ir_get_tx_stats(&tx);
+    oled_graph_sample(&graph_cmd, (int32_t)(tx.started - last_started));
+    last_started = tx.started;
+
+    bool rescaled = oled_graph_tick(&graph_loop);
+    rescaled |= oled_graph_tick(&graph_cmd);
+
+    if (ui_page != UI_PAGE_TRENDS) {
+        return;
+    }
+    if (rescaled) {
+        ui_pacer_mark_dirty();
+        return;
+    }
+    oled_graph_scroll(&graph_loop, ssd);
+    oled_graph_scroll(&graph_cmd, ssd);
+    draw_trend_values(ssd);
+    // Valores + os dois grficos: colunas 8..119, pginas 2..6
+    ui_pacer_mark_rect(8, TREND_X + TREND_WIDTH - 1, graph_loop.page,
+                       graph_cmd.page + graph_cmd.pages - 1);
 }
 
 // ===================== CONTROLE IR COM PROTEO =====================
@@ -180,9 +429,6 @@ static bool execute_ir_command_safe(system_state_t new_state) {
     
     printf("Executando comando IR para estado: %d\n", new_state);
     
-    // Feed do watchdog ANTES da operao IR
-    watchdog_update();
-    
     // ===== DEFEITO 2: TEMPERATURA 22C =====
     // Simula falha ao tentar configurar 22C
     if (new_state == STATE_TEMP_22) {
@@ -207,32 +453,22 @@ static bool execute_ir_command_safe(system_state_t new_state) {
     switch (new_state) {
         case STATE_OFF:
             printf("Comando: DESLIGAR AC\n");
-            turn_off_ac();
-            gpio_put(LED_PIN, 0);
             break;
             
         case STATE_ON:
             printf("Comando: LIGAR AC\n");
-            turn_on_ac();
-            gpio_put(LED_PIN, 1);
             break;
             
         case STATE_TEMP_20:
             printf("Comando: TEMPERATURA 20C\n");
-            set_temp_20c();
-            gpio_put(LED_PIN, 1);
             break;
             
         case STATE_FAN_1:
             printf("Comando: VENTILADOR NIVEL 1\n");
-            set_fan_level_1();
-            gpio_put(LED_PIN, 1);
             break;
             
         case STATE_FAN_2:
             printf("Comando: VENTILADOR NIVEL 2\n");
-            set_fan_level_2();
-            gpio_put(LED_PIN, 1);
             break;
             
         default:
@@ -240,26 +476,520 @@ static bool execute_ir_command_safe(system_state_t new_state) {
             ir_operation_pending = false;
             return false;
     }
-    
-    // Feed do watchdog APS a operao IR
-    watchdog_update();
-    
-    // Delay para garantir transmisso completa
-    sleep_ms(100);
+
+    // Quadro j compilado pelo perfil do emissor 0; vai para a fila com as
+    // repeties do perfil e o loop segue (uma emergncia corta o envio)
+    reassert_cancel();
+    if (!ac_profile_send(0, new_state)) {
+        ir_operation_pending = false;
+        return false;
+    }
+    gpio_put(LED_PIN, new_state != STATE_OFF);
     
     ir_operation_pending = false;
     current_state = new_state;
+    fleet_mark_sent(0, new_state, to_ms_since_boot(get_absolute_time()));
     
-    printf("Comando IR executado com sucesso\n");
+    printf("Comando IR na fila\n");
     return true;
 }
 
+// ===================== FROTA: ENVIO PLANEJADO =====================
+// Envio dos grupos da frota: emissores diferentes transmitem ao mesmo
+// tempo, defasados pelo planejador para respeitar IR_SUPPLY_BUDGET_MA.
+// Cada repetio do quadro (perfil do emissor)  uma entrada do plano; o
+// plano vai para a fila na classe de usurio e o loop no espera
+static void fleet_send_batch(fleet_frame_t *frames, uint8_t count) {
+    ir_plan_frame_t plan[IR_PLAN_MAX_FRAMES];
+    uint8_t map[IR_PLAN_MAX_FRAMES];
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const ac_frame_t *f = ac_profile_frame(frames[i].emitter, frames[i].state);
+        const ac_compiled_t *c = ac_profile_compiled(frames[i].emitter);
+        frames[i].ok = false;
+        frames[i].airtime_us = 0;
+        if (!f) {
+            printf("Frota: estado %u sem quadro no perfil do emissor %u\n",
+                   frames[i].state, frames[i].emitter);
+            continue;
+        }
+        if (n + c->repeat > IR_PLAN_MAX_FRAMES) {
+            continue;       // fica pendente para a prxima rodada
+        }
+        frames[i].ok = true;
+        for (uint8_t r = 0; r < c->repeat; r++) {
+            plan[n].emitter = frames[i].emitter;
+            plan[n].key = f->key;
+            plan[n].signal = f->timings;
+            plan[n].length = f->length;
+            plan[n].gap_us = (uint32_t)c->gap_ms * 1000;
+            map[n++] = i;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+
+    reassert_cancel();
+    ir_planner_submit(plan, n, IR_PRIO_USER);
+
+    // Unidade atualizada s se todas as repeties entraram na fila
+    for (uint8_t k = 0; k < n; k++) {
+        fleet_frame_t *fr = &frames[map[k]];
+        fr->ok = fr->ok && plan[k].ok;
+        fr->airtime_us += plan[k].ok ? plan[k].duration_us : 0;
+    }
+
+    ir_planner_stats_t st;
+    ir_planner_get_stats(&st);
+    printf("Frota: %u quadros em %lums (um por vez: %lums), pico %umA\n", n,
+           (unsigned long)(st.last_makespan_us / 1000),
+           (unsigned long)(st.last_serial_us / 1000), st.last_peak_ma);
+}
+
+static void print_fleet(void) {
+    fleet_stats_t st;
+    fleet_get_stats(&st);
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    printf("\n=== FROTA (%u unidades) ===\n", fleet_count());
+    for (uint8_t i = 0; i < fleet_count(); i++) {
+        const fleet_unit_t *u = fleet_get(i);
+        printf("U%u zona %c emissor %u %-12.12s: desejado %-4s enviado %-4s ha %lus (%u envios)\n",
+               i, u->zone, u->emitter, ac_profile_get(ac_profile_selected(u->emitter))->name,
+               u->desired < STATE_MAX ? state_names[u->desired] : "--",
+               u->sent < STATE_MAX ? state_names[u->sent] : "--",
+               (unsigned long)(u->sent_ms ? (now - u->sent_ms) / 1000 : 0), u->tx_count);
+    }
+    printf("Quadros: %lu para %lu atualizacoes, %lums no ar, %lu falhas\n",
+           (unsigned long)st.frames, (unsigned long)st.unit_updates,
+           (unsigned long)(st.airtime_us / 1000), (unsigned long)st.failures);
+
+    // Custo da reafirmao: frao do tempo no ar e do tempo ligado
+    if (cfg.reassert_s == 0) {
+        printf("Reafirmacao: desligada (config reassert_s)\n");
+        return;
+    }
+    uint32_t air_bp = st.airtime_us ? (uint32_t)((uint64_t)st.reassert_airtime_us * 10000 / st.airtime_us) : 0;
+    uint32_t up_ppm = now ? (uint32_t)((uint64_t)st.reassert_airtime_us * 1000 / now) : 0;
+    printf("Reafirmacao a cada %lus: %lu quadros, %lu vezes puladas (envio recente), "
+           "%lums no ar = %lu.%02lu%% do tempo no ar da frota, %lu ppm do tempo ligado\n",
+           (unsigned long)cfg.reassert_s, (unsigned long)st.reasserts,
+           (unsigned long)st.reassert_skipped, (unsigned long)(st.reassert_airtime_us / 1000),
+           (unsigned long)(air_bp / 100), (unsigned long)(air_bp % 100), (unsigned long)up_ppm);
+}
+
+static void print_ui_stats(void) {
+    ui_pacer_stats_t st;
+    ui_pacer_get_stats(&st);
+
+    printf("\n=== DISPLAY ===\n");
+    printf("Limite: %u quadros/s\n", st.fps);
+    printf("Quadros: %lu (%lu parciais), agrupados: %lu, intervalos sem mudanca: %lu\n",
+           (unsigned long)st.frames, (unsigned long)st.partial,
+           (unsigned long)st.coalesced, (unsigned long)st.skipped);
+    printf("Tempo por quadro: ultimo %luus, medio %luus, max %luus\n",
+           (unsigned long)st.frame_last_us,
+           (unsigned long)(st.frames ? st.frame_sum_us / st.frames : 0),
+           (unsigned long)st.frame_max_us);
+
+    display_bus_stats_t bus;
+    display_bus_get_stats(&bus);
+    uint32_t ok = bus.flushes - bus.failed - bus.partial;
+    printf("I2C: %lu Hz (nivel %u), quedas: %lu\n",
+           (unsigned long)bus.baud, bus.level, (unsigned long)bus.fallbacks);
+    printf("Flush tela inteira: %lu ok, %lu perdidos, %lu erros; ultimo %luus, medio %luus, max %luus\n",
+           (unsigned long)ok, (unsigned long)bus.failed, (unsigned long)bus.errors,
+           (unsigned long)bus.flush_last_us,
+           (unsigned long)(ok ? bus.flush_sum_us / ok : 0),
+           (unsigned long)bus.flush_max_us);
+    printf("Flush parcial: %lu, ultimo %luus\n",
+           (unsigned long)bus.partial, (unsigned long)bus.partial_last_us);
+
+    fb_mirror_stats_t fm;
+    fb_mirror_get_stats(&fm);
+    printf("Espelho USB: %s, %lu quadros (%lu chave), %lu sem mudanca, ultimo %lu bytes, medio %lu\n",
+           fm.enabled ? "ATIVO" : "desligado", (unsigned long)fm.frames,
+           (unsigned long)fm.keyframes, (unsigned long)fm.unchanged,
+           (unsigned long)fm.bytes_last,
+           (unsigned long)(fm.frames ? fm.bytes_sum / fm.frames : 0));
+}
+
+static void print_ir_tx(void) {
+    ir_tx_stats_t tx;
+    custom_ir_get_tx_stats(&tx);
+
+    printf("\n=== TRANSMISSAO IR ===\n");
+    printf("Quadros armados: %lu, iniciados: %lu, atraso do disparo: ultimo %luus, max %luus\n",
+           (unsigned long)tx.armed, (unsigned long)tx.started,
+           (unsigned long)tx.late_last_us, (unsigned long)tx.late_max_us);
+
+    ir_queue_stats_t q;
+    ir_queue_get_stats(&q);
+    printf("Fila: %lu pedidos, %lu enviados, %lu cortados, %lu descartados\n",
+           (unsigned long)q.submitted, (unsigned long)q.sent,
+           (unsigned long)q.preempted, (unsigned long)q.dropped);
+    printf("Planejados atrasados: %lu, travados: %lu\n",
+           (unsigned long)q.late, (unsigned long)q.stuck);
+    printf("Preempcao ate a primeira borda: ultima %luus, max %luus\n",
+           (unsigned long)q.preempt_last_us, (unsigned long)q.preempt_max_us);
+#if IR_BACKEND_EDGE
+    printf("Bordas por IRQ: %lu, jitter medio %luus, max %luus, alvos vencidos: %lu\n",
+           (unsigned long)tx.edges,
+           (unsigned long)(tx.edges ? tx.edge_late_sum_us / tx.edges : 0),
+           (unsigned long)tx.edge_late_max_us, (unsigned long)tx.edge_missed);
+#else
+    ir_wave_cache_stats_t st;
+    custom_ir_cache_get_stats(&st);
+    uint32_t total = st.hits + st.misses;
+
+    printf("--- Cache de quadros ---\n");
+    printf("Entradas: %u, uso: %u/%u bytes\n", st.entries, st.used_bytes, IR_WAVE_CACHE_BYTES);
+    printf("Acertos: %lu, faltas: %lu (%lu%%), remocoes: %lu, fora da cache: %lu\n",
+           (unsigned long)st.hits, (unsigned long)st.misses,
+           (unsigned long)(total ? st.hits * 100 / total : 0),
+           (unsigned long)st.evictions, (unsigned long)st.uncached);
+#endif
+}
+
+// Desligamento de emergncia: OFF em todos os emissores, cortando o que
+// estiver no ar pela fila (usurio, frota, reafirmao) e descartando as
+// repeties e quadros planejados que faltavam; a frota passa a considerar
+// tudo desligado
+static void emergency_off(void) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        // Direto da tabela compilada: nem uma tabela RAW desabilitada
+        // pelo verificador segura o OFF de emergncia
+        const ac_frame_t *off = &ac_profile_compiled(e)->frames[STATE_OFF];
+        if (!off->timings) {
+            continue;
+        }
+        ir_queue_item_t item = {
+            .emitter = e,
+            .prio = IR_PRIO_EMERGENCY,
+            .key = off->key,
+            .signal = off->timings,
+            .length = off->length,
+        };
+        ir_queue_submit(&item);
+    }
+    // Pedidos antigos na fila (e repeties de reafirmao) no podem
+    // religar nada depois do OFF
+    reassert_tx.left = 0;
+    ir_queue_flush(IR_PRIO_USER);
+    for (uint8_t i = 0; i < fleet_count(); i++) {
+        fleet_mark_sent(i, STATE_OFF, now);
+    }
+    current_state = STATE_OFF;
+    printf("EMERGENCIA: OFF em %u emissores\n", custom_ir_emitter_count());
+}
+
+static bool parse_state(const char *s, uint8_t *state) {
+    static const char *const names[STATE_MAX] = {
+        [STATE_OFF] = "off", [STATE_ON] = "on", [STATE_TEMP_20] = "20",
+        [STATE_TEMP_22] = "22", [STATE_FAN_1] = "fan1", [STATE_FAN_2] = "fan2",
+    };
+    for (uint8_t i = 0; i < STATE_MAX; i++) {
+        if (strcmp(s, names[i]) == 0) {
+            *state = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ===================== CONFIGURAO =====================
+// Valor gravado na flash (ou padro) limitado  faixa vlida
+static uint32_t config_value(uint16_t key) {
+    for (size_t i = 0; i < sizeof(config_items) / sizeof(config_items[0]); i++) {
+        const config_item_t *item = &config_items[i];
+        if (item->key != key) continue;
+        uint32_t v = kv_get_or(key, item->def);
+        return (v < item->min || v > item->max) ? item->def : v;
+    }
+    return 0;
+}
+
+static void load_config(void) {
+    cfg.ir_pin          = config_value(KV_KEY_IR_PIN);
+    cfg.sda_disp        = config_value(KV_KEY_SDA_DISP);
+    cfg.scl_disp        = config_value(KV_KEY_SCL_DISP);
+    cfg.display_addr    = (uint8_t)config_value(KV_KEY_DISPLAY_ADDR);
+    cfg.wdt_timeout_ms  = config_value(KV_KEY_WDT_TIMEOUT_MS);
+    cfg.ir_carrier_freq = config_value(KV_KEY_IR_CARRIER_FREQ);
+    cfg.ui_fps          = (uint8_t)config_value(KV_KEY_UI_FPS);
+    cfg.trace_rec       = config_value(KV_KEY_TRACE_REC) != 0;
+    cfg.reassert_s      = config_value(KV_KEY_REASSERT_S);
+
+    // Pinos trocados em campo passam pelas mesmas regras de hw_config.h
+    if (!hw_pins_valid(cfg.ir_pin, cfg.sda_disp, cfg.scl_disp)) {
+        printf("AVISO: pinos ir=%lu sda=%lu scl=%lu conflitam, usando os padroes\n",
+               (unsigned long)cfg.ir_pin, (unsigned long)cfg.sda_disp,
+               (unsigned long)cfg.scl_disp);
+        cfg.ir_pin   = IR_PIN;
+        cfg.sda_disp = SDA_DISP;
+        cfg.scl_disp = SCL_DISP;
+    }
+}
+
+static void print_config(void) {
+    kv_store_stats_t st;
+    kv_store_get_stats(&st);
+
+    printf("\n=== CONFIGURACAO (flash) ===\n");
+    for (size_t i = 0; i < sizeof(config_items) / sizeof(config_items[0]); i++) {
+        uint32_t stored;
+        bool has = kv_get(config_items[i].key, &stored);
+        printf("%-10s = %lu%s\n", config_items[i].name,
+               (unsigned long)(has ? stored : config_items[i].def),
+               has ? "" : " (padrao)");
+    }
+    printf("KV: ger %lu, %u/%u slots, %u chaves, scan %luus, %u CRC ruins\n",
+           (unsigned long)st.generation, st.used_slots, st.total_slots,
+           st.live_keys, (unsigned long)st.scan_us, st.bad_records);
+}
+
+// L uma linha do console com prazo; o lease cobre a espera
+static bool read_console_line(char *buf, size_t size, uint32_t timeout_ms) {
+    size_t n = 0;
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+
+    bool leased = wdt_lease_begin(timeout_ms + 100, WDT_LEASE_CONSOLE);
+    while (!time_reached(deadline)) {
+        int ch = input_trace_getchar(1000);
+        if (ch == PICO_ERROR_TIMEOUT) {
+            continue;
+        }
+        if (ch == '\r' || ch == '\n') {
+            if (n == 0) continue;
+            buf[n] = '\0';
+            printf("\n");
+            if (leased) {
+                wdt_lease_end();
+            }
+            return true;
+        }
+        if (n + 1 < size) {
+            buf[n++] = (char)ch;
+            putchar(ch);
+        }
+    }
+    if (leased) {
+        wdt_lease_end();
+    }
+    printf("\n(tempo esgotado)\n");
+    return false;
+}
+
+// Comando 'c': "<nome> <valor>" grava no kv_store
+static void config_command(void) {
+    char line[32];
+
+    printf("Config (<nome> <valor>, ex: ir_pin 17): ");
+    if (!read_console_line(line, sizeof(line), 5000)) {
+        return;
+    }
+
+    char *value_str = strchr(line, ' ');
+    if (!value_str) {
+        printf("Formato invalido\n");
+        return;
+    }
+    *value_str++ = '\0';
+
+    for (size_t i = 0; i < sizeof(config_items) / sizeof(config_items[0]); i++) {
+        const config_item_t *item = &config_items[i];
+        if (strcmp(line, item->name) != 0) continue;
+
+        char *end;
+        unsigned long v = strtoul(value_str, &end, 0);
+        if (end == value_str || v < item->min || v > item->max) {
+            printf("Valor fora da faixa (%lu..%lu)\n",
+                   (unsigned long)item->min, (unsigned long)item->max);
+            return;
+        }
+        if (kv_set(item->key, (uint32_t)v)) {
+            printf("%s = %lu gravado (vale no proximo boot)\n", item->name, v);
+        } else {
+            printf("ERRO: falha ao gravar na flash\n");
+        }
+        return;
+    }
+    printf("Chave desconhecida: %s\n", line);
+}
+
+// ===================== QUEDA DE ENERGIA =====================
+// Roda na IRQ do DMA do monitor de VSYS: s corta o IR e a leitura da
+// flash e deixa o estado mnimo em RAM. A pgina (j apagada)  gravada no
+// prximo ponto seguro: lao principal ou espera do console
+static void on_power_fail(uint16_t vsys_mv) {
+    powerfail_record_t rec = { 0 };
+
+    if (custom_ir_abort()) {
+        rec.flags |= PF_FLAG_IR_ABORTED;
+    }
+    scrubber_stop();
+
+    rec.uptime_ms = to_ms_since_boot(get_absolute_time());
+    rec.vsys_mv = vsys_mv;
+    rec.ac_state = (uint8_t)current_state;
+    rec.wdt_resets = watchdog_hw->scratch[0];
+    rec.last_fault = watchdog_hw->scratch[1];
+    powerfail_log_request(&rec);
+
+    gpio_put(LED_BOOT_RED, 1);
+}
+
+static void print_power_status(void) {
+    power_monitor_stats_t st;
+    power_monitor_get_stats(&st);
+    printf("VSYS: %umV (min %umV), %s, %lu blocos, %lu disparos, chip %d.%dC\n",
+           st.vsys_mv, st.min_mv, st.armed ? "armado" : "desarmado",
+           (unsigned long)st.blocks, (unsigned long)st.triggers,
+           st.temp_c10 / 10, abs(st.temp_c10 % 10));
+}
+
+// Comando 'z': "<zona> <estado>" (ex: "B 20", "A off")
+static void zone_command(void) {
+    char line[16];
+    uint8_t state;
+
+    printf("Zona e estado (off/on/20/22/fan1/fan2): ");
+    if (!read_console_line(line, sizeof(line), 5000)) {
+        return;
+    }
+    if (strlen(line) < 3 || line[1] != ' ' || !parse_state(&line[2], &state)) {
+        printf("Formato invalido\n");
+        return;
+    }
+    uint8_t n = fleet_set_zone(line[0], state, to_ms_since_boot(get_absolute_time()));
+    printf("Zona %c: %u unidades -> %s\n", line[0], n, state_names[state]);
+}
+
+// Comando 'l': lista os perfis; "<emissor> <perfil>" troca na hora e
+// grava a escolha, "apagar" limpa os perfis da flash
+static void profile_command(void) {
+    char line[16];
+    unsigned emitter, profile;
+
+    ac_profile_print();
+    printf("Emissor e perfil (ex: 0 2) ou apagar: ");
+    if (!read_console_line(line, sizeof(line), 5000)) {
+        return;
+    }
+    if (strcmp(line, "apagar") == 0) {
+        printf(ac_profile_erase_all() ? "Perfis apagados\n" : "ERRO: IR ocupado ou flash nao apagada\n");
+        return;
+    }
+    reassert_cancel();          // a fila aponta para os quadros do perfil atual
+    if (sscanf(line, "%u %u", &emitter, &profile) != 2 || emitter >= IR_MAX_EMITTERS || profile > 255 ||
+        !ac_profile_select((uint8_t)emitter, (uint8_t)profile, true)) {
+        printf("Emissor ou perfil invalido\n");
+        return;
+    }
+    printf("Emissor %u: perfil %.12s\n", emitter, ac_profile_get((uint8_t)profile)->name);
+    // Estado atual da unidade principal pode no existir no modelo novo
+    if (emitter == 0 && !ac_profile_supports(0, current_state)) {
+        printf("AVISO: estado %s nao existe neste modelo\n", state_names[current_state]);
+    }
+}
+
+// ===================== REGRAS DE AUTOMAO =====================
+// Ao de uma regra: o mesmo caminho dos botes e do console
+static bool rule_action(uint8_t state) {
+    if (state >= STATE_MAX || state == STATE_TEMP_22 || !ac_profile_supports(0, state)) {
+        printf("Regra: estado %u nao suportado pelo modelo\n", state);
+        return true;                // nada a repetir
+    }
+    if (state == current_state) {
+        return true;
+    }
+    printf("\nRegra -> %s\n", state_names[state]);
+    return execute_ir_command_safe((system_state_t)state);
+}
+
+// Entradas das regras; s as que mudaram marcam regras para reavaliar
+static void rules_tick(uint32_t now_ms) {
+    power_monitor_stats_t pm;
+    power_monitor_get_stats(&pm);
+    if (rule_temp_c10 == INT16_MIN || abs(pm.temp_c10 - rule_temp_c10) >= RULE_TEMP_HYST_C10) {
+        rule_temp_c10 = pm.temp_c10;
+        rule_engine_set_input(RULE_IN_TEMP, rule_temp_c10);
+    }
+    rule_engine_set_input(RULE_IN_IDLE, (int32_t)((now_ms - last_input_ms) / 1000));
+    rule_engine_set_input(RULE_IN_STATE, current_state);
+    rule_engine_poll(now_ms);
+}
+
+// Comando 'e': mostra as regras; "HH:MM" acerta a hora, "apagar" remove
+// o programa (tools/rulec.py gera a linha @RU)
+static void rules_command(void) {
+    char line[16];
+    unsigned hh, mm;
+
+    rule_engine_print();
+    printf("Hora (HH:MM) ou apagar: ");
+    if (!read_console_line(line, sizeof(line), 5000)) {
+        return;
+    }
+    if (strcmp(line, "apagar") == 0) {
+        printf(rule_engine_erase() ? "Regras apagadas\n" : "ERRO: regras nao apagadas\n");
+        return;
+    }
+    if (sscanf(line, "%u:%u", &hh, &mm) != 2 || hh > 23 || mm > 59) {
+        printf("Formato invalido\n");
+        return;
+    }
+    rule_engine_set_clock((uint16_t)(hh * 60 + mm), to_ms_since_boot(get_absolute_time()));
+    printf("Hora acertada: %02u:%02u\n", hh, mm);
+}
+
+#if USB_MSC
+// ===================== DISCO USB =====================
+// STATUS.TXT do disco USB: gerado na IRQ do USB, s l estatsticas
+static size_t usb_status_text(char *buf, size_t max) {
+    power_monitor_stats_t pm;
+    rule_engine_stats_t re;
+    ir_queue_stats_t q;
+    fleet_stats_t fl;
+    power_monitor_get_stats(&pm);
+    rule_engine_get_stats(&re);
+    ir_queue_get_stats(&q);
+    fleet_get_stats(&fl);
+
+    int n = snprintf(buf, max,
+        "IR + WATCHDOG\r\n"
+        "uptime_ms=%lu\r\n"
+        "state=%s\r\n"
+        "vsys_mv=%u\r\nvsys_min_mv=%u\r\n"
+        "chip_temp_c=%d.%d\r\n"
+        "wdt_resets=%lu\r\nlast_fault=0x%02lX\r\n"
+        "ir_submitted=%lu\r\nir_sent=%lu\r\nir_preempted=%lu\r\nir_dropped=%lu\r\n"
+        "fleet_frames=%lu\r\nfleet_failures=%lu\r\nfleet_airtime_us=%lu\r\n"
+        "rules=%u\r\nrules_fired=%lu\r\nclock_set=%u\r\n",
+        (unsigned long)to_ms_since_boot(get_absolute_time()),
+        state_names[current_state],
+        pm.vsys_mv, pm.min_mv,
+        pm.temp_c10 / 10, abs(pm.temp_c10 % 10),
+        (unsigned long)watchdog_hw->scratch[0], (unsigned long)watchdog_hw->scratch[1],
+        (unsigned long)q.submitted, (unsigned long)q.sent,
+        (unsigned long)q.preempted, (unsigned long)q.dropped,
+        (unsigned long)fl.frames, (unsigned long)fl.failures, (unsigned long)fl.airtime_us,
+        re.rules, (unsigned long)re.fired, re.clock_set);
+    return n < 0 ? 0 : (size_t)n;
+}
+#endif
+
 // ===================== PROCESSAMENTO DE UART =====================
 static void process_uart_input() {
-    int ch = getchar_timeout_us(0);
+    int ch = input_trace_getchar(0);
     if (ch == PICO_ERROR_TIMEOUT) {
         return;
     }
+    last_input_ms = to_ms_since_boot(get_absolute_time());
     
     printf("%c\n", ch);
     
@@ -289,8 +1019,76 @@ static void process_uart_input() {
             printf("1-Ligar\n 2-Desligar\n");
             printf("3-22C(FALHA!)\n 4-20C\n");
             printf("5-Fan1\n 6-Fan2\n");
+            printf("c-Config k-Ver config\n");
+            printf("i-Integridade flash v-VSYS u-Display m-Espelho\n");
+            printf("r-Gravar entradas p-Reproduzir l-Perfis AC\n");
+            printf("a-Todos OFF z-Zona f-Frota e-Regras\n");
+            printf("w-Transmissao IR x-Emergencia OFF\n");
             printf("0-Menu\n");
             return;
+        case 'c':
+            config_command();
+            return;
+        case 'k':
+            print_config();
+            return;
+        case 'i':
+            scrubber_print_status();
+            return;
+        case 'v':
+            print_power_status();
+            return;
+        case 'a':
+            printf("Frota: %u unidades -> OFF\n",
+                   fleet_set_all(STATE_OFF, to_ms_since_boot(get_absolute_time())));
+            return;
+        case 'z':
+            zone_command();
+            return;
+        case 'x':
+            emergency_off();
+            return;
+        case 'w':
+            print_ir_tx();
+            return;
+        case 'u':
+            print_ui_stats();
+            return;
+        case 'm':
+            fb_mirror_enable(!fb_mirror_enabled());
+            printf("Espelho do display: %s\n", fb_mirror_enabled() ? "ATIVO" : "desligado");
+            ui_pacer_mark_dirty();      // quadro-chave j
+            return;
+        case 'r':
+        case 'p':
+            input_trace_console(ch);
+            return;
+        case 'l':
+            profile_command();
+            return;
+        case 'e':
+            rules_command();
+            return;
+        case '@':
+            // "@TR ..." = trace de entradas, "@AP ..." = perfil de AC,
+            // "@RU ..." = regras de automao
+            switch (input_trace_getchar(100000)) {
+                case 'A':
+                    ac_profile_load_line();
+                    break;
+                case 'R':
+                    rule_engine_load_line();
+                    break;
+                default:
+                    input_trace_load_line();
+                    break;
+            }
+            return;
+        case 'f':
+            print_fleet();
+            ui_page = (ui_page + 1) % UI_PAGE_COUNT;
+            ui_pacer_mark_dirty();
+            return;
         default:
             return;
     }
@@ -301,11 +1099,33 @@ static void process_uart_input() {
 // ===================== MAIN =====================
 int main() {
     stdio_init_all();
+#if USB_MSC
+    usb_msc_init(usb_status_text);      // disco USB com logs (opo USB_MSC)
+#endif
     sleep_ms(2000);
 
     printf("\n\n=== SISTEMA IR + WATCHDOG ===\n");
     printf("Raspberry Pi Pico - Protocolo IR com Protecao WDT\n\n");
 
+    // 0) Configurao persistente (pinos, timeouts, portadora)
+    if (!kv_store_init()) {
+        printf("AVISO: configuracao em flash indisponivel, usando padroes\n");
+    }
+    load_config();
+
+    // Estado salvo na ltima queda de energia
+    powerfail_log_init();
+    input_trace_init();
+    powerfail_record_t pf;
+    if (powerfail_log_take(&pf)) {
+        printf("Queda de energia anterior: estado %u, uptime %lums, VSYS %umV%s\n",
+               pf.ac_state, (unsigned long)pf.uptime_ms, pf.vsys_mv,
+               (pf.flags & PF_FLAG_IR_ABORTED) ? ", IR abortado" : "");
+        if (pf.ac_state < STATE_MAX) {
+            current_state = (system_state_t)pf.ac_state;
+        }
+    }
+
     // 1) Inicializa GPIOs
     init_gpio();
 
@@ -343,6 +1163,9 @@ int main() {
     } else if (fault == FALHA_TEMP_22C) {
         printf("Ultima falha: Comando 22C (travamento)\n");
     }
+    if (reboot_wdt && wdt_lease_last_overrun() != WDT_LEASE_NONE) {
+        printf("Lease estourado: %s\n", wdt_lease_tag_name(wdt_lease_last_overrun()));
+    }
 
     // 5) Mostra diagnstico no OLED
     show_boot_diag(&ssd, reboot_wdt, count, fault);
@@ -350,7 +1173,8 @@ int main() {
 
     // 6) Inicializa sistema IR
     printf("Inicializando sistema IR...\n");
-    if (!custom_ir_init(IR_PIN)) {
+    custom_ir_set_carrier_freq(cfg.ir_carrier_freq);
+    if (!custom_ir_init(cfg.ir_pin)) {
         printf("ERRO: Falha ao inicializar sistema IR!\n");
         
         while (1) {
@@ -362,10 +1186,40 @@ int main() {
     }
     printf("Sistema IR inicializado com sucesso\n");
 
+    // Verificao de integridade da flash em segundo plano
+    scrubber_init();
+
+    // Monitor de VSYS com gravao de emergncia
+    power_monitor_init(on_power_fail);
+
+    // Fila de transmisso com prioridades
+    ir_queue_init();
+
+    // Perfil de modelo de cada emissor, compilado para os estados
+    ac_profile_init(state_settings, STATE_MAX);
+
+    // Limite de corrente para transmisses simultneas
+    ir_planner_set_budget(IR_SUPPLY_BUDGET_MA);
+    for (uint8_t i = 0; i < custom_ir_emitter_count(); i++) {
+        ir_planner_set_emitter_current(i, IR_LED_CURRENT_MA);
+    }
+
+    // Tabela da frota (protocolo = perfil atual do emissor, comando l)
+    fleet_init();
+    fleet_set_protocol_fn(ac_profile_selected);
+    for (size_t i = 0; i < sizeof(fleet_layout) / sizeof(fleet_layout[0]); i++) {
+        fleet_add_unit(fleet_layout[i].emitter, ac_profile_selected(fleet_layout[i].emitter),
+                       fleet_layout[i].zone);
+    }
+    fleet_set_reassert(cfg.reassert_s * 1000, to_ms_since_boot(get_absolute_time()));
+
+    // Regras de automao gravadas (tools/rulec.py)
+    rule_engine_init(rule_action);
+
     // ===== HABILITA WATCHDOG =====
     // 7) Ativa watchdog com timeout ajustado para operaes IR
-    printf("Habilitando Watchdog (timeout: %dms)...\n", WDT_TIMEOUT_MS);
-    watchdog_enable(WDT_TIMEOUT_MS, true);
+    printf("Habilitando Watchdog (timeout: %lums)...\n", (unsigned long)cfg.wdt_timeout_ms);
+    wdt_lease_init(cfg.wdt_timeout_ms);
     printf("Watchdog ativo!\n\n");
 
     // Mostra menu inicial
@@ -373,10 +1227,25 @@ int main() {
     printf("1-Ligar 2-Desligar\n");
     printf("3-22C(FALHA!) 4-20C\n");
     printf("5-Fan1 6-Fan2\n");
+    printf("c-Config k-Ver config\n");
+    printf("i-Integridade flash v-VSYS u-Display m-Espelho\n");
+    printf("r-Gravar entradas p-Reproduzir l-Perfis AC\n");
+    printf("a-Todos OFF z-Zona f-Frota e-Regras\n");
+    printf("w-Transmissao IR x-Emergencia OFF\n");
     printf("0-Menu\n\n");
 
+    // Trace marcado para o boot (simulador, bancada) tem prioridade
+    if (input_trace_boot_replay()) {
+        input_trace_replay_start();
+    } else if (cfg.trace_rec) {
+        input_trace_record_start();
+    }
+
     // ===== LOOP PRINCIPAL =====
-    absolute_time_t next_display = make_timeout_time_ms(1000);
+    ui_pacer_init(cfg.ui_fps);
+    oled_graph_init(&graph_loop, TREND_X, TREND_WIDTH, 2, 2, 0, 20000, OLED_GRAPH_MAX, true);
+    oled_graph_init(&graph_cmd, TREND_X, TREND_WIDTH, 5, 2, 0, 4, OLED_GRAPH_SUM, true);
+    absolute_time_t next_trend = make_timeout_time_ms(TREND_INTERVAL_MS);
     absolute_time_t next_led = make_timeout_time_ms(500);
     bool led_state = false;
 
@@ -385,10 +1254,14 @@ int main() {
     static uint32_t last_button_b = 0;
 
     while (true) {
+        uint64_t loop_start_us = time_us_64();
         uint32_t current_time = to_ms_since_boot(get_absolute_time());
 
+        // ===== QUEDA DE ENERGIA: registro pedido pela IRQ =====
+        powerfail_log_service();
+
         // ===== DEFEITO 1: GATILHO DE FALHA - BOTO A =====
-        if (gpio_get(BOTAO_A) == 0 && (current_time - last_button_a) > 300) {
+        if (input_trace_button(INPUT_BUTTON_A, gpio_get(BOTAO_A)) == 0 && (current_time - last_button_a) > 300) {
             last_button_a = current_time;
             
             printf("\n!!! FALHA INDUZIDA PELO BOTAO A !!!\n");
@@ -407,10 +1280,15 @@ int main() {
         }
 
         // ===== BOTO B - AVANAR ESTADO DO AC =====
-        if (gpio_get(BOTAO_B) == 0 && (current_time - last_button_b) > 300) {
+        if (input_trace_button(INPUT_BUTTON_B, gpio_get(BOTAO_B)) == 0 && (current_time - last_button_b) > 300) {
             last_button_b = current_time;
+            last_input_ms = current_time;
             
-            system_state_t new_state = (current_state + 1) % STATE_MAX;
+            // S os estados que o modelo do emissor 0 entende
+            system_state_t new_state = current_state;
+            do {
+                new_state = (new_state + 1) % STATE_MAX;
+            } while (new_state != current_state && !ac_profile_supports(0, new_state));
             printf("\nBotao B pressionado - mudando para estado %d\n", new_state);
             execute_ir_command_safe(new_state);
         }
@@ -418,6 +1296,31 @@ int main() {
         // ===== PROCESSA COMANDOS UART =====
         process_uart_input();
 
+        // ===== FILA IR (quadros assncronos) =====
+        ir_queue_poll();
+
+        // ===== REGRAS (s as afetadas por entradas novas) =====
+        rules_tick(current_time);
+
+        // ===== FROTA: TRANSMISSES PENDENTES =====
+        if (fleet_pending()) {
+            fleet_flush_batch(fleet_send_batch, current_time);
+            if (ui_page == UI_PAGE_FLEET) {
+                ui_pacer_mark_dirty();
+            }
+            const fleet_unit_t *main_unit = fleet_get(0);
+            if (main_unit && main_unit->sent < STATE_MAX) {
+                current_state = (system_state_t)main_unit->sent;
+            }
+        }
+
+        // ===== FROTA: REAFIRMAO (uma unidade por fatia, classe de fundo) =====
+        reassert_poll(current_time);
+        fleet_reassert(reassert_send, current_time);
+
+        // ===== VERIFICAO DE INTEGRIDADE (um pedao por iterao) =====
+        scrubber_poll();
+
         // ===== LED DE HEARTBEAT (operao normal) =====
         if (absolute_time_diff_us(get_absolute_time(), next_led) <= 0) {
             led_state = !led_state;
@@ -425,23 +1328,52 @@ int main() {
             next_led = make_timeout_time_ms(500);
         }
 
-        // ===== ATUALIZA DISPLAY PERIODICAMENTE =====
-        if (absolute_time_diff_us(get_absolute_time(), next_display) <= 0 || 
-            last_display_state != current_state) {
-            
-            show_running_state(&ssd, current_state);
+        // ===== ATUALIZA DISPLAY (s com mudana, no mximo ui_fps) =====
+        if (last_display_state != current_state) {
             last_display_state = current_state;
-            next_display = make_timeout_time_ms(1000);
-            
-            // Feed adicional aps atualizar display (I2C pode demorar)
-            watchdog_update();
+            ui_pacer_mark_dirty();
+        }
+        if (absolute_time_diff_us(get_absolute_time(), next_trend) <= 0) {
+            trends_tick(&ssd);
+            next_trend = delayed_by_ms(next_trend, TREND_INTERVAL_MS);
+        }
+        ui_frame_t frame;
+        if (ui_pacer_begin_frame(&frame)) {
+            // I2C pode demorar: lease s durante o flush
+            bool leased = wdt_lease_begin(LEASE_DISPLAY_MS, WDT_LEASE_DISPLAY);
+            bool shown;
+            if (!frame.full) {
+                // Retngulo j atualizado no buffer (grficos)
+                shown = display_bus_flush_rect(&ssd, frame.x0, frame.x1, frame.p0, frame.p1);
+            } else if (ui_page == UI_PAGE_FLEET) {
+                shown = show_fleet_state(&ssd);
+            } else if (ui_page == UI_PAGE_TRENDS) {
+                shown = show_trends(&ssd);
+            } else {
+                shown = show_running_state(&ssd, current_state);
+            }
+            if (leased) {
+                wdt_lease_end();
+            }
+            ui_pacer_end_frame();
+            if (!shown) {
+                ui_pacer_mark_dirty();      // quadro perdido: tenta no prximo
+            }
+        }
+
+        // ===== GRAVAES DO SCRUBBER (s com o IR parado) =====
+        if (!custom_ir_any_busy() && ir_queue_idle()) {
+            scrubber_commit();
         }
 
         // ===== FEED DO WATCHDOG - PONTO ESTRATGICO =====
         // Este  o ponto crtico: se o cdigo travar em qualquer lugar
         // acima (IR, I2C, processamento), o watchdog no ser alimentado
         // e o sistema resetar automaticamente
-        watchdog_update();
+        wdt_lease_feed();
+
+        // Tempo de trabalho do loop (sem a pausa abaixo)
+        oled_graph_sample(&graph_loop, (int32_t)(time_us_64() - loop_start_us));
 
         // Pequena pausa para no sobrecarregar
         sleep_ms(10);
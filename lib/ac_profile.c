@@ -0,0 +1,490 @@
+/**
+ * Perfis de modelo de AC
+ * Perfil 0 embutido (tabelas RAW) + perfis em flash, compilados por emissor
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "hex_line.h"
+#include "input_trace.h"
+#include "kv_store.h"
+#include "ir_queue.h"
+#include "power_monitor.h"
+#include "wdt_lease.h"
+#include "ac_profile.h"
+
+#define PROFILE_ERASE_LEASE_MS  1000
+#define PROFILE_MAX_TIMINGS     (2 + AC_PROFILE_MAX_FRAME * 8 * 2 + 1)
+
+_Static_assert(AC_PROFILE_MAX_STATES <= 16, "estado nao cabe nos 4 bits da chave da cache");
+_Static_assert(PROFILE_MAX_TIMINGS <= IR_MAX_FRAME_TIMINGS, "quadro de perfil maior que o do transmissor");
+
+// Modelo original: só os estados que as tabelas RAW gravadas cobrem
+static const ac_profile_def_t builtin_profile = {
+    .magic = AC_PROFILE_MAGIC,
+    .name = "ORIGINAL",
+    .protocol = AC_PROTO_RAW,
+    .modes = (1u << AC_MODE_COOL) | (1u << AC_MODE_FAN),
+    .fans = (1u << AC_FAN_AUTO) | (1u << 1) | (1u << 2),
+    .repeat = 1,
+    .temp_min = 20,
+    .temp_max = 22,
+    .temp_default = 22,
+};
+
+static const ac_setting_t *app_states;
+static uint8_t state_count;
+
+static bool slot_valid[AC_PROFILE_FLASH_SLOTS];
+static uint8_t selected[IR_MAX_EMITTERS];
+static uint32_t default_carrier[IR_MAX_EMITTERS];
+static ac_compiled_t compiled[IR_MAX_EMITTERS];
+
+// Timings dos perfis em flash já codificados (os RAW apontam para a tabela)
+static uint16_t pool[AC_PROFILE_POOL_WORDS];
+static uint16_t pool_used;
+
+static uint8_t page_buf[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+
+static const ac_profile_def_t *slot_ptr(uint8_t slot) {
+    return (const ac_profile_def_t *)FLASH_XIP_PTR(FLASH_PROFILE_OFFSET + slot * FLASH_PAGE_SIZE);
+}
+
+static bool erase_sector(void) {
+    if (!power_monitor_flash_ok()) {
+        return false;
+    }
+    bool leased = wdt_lease_begin(PROFILE_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(FLASH_PROFILE_OFFSET, FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+    return true;
+}
+
+static bool field_ok(const ac_profile_def_t *p, const ac_field_t *f) {
+    return f->width == 0 || (f->byte < p->frame_len && f->shift + f->width <= 8);
+}
+
+// Confere o registro inteiro uma vez; depois disso a compilação confia nele
+static bool def_ok(const ac_profile_def_t *p) {
+    if (p->magic != AC_PROFILE_MAGIC ||
+        p->crc != crc32_compute(p, offsetof(ac_profile_def_t, crc))) {
+        return false;
+    }
+    return p->protocol == AC_PROTO_PULSE_DISTANCE &&
+           p->frame_len > 0 && p->frame_len <= AC_PROFILE_MAX_FRAME &&
+           p->repeat <= AC_PROFILE_MAX_REPEAT && p->gap_ms <= AC_PROFILE_MAX_GAP_MS &&
+           p->bit_mark_us > 0 && p->one_space_us > 0 && p->zero_space_us > 0 &&
+           (p->checksum == AC_SUM_NONE ||
+            (p->checksum <= AC_SUM_NIBBLES && p->checksum_byte < p->frame_len &&
+             p->checksum_from <= p->checksum_byte)) &&
+           (p->carrier_hz == 0 ||
+            (p->carrier_hz >= IR_CARRIER_MIN_HZ && p->carrier_hz <= IR_CARRIER_MAX_HZ)) &&
+           p->temp_min <= p->temp_max &&
+           field_ok(p, &p->power) && field_ok(p, &p->mode) &&
+           field_ok(p, &p->temp) && field_ok(p, &p->fan);
+}
+
+const ac_profile_def_t *ac_profile_get(uint8_t profile) {
+    if (profile == 0) {
+        return &builtin_profile;
+    }
+    if (profile > AC_PROFILE_FLASH_SLOTS || !slot_valid[profile - 1]) {
+        return NULL;
+    }
+    return slot_ptr(profile - 1);
+}
+
+// ============================================================================
+// CODIFICAÇÃO
+// ============================================================================
+
+static bool setting_supported(const ac_profile_def_t *p, const ac_setting_t *s) {
+    if (!s->power) {
+        return p->protocol == AC_PROTO_RAW || p->power.width > 0;
+    }
+    int temp = s->temp_c ? s->temp_c : p->temp_default;
+    return s->mode < AC_MODE_COUNT && (p->modes & (1u << s->mode)) &&
+           s->fan < AC_FAN_COUNT && (p->fans & (1u << s->fan)) &&
+           temp >= p->temp_min && temp <= p->temp_max;
+}
+
+// Estado -> comando das tabelas RAW do modelo original
+static ir_command_id_t raw_command(const ac_setting_t *s) {
+    if (!s->power) return IR_CMD_OFF;
+    if (s->temp_c == 20) return IR_CMD_TEMP_20;
+    if (s->temp_c == 22) return IR_CMD_TEMP_22;
+    if (s->fan == 1) return IR_CMD_FAN_1;
+    if (s->fan == 2) return IR_CMD_FAN_2;
+    return IR_CMD_ON;
+}
+
+static void put_field(uint8_t *frame, const ac_field_t *f, uint8_t value) {
+    if (f->width == 0) return;
+    uint8_t mask = (uint8_t)(((1u << f->width) - 1) << f->shift);
+    frame[f->byte] = (uint8_t)((frame[f->byte] & ~mask) | ((value << f->shift) & mask));
+}
+
+static void apply_checksum(const ac_profile_def_t *p, uint8_t *frame) {
+    uint8_t sum = 0;
+    for (uint8_t i = p->checksum_from; i < p->checksum_byte; i++) {
+        switch (p->checksum) {
+            case AC_SUM_BYTES:   sum += frame[i]; break;
+            case AC_SUM_XOR:     sum ^= frame[i]; break;
+            case AC_SUM_NIBBLES: sum += (frame[i] & 0x0F) + (frame[i] >> 4); break;
+            default: return;
+        }
+    }
+    if (p->checksum == AC_SUM_NIBBLES) {
+        frame[p->checksum_byte] = (uint8_t)((frame[p->checksum_byte] & 0xF0) | (sum & 0x0F));
+    } else if (p->checksum != AC_SUM_NONE) {
+        frame[p->checksum_byte] = sum;
+    }
+}
+
+static void encode_frame(const ac_profile_def_t *p, const ac_setting_t *s, uint8_t *frame) {
+    memcpy(frame, p->frame, p->frame_len);
+    put_field(frame, &p->power, s->power ? 1 : 0);
+    if (s->power) {
+        int temp = s->temp_c ? s->temp_c : p->temp_default;
+        put_field(frame, &p->mode, p->mode_codes[s->mode]);
+        put_field(frame, &p->temp, (uint8_t)(temp - p->temp_offset));
+        put_field(frame, &p->fan, p->fan_codes[s->fan]);
+    }
+    apply_checksum(p, frame);
+}
+
+// Bytes -> timings marca/espaço (começa e termina em marca)
+static uint16_t frame_timings(const ac_profile_def_t *p, const uint8_t *frame, uint16_t *out) {
+    uint16_t n = 0;
+    if (p->hdr_mark_us) {
+        out[n++] = p->hdr_mark_us;
+        out[n++] = p->hdr_space_us;
+    }
+    for (uint8_t i = 0; i < p->frame_len; i++) {
+        for (uint8_t b = 0; b < 8; b++) {
+            bool one = (frame[i] >> (p->lsb_first ? b : 7 - b)) & 1;
+            out[n++] = p->bit_mark_us;
+            out[n++] = one ? p->one_space_us : p->zero_space_us;
+        }
+    }
+    out[n++] = p->trail_mark_us ? p->trail_mark_us : p->bit_mark_us;
+    return n;
+}
+
+static bool compile(ac_compiled_t *c, uint8_t profile) {
+    const ac_profile_def_t *p = ac_profile_get(profile);
+    memset(c, 0, sizeof(*c));
+    c->profile = profile;
+    c->repeat = p->repeat ? p->repeat : 1;
+    c->gap_ms = p->gap_ms;
+    c->carrier_hz = p->carrier_hz;
+
+    for (uint8_t s = 0; s < state_count; s++) {
+        ac_frame_t *f = &c->frames[s];
+        f->cmd = IR_CMD_COUNT;
+        if (!setting_supported(p, &app_states[s])) {
+            continue;
+        }
+        if (p->protocol == AC_PROTO_RAW) {
+            ir_command_id_t cmd = raw_command(&app_states[s]);
+            size_t length;
+            if (custom_ir_get_command(cmd, &f->timings, &length, NULL)) {
+                f->length = (uint16_t)length;
+                f->cmd = (uint8_t)cmd;
+                f->key = IR_CMD_CACHE_KEY(cmd);
+            }
+            continue;
+        }
+        if (pool_used + PROFILE_MAX_TIMINGS > AC_PROFILE_POOL_WORDS) {
+            return false;
+        }
+        uint8_t frame[AC_PROFILE_MAX_FRAME];
+        encode_frame(p, &app_states[s], frame);
+        f->timings = &pool[pool_used];
+        f->length = frame_timings(p, frame, &pool[pool_used]);
+        f->key = AC_PROFILE_CACHE_KEY(p->crc, s);
+        pool_used += f->length;
+    }
+    return true;
+}
+
+// Recompila tudo; emissores com o mesmo perfil dividem os timings.
+// Move timings que quadros no ar ou na fila podem estar usando: só com o IR parado
+static bool rebuild(void) {
+    pool_used = 0;
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        uint8_t prev = 0;
+        while (prev < e && selected[prev] != selected[e]) prev++;
+        if (prev < e) {
+            compiled[e] = compiled[prev];
+        } else if (!compile(&compiled[e], selected[e])) {
+            printf("ERRO: perfil %.12s nao cabe no pool de timings\n", ac_profile_get(selected[e])->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ir_idle(void) {
+    return !custom_ir_any_busy() && ir_queue_idle();
+}
+
+// Compila só o emissor alterado, na parte livre do pool: os timings dos
+// outros emissores não saem do lugar. Sem espaço, compacta tudo
+static bool compile_emitter(uint8_t emitter) {
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        if (e != emitter && selected[e] == selected[emitter]) {
+            compiled[emitter] = compiled[e];
+            return true;
+        }
+    }
+    uint16_t mark = pool_used;
+    ac_compiled_t c;
+    if (compile(&c, selected[emitter])) {
+        compiled[emitter] = c;
+        return true;
+    }
+    pool_used = mark;
+    return rebuild();
+}
+
+// ============================================================================
+// SELEÇÃO E ENVIO
+// ============================================================================
+
+void ac_profile_init(const ac_setting_t *states, uint8_t count) {
+    app_states = states;
+    state_count = count < AC_PROFILE_MAX_STATES ? count : AC_PROFILE_MAX_STATES;
+
+    uint8_t loaded = 0;
+    for (uint8_t i = 0; i < AC_PROFILE_FLASH_SLOTS; i++) {
+        slot_valid[i] = def_ok(slot_ptr(i));
+        loaded += slot_valid[i];
+    }
+    // Nenhum perfil válido e setor não apagado (restos de outra imagem ou
+    // só slots anulados): formatar não perde nada
+    if (loaded == 0 && slot_ptr(0)->magic != 0xFFFFFFFFu) {
+        printf("Perfis de AC: setor sem perfis validos, formatando\n");
+        erase_sector();
+    }
+
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        default_carrier[e] = custom_ir_emitter_carrier(e);
+        uint32_t profile = kv_get_or(KV_KEY_AC_PROFILE_BASE + e, 0);
+        selected[e] = (profile < AC_PROFILE_COUNT && ac_profile_get((uint8_t)profile))
+                    ? (uint8_t)profile : 0;
+        if (selected[e] != profile) {
+            printf("AVISO: perfil %lu do emissor %u ausente, usando ORIGINAL\n",
+                   (unsigned long)profile, e);
+        }
+        const ac_profile_def_t *p = ac_profile_get(selected[e]);
+        if (p->carrier_hz) {
+            custom_ir_set_emitter_carrier(e, p->carrier_hz);
+        }
+    }
+    if (!rebuild()) {
+        // Pool estourado: todos voltam ao modelo original (não usa pool)
+        memset(selected, 0, sizeof(selected));
+        rebuild();
+    }
+    printf("Perfis de AC: %u na flash, pool %u/%u timings\n",
+           loaded, pool_used, AC_PROFILE_POOL_WORDS);
+}
+
+bool ac_profile_select(uint8_t emitter, uint8_t profile, bool persist) {
+    const ac_profile_def_t *p = profile < AC_PROFILE_COUNT ? ac_profile_get(profile) : NULL;
+    // Fila e quadros no ar de qualquer emissor apontam para o pool
+    if (emitter >= custom_ir_emitter_count() || !p || !ir_idle()) {
+        return false;
+    }
+    uint8_t old = selected[emitter];
+    selected[emitter] = profile;
+    if (!compile_emitter(emitter)) {
+        selected[emitter] = old;
+        rebuild();
+        return false;
+    }
+    custom_ir_set_emitter_carrier(emitter, p->carrier_hz ? p->carrier_hz : default_carrier[emitter]);
+    if (persist) {
+        kv_set(KV_KEY_AC_PROFILE_BASE + emitter, profile);
+    }
+    return true;
+}
+
+uint8_t ac_profile_selected(uint8_t emitter) {
+    return emitter < IR_MAX_EMITTERS ? selected[emitter] : 0;
+}
+
+const ac_compiled_t *ac_profile_compiled(uint8_t emitter) {
+    return emitter < IR_MAX_EMITTERS ? &compiled[emitter] : NULL;
+}
+
+const ac_frame_t *ac_profile_frame(uint8_t emitter, uint8_t state) {
+    if (emitter >= IR_MAX_EMITTERS || state >= state_count) {
+        return NULL;
+    }
+    const ac_frame_t *f = &compiled[emitter].frames[state];
+    if (!f->timings || (f->cmd < IR_CMD_COUNT && !custom_ir_command_enabled(f->cmd))) {
+        return NULL;
+    }
+    return f;
+}
+
+bool ac_profile_supports(uint8_t emitter, uint8_t state) {
+    return ac_profile_frame(emitter, state) != NULL;
+}
+
+bool ac_profile_send(uint8_t emitter, uint8_t state) {
+    const ac_frame_t *f = ac_profile_frame(emitter, state);
+    if (!f) {
+        printf("ERRO: perfil do emissor %u nao suporta o estado %u\n", emitter, state);
+        return false;
+    }
+    ir_queue_item_t item = {
+        .emitter = emitter,
+        .prio = IR_PRIO_USER,
+        .key = f->key,
+        .signal = f->timings,
+        .length = f->length,
+        .repeat = compiled[emitter].repeat,
+        .gap_ms = compiled[emitter].gap_ms,
+    };
+    if (!ir_queue_submit(&item)) {
+        printf("ERRO: fila IR cheia\n");
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// FLASH
+// ============================================================================
+
+static void program_page(uint8_t slot) {
+    bool leased = wdt_lease_begin(PROFILE_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(FLASH_PROFILE_OFFSET + slot * FLASH_PAGE_SIZE, page_buf, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+}
+
+bool ac_profile_load_line(void) {
+    absolute_time_t deadline = make_timeout_time_ms(AC_PROFILE_LOAD_MS);
+    hex_line_t line;
+
+    memset(page_buf, 0xFF, sizeof(page_buf));
+    hex_line_begin(&line, page_buf, sizeof(ac_profile_def_t), "P ");
+    bool leased = wdt_lease_begin(AC_PROFILE_LOAD_MS + 100, WDT_LEASE_CONSOLE);
+    while (!time_reached(deadline)) {
+        int ch = input_trace_getchar(1000);
+        if (ch == PICO_ERROR_TIMEOUT) {
+            continue;
+        }
+        if (!hex_line_feed(&line, ch)) {
+            break;
+        }
+    }
+    if (leased) {
+        wdt_lease_end();
+    }
+
+    const ac_profile_def_t *def = (const ac_profile_def_t *)page_buf;
+    if (!line.ok || line.length != sizeof(ac_profile_def_t) || !def_ok(def)) {
+        printf("Perfil: linha @AP invalida (%u bytes)\n", (unsigned)line.length);
+        return false;
+    }
+
+    // Slots são gravados uma vez: substituir = gravar em outro e anular o antigo
+    int free_slot = -1, old_slot = -1;
+    for (uint8_t i = 0; i < AC_PROFILE_FLASH_SLOTS; i++) {
+        const ac_profile_def_t *p = slot_ptr(i);
+        if (free_slot < 0 && p->magic == 0xFFFFFFFFu) {
+            free_slot = i;
+        } else if (slot_valid[i] && strncmp(p->name, def->name, AC_PROFILE_NAME_LEN) == 0) {
+            old_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        printf("ERRO: setor de perfis cheio (comando l -> apagar)\n");
+        return false;
+    }
+    program_page((uint8_t)free_slot);
+    slot_valid[free_slot] = def_ok(slot_ptr((uint8_t)free_slot));
+    if (!slot_valid[free_slot]) {
+        printf("ERRO: falha ao gravar o perfil na flash\n");
+        return false;
+    }
+    printf("Perfil %.12s gravado como P%d\n", def->name, free_slot + 1);
+
+    if (old_slot >= 0) {
+        memset(page_buf, 0xFF, sizeof(page_buf));
+        memset(page_buf, 0, sizeof(uint32_t));      // magic = 0 (1 -> 0 sem apagar)
+        program_page((uint8_t)old_slot);
+        slot_valid[old_slot] = false;
+        for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+            if (selected[e] == old_slot + 1) {
+                ac_profile_select(e, (uint8_t)(free_slot + 1), true);
+                printf("Emissor %u: P%d -> P%d\n", e, old_slot + 1, free_slot + 1);
+            }
+        }
+    }
+    return true;
+}
+
+bool ac_profile_erase_all(void) {
+    if (!ir_idle() || !erase_sector()) {
+        return false;
+    }
+    memset(slot_valid, 0, sizeof(slot_valid));
+    custom_ir_cache_flush();
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        if (selected[e] != 0) {
+            ac_profile_select(e, 0, true);
+        }
+    }
+    return true;
+}
+
+void ac_profile_print(void) {
+    static const char mode_chars[AC_MODE_COUNT] = { 'A', 'C', 'H', 'D', 'F' };
+
+    printf("\n=== PERFIS DE AC ===\n");
+    for (uint8_t i = 0; i < AC_PROFILE_COUNT; i++) {
+        const ac_profile_def_t *p = ac_profile_get(i);
+        if (!p) continue;
+
+        char modes[AC_MODE_COUNT + 1];
+        for (uint8_t m = 0; m < AC_MODE_COUNT; m++) {
+            modes[m] = (p->modes & (1u << m)) ? mode_chars[m] : '-';
+        }
+        modes[AC_MODE_COUNT] = '\0';
+        char carrier[16] = "padrao";
+        if (p->carrier_hz) {
+            snprintf(carrier, sizeof(carrier), "%luHz", (unsigned long)p->carrier_hz);
+        }
+        printf("P%-2u %-12.12s %s %-7s modos %s %d-%dC x%u gap %ums\n",
+               i, p->name, p->protocol == AC_PROTO_RAW ? "RAW  " : "PDIST",
+               carrier, modes, p->temp_min, p->temp_max,
+               p->repeat ? p->repeat : 1, p->gap_ms);
+    }
+    for (uint8_t e = 0; e < custom_ir_emitter_count(); e++) {
+        uint8_t supported = 0;
+        for (uint8_t s = 0; s < state_count; s++) {
+            supported += ac_profile_supports(e, s);
+        }
+        printf("Emissor %u: P%u, %luHz, %u/%u estados\n", e, selected[e],
+               (unsigned long)custom_ir_emitter_carrier(e), supported, state_count);
+    }
+    printf("Pool: %u/%u timings\n", pool_used, AC_PROFILE_POOL_WORDS);
+}
@@ -0,0 +1,189 @@
+/**
+ * ac_profile.h
+ * Perfis de modelo de AC: capacidades, layout do quadro e temporização
+ *
+ * Cada perfil descreve um modelo: protocolo, portadora, modos e faixa de
+ * temperatura suportados, quadro-modelo com a posição de cada campo
+ * (liga/desliga, modo, temperatura, ventilação), regra de checksum e
+ * intervalo entre quadros. O perfil 0 é o modelo original (tabelas RAW
+ * de custom_ir); os demais ficam em um setor de flash e chegam pelo
+ * console como linha "@AP <hex>" (tools/ac_profile.py gera a linha).
+ *
+ * Cada emissor tem um perfil ativo. Ao selecionar, o perfil é compilado:
+ * os estados da aplicação viram timings prontos em RAM e a portadora do
+ * emissor é ajustada. O envio só indexa a tabela compilada, sem ler o
+ * perfil de novo.
+ */
+
+#ifndef AC_PROFILE_H
+#define AC_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "custom_ir.h"
+
+#define AC_PROFILE_MAGIC        0x31504341u   // "ACP1"
+#define AC_PROFILE_NAME_LEN     12
+#define AC_PROFILE_MAX_FRAME    16            // bytes por quadro
+#define AC_PROFILE_MAX_STATES   8             // estados da aplicação
+#define AC_PROFILE_FLASH_SLOTS  16            // uma página por perfil
+#define AC_PROFILE_COUNT        (1 + AC_PROFILE_FLASH_SLOTS)
+#define AC_PROFILE_POOL_WORDS   2048          // timings compilados (todos os emissores)
+#define AC_PROFILE_LOAD_MS      5000          // prazo para colar uma linha @AP
+#define AC_PROFILE_MAX_REPEAT   4             // quadros por comando
+#define AC_PROFILE_MAX_GAP_MS   200           // pausa entre repetições
+
+// Chaves da cache de formas de onda dos perfis em flash: vêm do CRC do
+// registro, não do slot, para um perfil novo no mesmo slot (depois de
+// 'l' apagar o setor) não achar as formas de onda do antigo
+#define AC_PROFILE_CACHE_KEY(crc, state) \
+    (0x40000000u | ((uint32_t)(crc) & 0x3FFFFFF0u) | (uint32_t)(state))
+
+typedef enum {
+    AC_PROTO_RAW = 0,           // tabelas RAW gravadas (modelo original)
+    AC_PROTO_PULSE_DISTANCE,    // marca fixa, espaço longo = 1
+} ac_protocol_t;
+
+typedef enum {
+    AC_MODE_AUTO = 0,
+    AC_MODE_COOL,
+    AC_MODE_HEAT,
+    AC_MODE_DRY,
+    AC_MODE_FAN,
+    AC_MODE_COUNT
+} ac_mode_t;
+
+#define AC_FAN_AUTO             0
+#define AC_FAN_COUNT            4             // automático + 3 níveis
+
+typedef enum {
+    AC_SUM_NONE = 0,
+    AC_SUM_BYTES,               // soma dos bytes (mod 256)
+    AC_SUM_XOR,                 // XOR dos bytes
+    AC_SUM_NIBBLES,             // soma dos nibbles no nibble baixo
+} ac_checksum_t;
+
+// Campo de bits dentro do quadro
+typedef struct {
+    uint8_t byte;
+    uint8_t shift;              // bit menos significativo
+    uint8_t width;              // 0 = o modelo não tem o campo
+    uint8_t reserved;
+} ac_field_t;
+
+// Registro em flash (92 bytes, little-endian; mesmo layout em ac_profile.py)
+typedef struct {
+    uint32_t magic;
+    char name[AC_PROFILE_NAME_LEN];
+    uint8_t protocol;           // ac_protocol_t
+    uint8_t modes;              // bit n = ac_mode_t n suportado
+    uint8_t fans;               // bit n = nível n suportado
+    uint8_t repeat;             // quadros por comando (até AC_PROFILE_MAX_REPEAT)
+    int8_t temp_min;
+    int8_t temp_max;
+    uint8_t temp_default;       // estados sem temperatura própria
+    uint8_t lsb_first;
+    uint32_t carrier_hz;        // 0 = portadora configurada no emissor
+    uint16_t gap_ms;            // entre repetições (até AC_PROFILE_MAX_GAP_MS)
+    uint16_t hdr_mark_us;       // 0 = sem cabeçalho
+    uint16_t hdr_space_us;
+    uint16_t bit_mark_us;
+    uint16_t one_space_us;
+    uint16_t zero_space_us;
+    uint16_t trail_mark_us;     // 0 = bit_mark_us
+    uint8_t frame_len;
+    uint8_t checksum;           // ac_checksum_t
+    uint8_t checksum_byte;      // onde gravar o checksum
+    uint8_t checksum_from;      // primeiro byte somado (até checksum_byte - 1)
+    uint8_t frame[AC_PROFILE_MAX_FRAME];    // quadro-modelo
+    ac_field_t power;
+    ac_field_t mode;
+    ac_field_t temp;
+    ac_field_t fan;
+    uint8_t mode_codes[AC_MODE_COUNT];
+    uint8_t fan_codes[AC_FAN_COUNT];
+    uint8_t temp_offset;        // campo = temperatura - offset
+    uint32_t crc;               // CRC32 dos bytes anteriores
+} ac_profile_def_t;
+
+// O que um estado da aplicação significa para o aparelho
+typedef struct {
+    bool power;
+    uint8_t mode;               // ac_mode_t
+    int8_t temp_c;              // 0 = temp_default do perfil
+    uint8_t fan;                // 0 = automático
+} ac_setting_t;
+
+// Quadro compilado de um estado
+typedef struct {
+    const uint16_t *timings;    // NULL = estado não suportado pelo modelo
+    uint16_t length;
+    uint8_t cmd;                // ir_command_id_t no perfil RAW, senão IR_CMD_COUNT
+    uint32_t key;               // chave da cache de formas de onda
+} ac_frame_t;
+
+typedef struct {
+    uint8_t profile;
+    uint8_t repeat;
+    uint16_t gap_ms;
+    uint32_t carrier_hz;
+    ac_frame_t frames[AC_PROFILE_MAX_STATES];
+} ac_compiled_t;
+
+/**
+ * Lê os perfis da flash e compila o perfil gravado de cada emissor
+ * (chamar depois de custom_ir_init, kv_store_init e dos emissores extras)
+ * @param states Significado de cada estado da aplicação
+ * @param count Número de estados (até AC_PROFILE_MAX_STATES)
+ */
+void ac_profile_init(const ac_setting_t *states, uint8_t count);
+
+/**
+ * @return Perfil do índice, ou NULL se o slot está vazio
+ */
+const ac_profile_def_t *ac_profile_get(uint8_t profile);
+
+/**
+ * Seleciona e compila o perfil de um emissor
+ * @param persist Grava a escolha no kv_store
+ * @return false se o perfil não existe, não cabe no pool ou há quadros
+ *         no ar ou na fila de qualquer emissor (a seleção anterior continua valendo)
+ */
+bool ac_profile_select(uint8_t emitter, uint8_t profile, bool persist);
+
+uint8_t ac_profile_selected(uint8_t emitter);
+const ac_compiled_t *ac_profile_compiled(uint8_t emitter);
+
+/**
+ * Quadro pronto de um estado no emissor
+ * @return NULL se o modelo não suporta o estado ou a tabela RAW foi
+ *         desabilitada pelo verificador de integridade
+ */
+const ac_frame_t *ac_profile_frame(uint8_t emitter, uint8_t state);
+
+bool ac_profile_supports(uint8_t emitter, uint8_t state);
+
+/**
+ * Põe o estado na fila IR, classe de usuário, com as repetições e a pausa
+ * do perfil (não espera a transmissão)
+ * @return false se o estado não é suportado ou a fila recusou
+ */
+bool ac_profile_send(uint8_t emitter, uint8_t state);
+
+/**
+ * Lê uma linha "AP <hex>" (o '@' e o 'A' já foram lidos) e grava o perfil
+ * na flash; um perfil com o mesmo nome é substituído e os emissores que
+ * o usavam passam para o novo
+ * @return false se a linha é inválida ou o setor está cheio
+ */
+bool ac_profile_load_line(void);
+
+/**
+ * Apaga todos os perfis da flash; os emissores voltam ao perfil 0
+ * @return false se há quadros no ar ou na fila
+ */
+bool ac_profile_erase_all(void);
+
+void ac_profile_print(void);
+
+#endif // AC_PROFILE_H
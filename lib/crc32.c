@@ -0,0 +1,23 @@
+/**
+ * CRC-32 por software com tabela de nibbles (64 bytes em flash)
+ */
+
+#include "crc32.h"
+
+static const uint32_t crc32_nibble_table[16] = {
+    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
+    0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
+    0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+};
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len--) {
+        crc ^= (uint32_t)(*p++) << 24;
+        crc = (crc << 4) ^ crc32_nibble_table[crc >> 28];
+        crc = (crc << 4) ^ crc32_nibble_table[crc >> 28];
+    }
+    return crc;
+}
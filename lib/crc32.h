@@ -0,0 +1,32 @@
+/**
+ * crc32.h
+ * CRC-32 (polinômio 0x04C11DB7, MSB primeiro, sem XOR final)
+ *
+ * Mesmo cálculo do sniffer de DMA do RP2040 no modo CRC32 com
+ * transferências de 8 bits e semente 0xFFFFFFFF, para que valores
+ * calculados por software e por hardware sejam comparáveis.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CRC32_INIT 0xFFFFFFFFu
+
+/**
+ * Acumula 'len' bytes no CRC
+ * @param crc Valor anterior (CRC32_INIT no início)
+ * @return CRC atualizado
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/**
+ * CRC de um bloco completo
+ */
+static inline uint32_t crc32_compute(const void *data, size_t len) {
+    return crc32_update(CRC32_INIT, data, len);
+}
+
+#endif // CRC32_H
@@ -3,25 +3,125 @@
  * Verso SIMPLES - baseada no exemplo de fade com DMA
  */
 
+#include <string.h>
 #include "pico/stdlib.h"
 #include "stdio.h"
 #include "hardware/pwm.h"
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hw_config.h"
+#include "custom_ir.h"
 
-// Definies
-#define IR_CARRIER_FREQ 38000
+// Ciclos de portadora entre ligar o slice e o primeiro nvel no pino
+// (wrap -> DREQ -> escrita no CC -> CC carregado no wrap seguinte)
+#define IR_ARM_LEAD_PERIODS 2
+// Incios at esse tanto no futuro saem no mesmo disparo do alarme
+#define IR_ARM_SLACK_US 1
+
+// O wrap do PWM (clkdiv 1) precisa caber no contador de 16 bits em toda a
+// faixa de portadoras, e o meio (duty de 50%) no pode ser zero
+_Static_assert(HW_PWM_WRAP(IR_CARRIER_MIN_HZ) <= UINT16_MAX, "portadora minima baixa demais");
+_Static_assert(HW_PWM_WRAP(IR_CARRIER_MAX_HZ) >= 2, "portadora maxima alta demais");
+_Static_assert(IR_CARRIER_FREQ >= IR_CARRIER_MIN_HZ && IR_CARRIER_FREQ <= IR_CARRIER_MAX_HZ,
+               "IR_CARRIER_FREQ fora da faixa");
+
+typedef enum {
+    IR_TX_IDLE,
+    IR_TX_ARMED,        // DMA pronto, slice parado at o alarme
+    IR_TX_RUNNING
+} ir_tx_state_t;
+
+#if !IR_BACKEND_EDGE
+// Trecho do quadro (uma marca ou um espao) para o DMA: o canal de controle
+// copia cada bloco nos registradores do alias 3 do canal de dados (contagem
+// e endereo de leitura, que dispara). O canal de dados escreve o mesmo
+// nvel no CC a cada wrap, 'count' vezes; o bloco nulo no fim gera a IRQ
+typedef struct {
+    uint32_t count;                 // ciclos de portadora
+    const volatile void *level;     // &level_on do emissor ou &ir_level_off
+} ir_run_block_t;
+
+// Um bloco = um disparo do canal de controle, com anel de escrita do tamanho
+// do bloco (mesmo layout de al3_transfer_count + al3_read_addr_trig)
+_Static_assert(sizeof(ir_run_block_t) == 2 * sizeof(void *), "bloco fora do layout do alias 3");
+#define IR_BLOCK_WORDS      (sizeof(ir_run_block_t) / sizeof(uint32_t))
+#define IR_BLOCK_RING_BITS  __builtin_ctz(sizeof(ir_run_block_t))
+#endif
+
+// Emissores: cada LED IR em um slice PWM e canais DMA prprios (o DMA
+// escreve 16 bits no registrador CC, o que replica o nvel nos canais A e B)
+typedef struct {
+    uint gpio;
+    uint slice;
+    uint channel;
+    uint16_t wrap;
+    uint32_t carrier_freq;
+    volatile ir_tx_state_t tx_state;
+    volatile uint64_t started_us;   // primeira borda do quadro atual/ltimo
+    volatile uint64_t finished_us;  // fim (ou corte) do ltimo quadro que saiu
+#if !IR_BACKEND_EDGE
+    int dma;                    // dados: nvel do bloco -> CC, no ritmo do wrap
+    int ctrl_dma;               // controle: carrega o prximo bloco no de dados
+    uint64_t start_us;          // quando ligar o slice (j descontado o atraso)
+    uint16_t level_on;          // 50% de duty na portadora atual
+    bool tx_hit;
+    uint32_t done_us;
+    ir_run_block_t blocks[IR_MAX_FRAME_TIMINGS + 1];    // + bloco nulo
+#endif
+} ir_emitter_t;
 
 // Variveis globais PWM e DMA
-static uint pwm_slice;
-static uint pwm_channel;
+static uint32_t ir_carrier_freq = IR_CARRIER_FREQ;
+static ir_emitter_t ir_emitters[IR_MAX_EMITTERS];
+static uint8_t ir_emitter_count = 0;
 static bool ir_initialized = false;
-static int dma_channel = -1;
+static int ir_alarm = -1;
+static ir_tx_stats_t tx_stats;
+
+static void ir_alarm_callback(uint alarm);
+
+#if IR_BACKEND_EDGE
+// Transmisso por bordas: o alarme dispara em cada fronteira marca/espao
+// e troca o nvel do CC direto da tabela de timings (um quadro por vez)
+static struct {
+    const uint16_t *signal;
+    ir_timing_source_t *src;    // no lugar de signal, se no for NULL
+    uint64_t next_us;           // instante da prxima borda
+    uint16_t length;
+    uint16_t index;             // prxima borda
+    uint8_t emitter;
+    volatile bool cancel;       // parar no incio do prximo espao
+} edge_tx;
+#else
+static void ir_dma_irq(void);
+
+// Nvel dos blocos de espao (portadora desligada), lido pelo DMA
+static uint16_t ir_level_off = 0;
 
-// Buffer para nveis PWM (ON/OFF)
-#define MAX_PWM_BUFFER 2048
-static uint16_t pwm_levels[MAX_PWM_BUFFER];
-static uint32_t pwm_count = 0;
+// Cache LRU de quadros quantizados (ciclos de portadora por timing):
+// entradas contguas no arena, em ordem de posio; a remoo compacta o
+// arena e o espao livre fica sempre no fim. O DMA l os blocos do
+// emissor, nunca o arena
+#define WAVE_ARENA_WORDS (IR_WAVE_CACHE_BYTES / sizeof(uint16_t))
+_Static_assert(IR_WAVE_CACHE_BYTES <= UINT16_MAX, "cache maior que used_bytes/offset");
+
+typedef struct {
+    uint32_t key;
+    uint32_t last_use;
+    uint16_t wrap;          // os ciclos dependem da portadora do emissor
+    uint16_t offset;        // em timings
+    uint16_t count;
+} ir_wave_slot_t;
+
+static uint16_t wave_arena[WAVE_ARENA_WORDS];
+static ir_wave_slot_t wave_slots[IR_WAVE_CACHE_SLOTS];
+static uint8_t wave_entries = 0;
+static uint32_t wave_clock = 0;
+static ir_wave_cache_stats_t wave_stats;
+#endif
 
 // ============================================================================
 // SINAIS IR (mantidos do cdigo original)
@@ -158,75 +258,301 @@ static const uint16_t fan_2[] = {
     421, 1293, 445, 353, 420, 354, 421, 354, 422, 1293, 452
 };
 
+// Biblioteca de comandos (ordem de ir_command_id_t)
+static const struct {
+    const char *name;
+    const uint16_t *timings;
+    uint16_t length;
+} ir_commands[IR_CMD_COUNT] = {
+    [IR_CMD_OFF]     = { "OFF",   rawSignal_off, sizeof(rawSignal_off) / sizeof(uint16_t) },
+    [IR_CMD_ON]      = { "ON",    rawSignal_on,  sizeof(rawSignal_on) / sizeof(uint16_t) },
+    [IR_CMD_TEMP_22] = { "22C",   temp_para_22,  sizeof(temp_para_22) / sizeof(uint16_t) },
+    [IR_CMD_TEMP_20] = { "20C",   temp_para_20,  sizeof(temp_para_20) / sizeof(uint16_t) },
+    [IR_CMD_FAN_1]   = { "FAN1",  fan_1,         sizeof(fan_1) / sizeof(uint16_t) },
+    [IR_CMD_FAN_2]   = { "FAN2",  fan_2,         sizeof(fan_2) / sizeof(uint16_t) },
+};
+
+// Comandos desabilitados pelo verificador de integridade
+static bool ir_command_disabled[IR_CMD_COUNT];
+
+// Ciclos de portadora de um timing (no mnimo um)
+static uint32_t timing_cycles(uint32_t carrier_freq, uint16_t duration_us) {
+    uint32_t num_cycles = ((uint32_t)duration_us * carrier_freq) / 1000000u;
+    return num_cycles < 1 ? 1 : num_cycles;
+}
+
+#if !IR_BACKEND_EDGE
 // ============================================================================
-// CONVERSO: Sinal RAW ? Buffer PWM
+// CONVERSO: Sinal RAW -> blocos do DMA
 // ============================================================================
 
-bool prepare_pwm_buffer(const uint16_t* raw_signal, size_t raw_length) {
-    pwm_count = 0;
-    uint16_t pwm_wrap = pwm_hw->slice[pwm_slice].top;
-    uint16_t pwm_on = pwm_wrap / 2;   // 50% duty = carrier ON
-    uint16_t pwm_off = 0;              // 0% duty = carrier OFF
-    
-    for (size_t i = 0; i < raw_length && pwm_count < MAX_PWM_BUFFER; i++) {
-        uint16_t duration_us = raw_signal[i];
-        bool is_on = (i % 2 == 0);  // Par=ON, mpar=OFF
-        
-        // Cada ~26us = 1 ciclo PWM em 38kHz
-        uint16_t num_cycles = duration_us / 26;
-        if (num_cycles < 1) num_cycles = 1;
-        
-        uint16_t level = is_on ? pwm_on : pwm_off;
-        
-        for (uint16_t j = 0; j < num_cycles && pwm_count < MAX_PWM_BUFFER; j++) {
-            pwm_levels[pwm_count++] = level;
+// Quantiza o quadro em ciclos de portadora, um valor por timing (at 3932
+// ciclos em 60kHz: cabe em 16 bits). Com src, os timings vm da fonte
+static void quantize_frame(const ir_emitter_t *em, const uint16_t* raw_signal, size_t raw_length,
+                           ir_timing_source_t *src, uint16_t *cycles) {
+    if (src) {
+        src->rewind(src);
+    }
+    for (size_t i = 0; i < raw_length; i++) {
+        uint16_t duration_us = src ? src->next(src) : raw_signal[i];
+        cycles[i] = (uint16_t)timing_cycles(em->carrier_freq, duration_us);
+    }
+}
+
+// Monta os blocos do emissor: dos ciclos j quantizados (cache) ou direto
+// do sinal/fonte. Par = marca (portadora ligada), mpar = espao
+static void build_blocks(ir_emitter_t *em, const uint16_t *cycles, const uint16_t* raw_signal,
+                         size_t raw_length, ir_timing_source_t *src) {
+    if (!cycles && src) {
+        src->rewind(src);
+    }
+    for (size_t i = 0; i < raw_length; i++) {
+        ir_run_block_t *b = &em->blocks[i];
+        if (cycles) {
+            b->count = cycles[i];
+        } else {
+            b->count = timing_cycles(em->carrier_freq, src ? src->next(src) : raw_signal[i]);
         }
+        b->level = (i % 2 == 0) ? (const volatile void *)&em->level_on : &ir_level_off;
     }
-    
-    return pwm_count > 0;
+    em->blocks[raw_length].count = 0;
+    em->blocks[raw_length].level = NULL;
 }
 
+bool custom_ir_prepare_blocks(uint8_t emitter, const uint16_t* raw_signal, size_t raw_length,
+                              ir_timing_source_t *src) {
+    if (emitter >= ir_emitter_count || ir_emitters[emitter].tx_state != IR_TX_IDLE) {
+        return false;
+    }
+    if (src) {
+        raw_length = src->length;
+    }
+    if (raw_length == 0 || raw_length > IR_MAX_FRAME_TIMINGS) {
+        return false;
+    }
+    build_blocks(&ir_emitters[emitter], NULL, raw_signal, raw_length, src);
+    return true;
+}
+
+// ============================================================================
+// CACHE DE FORMAS DE ONDA
+// ============================================================================
+
+static uint32_t wave_used_words(void) {
+    if (wave_entries == 0) return 0;
+    const ir_wave_slot_t *last = &wave_slots[wave_entries - 1];
+    return (uint32_t)last->offset + last->count;
+}
+
+static int wave_lookup(uint32_t key, uint16_t wrap) {
+    for (uint8_t i = 0; i < wave_entries; i++) {
+        if (wave_slots[i].key == key && wave_slots[i].wrap == wrap) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void wave_remove(uint8_t idx) {
+    ir_wave_slot_t *s = &wave_slots[idx];
+    uint32_t tail = wave_used_words() - (s->offset + s->count);
+
+    // Compacta: tudo que vem depois desce 'count' amostras
+    memmove(&wave_arena[s->offset], &wave_arena[s->offset + s->count], tail * sizeof(uint16_t));
+    uint16_t freed = s->count;
+    for (uint8_t i = idx + 1; i < wave_entries; i++) {
+        wave_slots[i].offset -= freed;
+        wave_slots[i - 1] = wave_slots[i];
+    }
+    wave_entries--;
+}
+
+static void wave_evict_lru(void) {
+    uint8_t lru = 0;
+    for (uint8_t i = 1; i < wave_entries; i++) {
+        if (wave_slots[i].last_use < wave_slots[lru].last_use) lru = i;
+    }
+    wave_remove(lru);
+    wave_stats.evictions++;
+}
+
+// Reserva espao para um quadro novo; NULL se no cabe no oramento
+static uint16_t *wave_insert(uint32_t key, uint16_t wrap, uint32_t count) {
+    if (count == 0 || count > WAVE_ARENA_WORDS) {
+        return NULL;
+    }
+    while (wave_entries >= IR_WAVE_CACHE_SLOTS || wave_used_words() + count > WAVE_ARENA_WORDS) {
+        wave_evict_lru();
+    }
+
+    uint16_t offset = (uint16_t)wave_used_words();
+    ir_wave_slot_t *s = &wave_slots[wave_entries++];
+    s->key = key;
+    s->wrap = wrap;
+    s->offset = offset;
+    s->count = (uint16_t)count;
+    s->last_use = ++wave_clock;
+    return &wave_arena[s->offset];
+}
+
+void custom_ir_cache_flush(void) {
+    wave_entries = 0;
+}
+
+void custom_ir_cache_get_stats(ir_wave_cache_stats_t *stats) {
+    *stats = wave_stats;
+    stats->used_bytes = (uint16_t)(wave_used_words() * sizeof(uint16_t));
+    stats->entries = wave_entries;
+}
+#else
+// Sem blocos de DMA: no h o que guardar
+void custom_ir_cache_flush(void) {
+}
+
+void custom_ir_cache_get_stats(ir_wave_cache_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+#endif
+
 // ============================================================================
 // INICIALIZAO
 // ============================================================================
 
-bool custom_ir_init(uint gpio_pin) {
+void custom_ir_set_carrier_freq(uint32_t freq_hz) {
+    if (freq_hz >= IR_CARRIER_MIN_HZ && freq_hz <= IR_CARRIER_MAX_HZ) {
+        ir_carrier_freq = freq_hz;
+    }
+}
+
+int custom_ir_add_emitter(uint gpio_pin) {
+    if (ir_emitter_count >= IR_MAX_EMITTERS) {
+        printf("ERRO: limite de emissores IR atingido\n");
+        return -1;
+    }
+    uint slice = pwm_gpio_to_slice_num(gpio_pin);
+    for (uint8_t i = 0; i < ir_emitter_count; i++) {
+        if (ir_emitters[i].slice == slice) {
+            printf("ERRO: GPIO %u divide o slice PWM %u com o GPIO %u\n",
+                   gpio_pin, slice, ir_emitters[i].gpio);
+            return -1;
+        }
+    }
+#if !IR_BACKEND_EDGE
+    int dma = dma_claim_unused_channel(false);
+    int ctrl_dma = dma >= 0 ? dma_claim_unused_channel(false) : -1;
+    if (ctrl_dma < 0) {
+        if (dma >= 0) {
+            dma_channel_unclaim(dma);
+        }
+        printf("ERRO: sem canais DMA para o emissor IR\n");
+        return -1;
+    }
+#endif
+
+    ir_emitter_t *em = &ir_emitters[ir_emitter_count];
+    em->gpio = gpio_pin;
+    em->slice = slice;
+    em->channel = pwm_gpio_to_channel(gpio_pin);
+    em->carrier_freq = ir_carrier_freq;
+    em->tx_state = IR_TX_IDLE;
+
     // Configurar PWM
     gpio_set_function(gpio_pin, GPIO_FUNC_PWM);
-    pwm_slice = pwm_gpio_to_slice_num(gpio_pin);
-    pwm_channel = pwm_gpio_to_channel(gpio_pin);
     
     pwm_config config = pwm_get_default_config();
     pwm_config_set_clkdiv(&config, 1.0f);
     
     // Para 38kHz: 125MHz / 38kHz ? 3289
-    uint16_t wrap_value = (125000000 / IR_CARRIER_FREQ) - 1;
-    pwm_config_set_wrap(&config, wrap_value);
-    
-    pwm_init(pwm_slice, &config, true);
-    pwm_set_chan_level(pwm_slice, pwm_channel, 0);  // Comea desligado
+    em->wrap = HW_PWM_WRAP(em->carrier_freq);
+    pwm_config_set_wrap(&config, em->wrap);
     
-    // Configurar DMA
-    dma_channel = dma_claim_unused_channel(true);
-    
-    dma_channel_config c = dma_channel_get_default_config(dma_channel);
+    pwm_init(em->slice, &config, true);
+    pwm_set_chan_level(em->slice, em->channel, 0);  // Comea desligado
+
+#if IR_BACKEND_EDGE
+    printf("IR emissor %u: GPIO %u, PWM slice=%u (bordas por IRQ)\n",
+           ir_emitter_count, gpio_pin, em->slice);
+#else
+    // Canal de dados: nvel do bloco atual -> registrador CC, no ritmo do
+    // wrap do PWM; no fim de cada bloco encadeia o canal de controle
+    em->dma = dma;
+    em->ctrl_dma = ctrl_dma;
+    em->level_on = em->wrap / 2;
+    dma_channel_config c = dma_channel_get_default_config(dma);
     channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
-    channel_config_set_read_increment(&c, true);    // L do buffer sequencialmente
+    channel_config_set_read_increment(&c, false);   // Repete o nvel do bloco
     channel_config_set_write_increment(&c, false);  // Sempre escreve no mesmo reg PWM
-    channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + pwm_slice);  // Sincroniza com PWM
+    channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + em->slice);  // Sincroniza com PWM
+    channel_config_set_chain_to(&c, ctrl_dma);
+    channel_config_set_irq_quiet(&c, true);         // IRQ s no bloco nulo (fim)
     
     dma_channel_configure(
-        dma_channel,
+        dma,
         &c,
-        &pwm_hw->slice[pwm_slice].cc,  // Escreve no registrador CC do PWM
-        NULL,   // Origem ser definida depois
-        0,      // Contagem ser definida depois
+        &pwm_hw->slice[em->slice].cc,   // Destino: CC do slice
+        NULL,   // Origem e contagem vm dos blocos
+        0,
         false   // No inicia ainda
     );
+    dma_channel_set_irq0_enabled(dma, true);
+
+    // Canal de controle: um bloco por disparo, sem esperar DREQ
+    dma_channel_config k = dma_channel_get_default_config(ctrl_dma);
+    channel_config_set_transfer_data_size(&k, DMA_SIZE_32);
+    channel_config_set_read_increment(&k, true);
+    channel_config_set_write_increment(&k, true);
+    channel_config_set_ring(&k, true, IR_BLOCK_RING_BITS);
+    dma_channel_configure(ctrl_dma, &k, &dma_channel_hw_addr(dma)->al3_transfer_count,
+                          NULL, IR_BLOCK_WORDS, false);
+
+    printf("IR emissor %u: GPIO %u, PWM slice=%u, DMA chan=%d/%d\n",
+           ir_emitter_count, gpio_pin, em->slice, dma, ctrl_dma);
+#endif
+    return ir_emitter_count++;
+}
+
+bool custom_ir_set_emitter_carrier(uint8_t emitter, uint32_t freq_hz) {
+    if (emitter >= ir_emitter_count || freq_hz < IR_CARRIER_MIN_HZ || freq_hz > IR_CARRIER_MAX_HZ) {
+        return false;
+    }
+    ir_emitter_t *em = &ir_emitters[emitter];
+    if (em->tx_state != IR_TX_IDLE) {
+        return false;
+    }
+    // A cache de quadros j separa as entradas pelo wrap
+    em->carrier_freq = freq_hz;
+    em->wrap = HW_PWM_WRAP(freq_hz);
+#if !IR_BACKEND_EDGE
+    em->level_on = em->wrap / 2;
+#endif
+    pwm_set_wrap(em->slice, em->wrap);
+    return true;
+}
+
+uint32_t custom_ir_emitter_carrier(uint8_t emitter) {
+    return emitter < ir_emitter_count ? ir_emitters[emitter].carrier_freq : 0;
+}
+
+bool custom_ir_init(uint gpio_pin) {
+    // Alarme do timer que dispara o incio das transmisses agendadas
+    ir_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(ir_alarm, ir_alarm_callback);
+    irq_set_priority(TIMER_IRQ_0 + ir_alarm, PICO_HIGHEST_IRQ_PRIORITY);
+
+#if !IR_BACKEND_EDGE
+    // Fim de transmisso: IRQ do DMA desliga a portadora
+    irq_add_shared_handler(DMA_IRQ_0, ir_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+#endif
+
+    // Emissor 0 = pino principal
+    if (custom_ir_add_emitter(gpio_pin) != 0) {
+        return false;
+    }
     
     ir_initialized = true;
     
-    printf("IR DMA inicializado: PWM slice=%d, DMA chan=%d\n", pwm_slice, dma_channel);
+    printf("IR DMA inicializado: alarme=%d\n", ir_alarm);
     
     return true;
 }
@@ -235,31 +561,467 @@ bool custom_ir_init(uint gpio_pin) {
 // ENVIO COM DMA
 // ============================================================================
 
-void send_raw_signal(const uint16_t* signal, size_t length) {
-    if (!ir_initialized) {
+#if IR_BACKEND_EDGE
+static void finish_tx(ir_emitter_t *em) {
+    pwm_set_chan_level(em->slice, em->channel, 0);  // Desligar PWM
+    if (em->tx_state == IR_TX_RUNNING) {
+        em->finished_us = time_us_64();
+    }
+    em->tx_state = IR_TX_IDLE;
+}
+
+// Uma IRQ por borda; bordas com alvo j vencido saem no mesmo disparo
+static void ir_alarm_callback(uint alarm) {
+    ir_emitter_t *em = &ir_emitters[edge_tx.emitter];
+
+    for (;;) {
+        uint64_t now = time_us_64();
+        uint32_t late = now > edge_tx.next_us ? (uint32_t)(now - edge_tx.next_us) : 0;
+
+        // Cancelado: para antes de comear ou no fim da marca atual
+        if (edge_tx.cancel && (edge_tx.index == 0 || edge_tx.index % 2 == 1)) {
+            finish_tx(em);
+            return;
+        }
+
+        if (edge_tx.index == 0) {
+            em->tx_state = IR_TX_RUNNING;
+            em->started_us = now;
+            tx_stats.late_last_us = late;
+            if (late > tx_stats.late_max_us) tx_stats.late_max_us = late;
+            tx_stats.started++;
+        } else {
+            tx_stats.edges++;
+            tx_stats.edge_late_sum_us += late;
+            if (late > tx_stats.edge_late_max_us) tx_stats.edge_late_max_us = late;
+        }
+
+        if (edge_tx.index >= edge_tx.length) {
+            finish_tx(em);      // fim da ltima marca
+            return;
+        }
+
+        // Par=ON (50% duty), mpar=OFF
+        pwm_set_chan_level(em->slice, em->channel, (edge_tx.index % 2 == 0) ? em->wrap / 2 : 0);
+        edge_tx.next_us += edge_tx.src ? edge_tx.src->next(edge_tx.src)
+                                       : edge_tx.signal[edge_tx.index];
+        edge_tx.index++;
+
+        if (!hardware_alarm_set_target(alarm, from_us_since_boot(edge_tx.next_us))) {
+            return;
+        }
+        tx_stats.edge_missed++;
+    }
+}
+
+static bool arm_frame(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                      ir_timing_source_t *src, absolute_time_t start) {
+    (void)key;
+    if (!ir_initialized || emitter >= ir_emitter_count) {
         printf("ERRO: IR no inicializado!\n");
-        return;
+        return false;
     }
-    
-    // Preparar buffer PWM
-    if (!prepare_pwm_buffer(signal, length)) {
-        printf("ERRO: Falha ao preparar buffer\n");
-        return;
+    if (custom_ir_any_busy()) {
+        printf("ERRO: backend de bordas transmite um quadro por vez\n");
+        return false;
+    }
+    if (length == 0 || length > UINT16_MAX) {
+        return false;
+    }
+    ir_emitter_t *em = &ir_emitters[emitter];
+
+    if (src) {
+        src->rewind(src);
+    }
+    // O CC s  carregado no wrap: as bordas saem alinhadas  portadora
+    edge_tx.signal = signal;
+    edge_tx.src = src;
+    edge_tx.length = (uint16_t)length;
+    edge_tx.index = 0;
+    edge_tx.emitter = emitter;
+    edge_tx.cancel = false;
+    edge_tx.next_us = to_us_since_boot(start);
+
+    uint32_t irq = save_and_disable_interrupts();
+    em->tx_state = IR_TX_ARMED;
+    tx_stats.armed++;
+    if (hardware_alarm_set_target(ir_alarm, start)) {
+        ir_alarm_callback(ir_alarm);    // incio j passou
+    }
+    restore_interrupts(irq);
+    return true;
+}
+
+#else
+// Monta os blocos do quadro inteiro: ciclos da cache, ou quantizados agora
+static bool select_blocks(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                          ir_timing_source_t *src) {
+    ir_emitter_t *em = &ir_emitters[emitter];
+    em->tx_hit = false;
+    if (length == 0 || length > IR_MAX_FRAME_TIMINGS) {
+        printf("ERRO: quadro com %lu timings (maximo %u)\n",
+               (unsigned long)length, IR_MAX_FRAME_TIMINGS);
+        return false;
     }
     
-    printf("Transmitindo %lu valores PWM via DMA...", pwm_count);
-    
-    // Configurar e iniciar DMA
-    dma_channel_set_read_addr(dma_channel, pwm_levels, false);
-    dma_channel_set_trans_count(dma_channel, pwm_count, true);  // true = inicia
+    // Quadro j quantizado na cache?
+    if (key != 0) {
+        int idx = wave_lookup(key, em->wrap);
+        if (idx >= 0) {
+            wave_slots[idx].last_use = ++wave_clock;
+            build_blocks(em, &wave_arena[wave_slots[idx].offset], NULL, wave_slots[idx].count, NULL);
+            wave_stats.hits++;
+            em->tx_hit = true;
+            return true;
+        }
+        wave_stats.misses++;
+        uint16_t *dst = wave_insert(key, em->wrap, length);
+        if (dst) {
+            quantize_frame(em, signal, length, src, dst);
+            build_blocks(em, dst, NULL, length, NULL);
+            return true;
+        }
+        wave_stats.uncached++;
+    }
     
-    // Aguardar concluso
-    dma_channel_wait_for_finish_blocking(dma_channel);
+    // Sem cache: quantiza direto nos blocos do emissor
+    build_blocks(em, NULL, signal, length, src);
+    return true;
+}
+
+static void finish_tx(ir_emitter_t *em) {
+    pwm_set_chan_level(em->slice, em->channel, 0);  // Desligar PWM
+    em->done_us = time_us_32();
+    if (em->tx_state == IR_TX_RUNNING) {
+        em->finished_us = time_us_64();
+    }
+    em->tx_state = IR_TX_IDLE;
+}
+
+static void ir_dma_irq(void) {
+    for (uint8_t i = 0; i < ir_emitter_count; i++) {
+        ir_emitter_t *em = &ir_emitters[i];
+        if (dma_channel_get_irq0_status(em->dma)) {
+            dma_channel_acknowledge_irq0(em->dma);
+            finish_tx(em);
+        }
+    }
+}
+
+// Liga de uma vez (mesma escrita em EN) todos os slices com incio vencido
+static void start_due_emitters(void) {
+    uint64_t now = time_us_64();
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < ir_emitter_count; i++) {
+        ir_emitter_t *em = &ir_emitters[i];
+        if (em->tx_state == IR_TX_ARMED && em->start_us <= now + IR_ARM_SLACK_US) {
+            mask |= 1u << em->slice;
+            em->tx_state = IR_TX_RUNNING;
+            em->started_us = now + IR_ARM_LEAD_PERIODS * (1000000u / em->carrier_freq);
+            uint32_t late = now > em->start_us ? (uint32_t)(now - em->start_us) : 0;
+            tx_stats.late_last_us = late;
+            if (late > tx_stats.late_max_us) tx_stats.late_max_us = late;
+            tx_stats.started++;
+        }
+    }
+    if (mask) {
+        hw_set_bits(&pwm_hw->en, mask);
+    }
+}
+
+// Programa o alarme para o prximo incio; incios j vencidos saem na hora
+static void schedule_alarm(void) {
+    for (;;) {
+        uint64_t next = UINT64_MAX;
+        for (uint8_t i = 0; i < ir_emitter_count; i++) {
+            if (ir_emitters[i].tx_state == IR_TX_ARMED && ir_emitters[i].start_us < next) {
+                next = ir_emitters[i].start_us;
+            }
+        }
+        if (next == UINT64_MAX) {
+            return;
+        }
+        if (!hardware_alarm_set_target(ir_alarm, from_us_since_boot(next))) {
+            return;
+        }
+        start_due_emitters();   // alvo j passou
+    }
+}
+
+static void ir_alarm_callback(uint alarm) {
+    (void)alarm;
+    start_due_emitters();
+    schedule_alarm();
+}
+
+static bool arm_frame(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                      ir_timing_source_t *src, absolute_time_t start) {
+    if (!ir_initialized || emitter >= ir_emitter_count) {
+        printf("ERRO: IR no inicializado!\n");
+        return false;
+    }
+    ir_emitter_t *em = &ir_emitters[emitter];
+    if (em->tx_state != IR_TX_IDLE) {
+        printf("ERRO: emissor %u ocupado\n", emitter);
+        return false;
+    }
+    if (!select_blocks(emitter, key, signal, length, src)) {
+        return false;
+    }
+
+    // O nvel zero precisa ter sido carregado no CC antes de parar o slice
+    uint32_t period_us = 1000000u / em->carrier_freq;
+    uint32_t idle_us = time_us_32() - em->done_us;
+    if (idle_us < 2 * period_us) {
+        busy_wait_us_32(2 * period_us - idle_us);
+    }
+
+    // Slice parado: o DMA fica armado esperando o primeiro wrap. O abort
+    // limpa os canais antes de rearmar (o slice rodava ocioso at aqui)
+    hw_clear_bits(&pwm_hw->en, 1u << em->slice);
+    pwm_set_counter(em->slice, 0);
+    dma_channel_set_irq0_enabled(em->dma, false);
+    dma_channel_abort(em->ctrl_dma);
+    dma_channel_abort(em->dma);
+    dma_channel_acknowledge_irq0(em->dma);
+    dma_channel_set_irq0_enabled(em->dma, true);
+
+    // O primeiro nvel chega ao pino IR_ARM_LEAD_PERIODS ciclos aps ligar o slice
+    uint64_t start_us = to_us_since_boot(start);
+    uint32_t lead_us = IR_ARM_LEAD_PERIODS * period_us;
+    em->start_us = start_us > lead_us ? start_us - lead_us : 0;
+
+    // O controle carrega o primeiro bloco; o canal de dados aguarda o DREQ
+    dma_channel_set_read_addr(em->ctrl_dma, em->blocks, true);
+
+    uint32_t irq = save_and_disable_interrupts();
+    em->tx_state = IR_TX_ARMED;
+    tx_stats.armed++;
+    schedule_alarm();
+    restore_interrupts(irq);
+    return true;
+}
+
+#endif
+
+bool custom_ir_arm(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                   absolute_time_t start) {
+    return arm_frame(emitter, key, signal, length, NULL, start);
+}
+
+bool custom_ir_arm_source(uint8_t emitter, uint32_t key, ir_timing_source_t *src,
+                          absolute_time_t start) {
+    return arm_frame(emitter, key, NULL, src->length, src, start);
+}
+
+bool custom_ir_busy(uint8_t emitter) {
+    return emitter < ir_emitter_count && ir_emitters[emitter].tx_state != IR_TX_IDLE;
+}
+
+bool custom_ir_any_busy(void) {
+    for (uint8_t i = 0; i < ir_emitter_count; i++) {
+        if (ir_emitters[i].tx_state != IR_TX_IDLE) return true;
+    }
+    return false;
+}
+
+void custom_ir_wait(uint8_t emitter) {
+    while (custom_ir_busy(emitter)) {
+        tight_loop_contents();
+    }
+}
+
+void custom_ir_get_tx_stats(ir_tx_stats_t *stats) {
+    *stats = tx_stats;
+}
+
+static bool send_frame(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                       ir_timing_source_t *src) {
+    // Quadro da fila ainda no ar neste emissor: espera terminar
+    custom_ir_wait(emitter);
+    if (!arm_frame(emitter, key, signal, length, src, get_absolute_time())) {
+        return false;
+    }
+#if IR_BACKEND_EDGE
+    printf("Transmitindo %lu bordas via IRQ...", (unsigned long)length);
+#else
+    printf("Transmitindo %lu blocos via DMA%s...",
+           (unsigned long)length, ir_emitters[emitter].tx_hit ? " (cache)" : "");
+#endif
     
-    // Desligar PWM
-    pwm_set_chan_level(pwm_slice, pwm_channel, 0);
+    // Aguardar concluso (a IRQ do DMA desliga a portadora)
+    custom_ir_wait(emitter);
     
     printf(" OK!\n");
+    return true;
+}
+
+bool send_raw_signal_keyed(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length) {
+    return send_frame(emitter, key, signal, length, NULL);
+}
+
+bool send_source_keyed(uint8_t emitter, uint32_t key, ir_timing_source_t *src) {
+    return send_frame(emitter, key, NULL, src->length, src);
+}
+
+bool send_raw_signal_on(uint8_t emitter, const uint16_t* signal, size_t length) {
+    return send_raw_signal_keyed(emitter, 0, signal, length);
+}
+
+void send_raw_signal(const uint16_t* signal, size_t length) {
+    send_raw_signal_on(0, signal, length);
+}
+
+// Para o emissor imediatamente (portadora desligada)
+static void stop_emitter(ir_emitter_t *em) {
+#if IR_BACKEND_EDGE
+    hardware_alarm_cancel(ir_alarm);
+#else
+    // Abort pode gerar IRQ espria: desabilita antes de abortar. Controle
+    // primeiro, para no recarregar o canal de dados
+    dma_channel_set_irq0_enabled(em->dma, false);
+    dma_channel_abort(em->ctrl_dma);
+    dma_channel_abort(em->dma);
+    dma_channel_acknowledge_irq0(em->dma);
+    dma_channel_set_irq0_enabled(em->dma, true);
+    hw_set_bits(&pwm_hw->en, 1u << em->slice);  // armado: slice estava parado
+#endif
+    finish_tx(em);
+}
+
+bool custom_ir_abort(void) {
+    bool any = false;
+    for (uint8_t i = 0; i < ir_emitter_count; i++) {
+        ir_emitter_t *em = &ir_emitters[i];
+        if (em->tx_state == IR_TX_IDLE) {
+            continue;
+        }
+        stop_emitter(em);
+        any = true;
+    }
+    return any;
+}
+
+bool custom_ir_cancel(uint8_t emitter) {
+    if (emitter >= ir_emitter_count) return false;
+    ir_emitter_t *em = &ir_emitters[emitter];
+
+    uint32_t irq = save_and_disable_interrupts();
+    if (em->tx_state == IR_TX_IDLE) {
+        restore_interrupts(irq);
+        return false;
+    }
+    if (em->tx_state == IR_TX_ARMED) {
+        stop_emitter(em);           // nada saiu ainda
+        restore_interrupts(irq);
+        tx_stats.cancelled++;
+        return true;
+    }
+#if IR_BACKEND_EDGE
+    if (edge_tx.index % 2 == 0) {
+        stop_emitter(em);           // j em um espao
+    } else {
+        edge_tx.cancel = true;      // a IRQ para no fim desta marca
+    }
+    restore_interrupts(irq);
+#else
+    restore_interrupts(irq);
+
+    // Espera o DMA entrar em um espao (bloco com o nvel desligado: a
+    // marca anterior j saiu inteira)
+    while (em->tx_state == IR_TX_RUNNING) {
+        if (dma_channel_hw_addr(em->dma)->read_addr == (uintptr_t)&ir_level_off) {
+            irq = save_and_disable_interrupts();
+            if (em->tx_state == IR_TX_RUNNING) {
+                stop_emitter(em);
+            }
+            restore_interrupts(irq);
+        }
+    }
+#endif
+    custom_ir_wait(emitter);
+    tx_stats.cancelled++;
+    return true;
+}
+
+uint64_t custom_ir_started_at(uint8_t emitter) {
+    return emitter < ir_emitter_count ? ir_emitters[emitter].started_us : 0;
+}
+
+uint64_t custom_ir_finished_at(uint8_t emitter) {
+    return emitter < ir_emitter_count ? ir_emitters[emitter].finished_us : 0;
+}
+
+size_t custom_ir_mark_intervals(uint8_t emitter, const uint16_t* signal, size_t length,
+                                ir_interval_t *out, size_t max) {
+    if (emitter >= ir_emitter_count) return 0;
+    const ir_emitter_t *em = &ir_emitters[emitter];
+    uint32_t cycles = 0;
+    size_t n = 0;
+
+    // Mesma quantizao dos blocos do DMA, acumulada em ciclos
+    for (size_t i = 0; i < length; i++) {
+        uint32_t num_cycles = timing_cycles(em->carrier_freq, signal[i]);
+
+        if (i % 2 == 0) {
+            if (n >= max) break;
+            out[n].start_us = (uint32_t)(((uint64_t)cycles * 1000000u) / em->carrier_freq);
+            out[n].end_us = (uint32_t)(((uint64_t)(cycles + num_cycles) * 1000000u) / em->carrier_freq);
+            n++;
+        }
+        cycles += num_cycles;
+    }
+    return n;
+}
+
+uint8_t custom_ir_emitter_count(void) {
+    return ir_emitter_count;
+}
+
+uint32_t ir_signal_duration_us(const uint16_t* signal, size_t length) {
+    uint32_t total = 0;
+    for (size_t i = 0; i < length; i++) {
+        total += signal[i];
+    }
+    return total;
+}
+
+// ============================================================================
+// BIBLIOTECA DE COMANDOS
+// ============================================================================
+
+bool custom_ir_get_command(ir_command_id_t id, const uint16_t **timings, size_t *length,
+                           const char **name) {
+    if (id >= IR_CMD_COUNT) return false;
+    if (timings) *timings = ir_commands[id].timings;
+    if (length) *length = ir_commands[id].length;
+    if (name) *name = ir_commands[id].name;
+    return true;
+}
+
+void custom_ir_set_command_enabled(ir_command_id_t id, bool enabled) {
+    if (id < IR_CMD_COUNT) {
+        ir_command_disabled[id] = !enabled;
+    }
+}
+
+bool custom_ir_command_enabled(ir_command_id_t id) {
+    return id < IR_CMD_COUNT && !ir_command_disabled[id];
+}
+
+bool send_ir_command_on(uint8_t emitter, ir_command_id_t id) {
+    if (id >= IR_CMD_COUNT) return false;
+    if (ir_command_disabled[id]) {
+        printf("ERRO: comando %s desabilitado (tabela corrompida)\n", ir_commands[id].name);
+        return false;
+    }
+    return send_raw_signal_keyed(emitter, IR_CMD_CACHE_KEY(id),
+                                 ir_commands[id].timings, ir_commands[id].length);
+}
+
+bool send_ir_command(ir_command_id_t id) {
+    return send_ir_command_on(0, id);
 }
 
 // ============================================================================
@@ -268,32 +1030,32 @@ void send_raw_signal(const uint16_t* signal, size_t length) {
 
 void turn_off_ac() {
     printf("Comando: DESLIGAR AC\n");
-    send_raw_signal(rawSignal_off, sizeof(rawSignal_off) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_OFF);
 }
 
 void turn_on_ac() {
     printf("Comando: LIGAR AC\n");
-    send_raw_signal(rawSignal_on, sizeof(rawSignal_on) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_ON);
 }
 
 void set_temp_22c() {
     printf("Comando: TEMPERATURA 22C\n");
-    send_raw_signal(temp_para_22, sizeof(temp_para_22) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_TEMP_22);
 }
 
 void set_temp_20c() {
     printf("Comando: TEMPERATURA 20C\n");
-    send_raw_signal(temp_para_20, sizeof(temp_para_20) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_TEMP_20);
 }
 
 void set_fan_level_1() {
     printf("Comando: VENTILADOR NVEL 1\n");
-    send_raw_signal(fan_1, sizeof(fan_1) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_FAN_1);
 }
 
 void set_fan_level_2() {
     printf("Comando: VENTILADOR NVEL 2\n");
-    send_raw_signal(fan_2, sizeof(fan_2) / sizeof(uint16_t));
+    send_ir_command(IR_CMD_FAN_2);
 }
 
 void ir_demo() {
@@ -8,14 +8,118 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "pico/types.h"
+
+// Backend de transmisso: 0 = blocos marca/espao + dois canais DMA por
+// emissor (padro), 1 = uma IRQ de alarme por borda, sem buffer (variantes
+// com pouca RAM). Os dois transmitem o quadro inteiro
+#ifndef IR_BACKEND_EDGE
+#define IR_BACKEND_EDGE 0
+#endif
+
+// Portadora padro (pode ser trocada via custom_ir_set_carrier_freq)
+#define IR_CARRIER_FREQ 38000
+#define IR_CARRIER_MIN_HZ 20000
+#define IR_CARRIER_MAX_HZ 60000
+
+// Mximo de LEDs IR (um por slice PWM)
+#define IR_MAX_EMITTERS 4
+
+// Maior quadro em timings marca/espao (backend DMA: um bloco de 8 bytes
+// por timing em cada emissor). Quadro maior  recusado, nunca cortado
+#define IR_MAX_FRAME_TIMINGS 264
+
+// Cache de quadros quantizados em ciclos de portadora, 2 bytes por timing:
+// cabe um quadro de cada estado (comando da biblioteca) em cada emissor,
+// para a reafirmao da frota no expulsar os comandos do usurio
+#define IR_WAVE_CACHE_SLOTS (IR_MAX_EMITTERS * IR_CMD_COUNT)
+#ifndef IR_WAVE_CACHE_BYTES
+#define IR_WAVE_CACHE_BYTES (IR_WAVE_CACHE_SLOTS * IR_MAX_FRAME_TIMINGS * 2)
+#endif
+
+// Chaves de cache dos comandos da biblioteca (bit alto reservado)
+#define IR_CMD_CACHE_KEY(id) (0x80000000u | (uint32_t)(id))
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t uncached;      // quadros maiores que o oramento
+    uint16_t used_bytes;
+    uint8_t entries;
+} ir_wave_cache_stats_t;
+
+// Intervalo de portadora ligada, relativo ao incio do quadro
+typedef struct {
+    uint32_t start_us;
+    uint32_t end_us;
+} ir_interval_t;
+
+// Transmisses agendadas (atraso do disparo medido na IRQ do alarme)
+typedef struct {
+    uint32_t armed;
+    uint32_t started;
+    uint32_t late_last_us;
+    uint32_t late_max_us;
+    // S no backend de bordas: atraso de cada IRQ em relao ao alvo
+    uint32_t edges;
+    uint32_t edge_late_sum_us;
+    uint32_t edge_late_max_us;
+    uint32_t edge_missed;       // alvo j vencido ao reprogramar o alarme
+    uint32_t cancelled;
+} ir_tx_stats_t;
+
+// Fonte de timings sob demanda (ex.: quadro comprimido por ir_codec): o
+// transmissor puxa um timing por vez, sem tabela expandida em RAM.
+// next() pode rodar na IRQ do alarme (backend de bordas)
+typedef struct ir_timing_source {
+    uint16_t length;                                    // timings no quadro
+    uint16_t (*next)(struct ir_timing_source *src);    // prximo timing em us
+    void (*rewind)(struct ir_timing_source *src);      // volta ao primeiro
+} ir_timing_source_t;
+
+// Comandos gravados na biblioteca (tabelas de timings em flash)
+typedef enum {
+    IR_CMD_OFF,
+    IR_CMD_ON,
+    IR_CMD_TEMP_22,
+    IR_CMD_TEMP_20,
+    IR_CMD_FAN_1,
+    IR_CMD_FAN_2,
+    IR_CMD_COUNT
+} ir_command_id_t;
 
 /**
  * Inicializa o sistema IR com DMA
- * @param gpio_pin Pino GPIO para sada IR
+ * @param gpio_pin Pino GPIO para sada IR (vira o emissor 0)
  * @return true se inicializado com sucesso
  */
 bool custom_ir_init(uint gpio_pin);
 
+/**
+ * Adiciona outro LED IR (cada emissor precisa de um slice PWM prprio)
+ * @param gpio_pin Pino GPIO do emissor
+ * @return ndice do emissor, ou -1 se o slice j est em uso
+ */
+int custom_ir_add_emitter(uint gpio_pin);
+
+uint8_t custom_ir_emitter_count(void);
+
+/**
+ * Troca a portadora de um emissor j configurado (perfil do aparelho)
+ * @param freq_hz Frequncia em Hz (20-60 kHz)
+ * @return false se o emissor no existe, est ocupado ou a frequncia  invlida
+ */
+bool custom_ir_set_emitter_carrier(uint8_t emitter, uint32_t freq_hz);
+uint32_t custom_ir_emitter_carrier(uint8_t emitter);
+
+/**
+ * Define a frequncia da portadora (chamar antes de custom_ir_init)
+ * @param freq_hz Frequncia em Hz (20-60 kHz; fora disso  ignorada)
+ */
+void custom_ir_set_carrier_freq(uint32_t freq_hz);
+
 /**
  * Envia um sinal RAW via DMA
  * @param signal Array de timings em microsegundos
@@ -23,6 +127,127 @@ bool custom_ir_init(uint gpio_pin);
  */
 void send_raw_signal(const uint16_t* signal, size_t length);
 
+/**
+ * Envia um sinal RAW por um emissor especfico
+ * @return false se o emissor no existe
+ */
+bool send_raw_signal_on(uint8_t emitter, const uint16_t* signal, size_t length);
+
+/**
+ * Envia um sinal com chave de cache: o quadro quantizado fica na cache
+ * LRU e os prximos envios com a mesma chave comeam sem converso
+ * @param key Identifica o contedo do sinal (0 = no usa cache)
+ */
+bool send_raw_signal_keyed(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length);
+
+/**
+ * Envia um quadro de uma fonte sob demanda (bloqueia at o fim)
+ */
+bool send_source_keyed(uint8_t emitter, uint32_t key, ir_timing_source_t *src);
+
+/**
+ * Arma um quadro para comear em um instante absoluto. Os blocos e o DMA
+ * ficam prontos com o slice PWM parado; o alarme do timer liga o slice
+ * (emissores com o mesmo instante saem na mesma escrita de registrador)
+ * @param start Instante do incio da primeira marca no pino
+ * @return false se o emissor est ocupado ou o sinal no pde ser preparado
+ */
+bool custom_ir_arm(uint8_t emitter, uint32_t key, const uint16_t* signal, size_t length,
+                   absolute_time_t start);
+
+/**
+ * Igual a custom_ir_arm(), com os timings puxados da fonte. Com o quadro
+ * na cache (key), a fonte nem  lida; sem cache,  decodificada direto
+ * para os blocos do DMA ou a cada borda (backend de bordas)
+ */
+bool custom_ir_arm_source(uint8_t emitter, uint32_t key, ir_timing_source_t *src,
+                          absolute_time_t start);
+
+/**
+ * Estado das transmisses (armada ou em andamento conta como ocupado)
+ */
+bool custom_ir_busy(uint8_t emitter);
+bool custom_ir_any_busy(void);
+void custom_ir_wait(uint8_t emitter);
+void custom_ir_get_tx_stats(ir_tx_stats_t *stats);
+
+/**
+ * Estatsticas e limpeza da cache de quadros (o DMA l os blocos do
+ * emissor, ento limpar  seguro mesmo com quadros no ar)
+ */
+void custom_ir_cache_get_stats(ir_wave_cache_stats_t *stats);
+void custom_ir_cache_flush(void);
+
+/**
+ * Marcas do sinal como o emissor realmente as transmite (duraes
+ * quantizadas em ciclos da portadora; o quadro inteiro)
+ * @return Nmero de marcas escritas em 'out' (no mximo 'max')
+ */
+size_t custom_ir_mark_intervals(uint8_t emitter, const uint16_t* signal, size_t length,
+                                ir_interval_t *out, size_t max);
+
+/**
+ * Durao total (tempo no ar) de um sinal em microssegundos
+ */
+uint32_t ir_signal_duration_us(const uint16_t* signal, size_t length);
+
+#if !IR_BACKEND_EDGE
+/**
+ * Converte o quadro nos blocos de DMA do emissor, sem transmitir (a mesma
+ * converso do envio sem cache; usado pelo benchmark do host)
+ * @param src Fonte de timings no lugar de raw_signal (NULL = usa a tabela)
+ * @return false se o emissor est ocupado ou o quadro  vazio ou maior
+ *         que IR_MAX_FRAME_TIMINGS
+ */
+bool custom_ir_prepare_blocks(uint8_t emitter, const uint16_t* raw_signal, size_t raw_length,
+                              ir_timing_source_t *src);
+#endif
+
+/**
+ * Interrompe a transmisso em andamento e desliga a portadora
+ * (seguro em IRQ; usado no caminho de emergncia de queda de energia)
+ * @return true se havia transmisso em andamento
+ */
+bool custom_ir_abort(void);
+
+/**
+ * Cancela o quadro do emissor em um ponto seguro: espera o prximo espao
+ * (portadora desligada) e para ali; bloqueia no mximo uma marca
+ * @return true se havia quadro armado ou no ar
+ */
+bool custom_ir_cancel(uint8_t emitter);
+
+/**
+ * Instante (time_us_64) da primeira borda do ltimo quadro iniciado
+ */
+uint64_t custom_ir_started_at(uint8_t emitter);
+
+/**
+ * Instante (time_us_64) em que o ltimo quadro que chegou a sair terminou
+ * ou foi cortado (cancelado ainda armado no conta)
+ */
+uint64_t custom_ir_finished_at(uint8_t emitter);
+
+/**
+ * Envia um comando da biblioteca
+ * @return false se o comando no existe ou foi desabilitado
+ */
+bool send_ir_command(ir_command_id_t id);
+bool send_ir_command_on(uint8_t emitter, ir_command_id_t id);
+
+/**
+ * Acesso  tabela de um comando (para verificao de integridade)
+ * @return false se o id  invlido
+ */
+bool custom_ir_get_command(ir_command_id_t id, const uint16_t **timings, size_t *length,
+                           const char **name);
+
+/**
+ * Habilita/desabilita um comando (ex.: tabela com CRC divergente)
+ */
+void custom_ir_set_command_enabled(ir_command_id_t id, bool enabled);
+bool custom_ir_command_enabled(ir_command_id_t id);
+
 /**
  * Funes de convenincia para controle do AC
  */
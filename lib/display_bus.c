@@ -0,0 +1,152 @@
+/**
+ * Gerenciador de velocidade do I2C do OLED
+ * Sondagem por ACK, queda de velocidade por erros seguidos e tempo de flush
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "fb_mirror.h"
+#include "display_bus.h"
+
+// Velocidades tentadas, da mais alta para a mais baixa (Fm+, Fm, Sm)
+static const uint32_t bus_speeds[] = { 1000000, 800000, 400000, 100000 };
+#define BUS_LEVELS ((uint8_t)(sizeof(bus_speeds) / sizeof(bus_speeds[0])))
+
+// Byte de controle do SSD1306: 0x00 = sequência de comandos, 0x40 = dados
+#define CTRL_COMMANDS 0x00
+#define CTRL_DATA     0x40
+
+static i2c_inst_t *bus_i2c;
+static uint8_t bus_addr;
+static uint8_t error_streak = 0;
+static display_bus_stats_t stats;
+
+// Timeout de uma transferência: 4x o tempo nominal (9 bits/byte) + 1ms
+static uint32_t transfer_timeout_us(size_t len) {
+    return (uint32_t)((uint64_t)len * 9 * 1000000 * 4 / stats.baud) + 1000;
+}
+
+static bool bus_write(const uint8_t *buf, size_t len) {
+    int ret = i2c_write_timeout_us(bus_i2c, bus_addr, buf, len, false, transfer_timeout_us(len));
+    if (ret != (int)len) {
+        stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+static void set_level(uint8_t level) {
+    stats.level = level;
+    stats.baud = i2c_set_baudrate(bus_i2c, bus_speeds[level]);
+}
+
+// Janela de escrita (modo de endereçamento vertical: página varia primeiro)
+static bool write_window(uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    const uint8_t cmd[] = {
+        CTRL_COMMANDS,
+        SET_COL_ADDR, x0, x1,
+        SET_PAGE_ADDR, p0, p1,
+    };
+    return bus_write(cmd, sizeof(cmd));
+}
+
+// Uma rodada de sondagem: janela + uma página com padrões alternados
+static bool probe_round(uint8_t round) {
+    uint8_t page[1 + WIDTH];
+
+    page[0] = CTRL_DATA;
+    for (uint8_t i = 0; i < WIDTH; i++) {
+        page[1 + i] = ((i + round) & 1) ? 0xAA : 0x55;
+    }
+    return write_window(0, WIDTH - 1, 0, HEIGHT / 8 - 1) && bus_write(page, sizeof(page));
+}
+
+bool display_bus_init(i2c_inst_t *i2c, uint8_t address) {
+    bus_i2c = i2c;
+    bus_addr = address;
+    memset(&stats, 0, sizeof(stats));
+    i2c_init(i2c, bus_speeds[0]);
+
+    for (uint8_t level = 0; level < BUS_LEVELS; level++) {
+        set_level(level);
+        uint8_t round = 0;
+        while (round < DISPLAY_BUS_PROBE_ROUNDS && probe_round(round)) {
+            round++;
+        }
+        if (round == DISPLAY_BUS_PROBE_ROUNDS) {
+            // Erros da sondagem não contam para a operação
+            stats.errors = 0;
+            printf("Display I2C: %lu Hz\n", (unsigned long)stats.baud);
+            return true;
+        }
+        printf("Display I2C: falha em %lu Hz (rodada %u)\n",
+               (unsigned long)stats.baud, round);
+    }
+
+    printf("ERRO: display nao responde no I2C\n");
+    return false;
+}
+
+// Retângulo a enviar; a tela inteira sai direto do ram_buffer
+static uint8_t rect_buf[1 + WIDTH * (HEIGHT / 8)];
+
+static bool flush_once(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    if (!write_window(x0, x1, p0, p1)) {
+        return false;
+    }
+    if (x0 == 0 && x1 == ssd->width - 1 && p0 == 0 && p1 == ssd->pages - 1) {
+        return bus_write(ssd->ram_buffer, ssd->bufsize);
+    }
+
+    // Junta as páginas [p0, p1] de cada coluna na ordem do endereçamento vertical
+    uint8_t n = p1 - p0 + 1;
+    size_t len = 1;
+    rect_buf[0] = CTRL_DATA;
+    for (uint8_t x = x0; x <= x1; x++) {
+        memcpy(&rect_buf[len], &ssd->ram_buffer[1 + x * ssd->pages + p0], n);
+        len += n;
+    }
+    return bus_write(rect_buf, len);
+}
+
+bool display_bus_flush(ssd1306_t *ssd) {
+    return display_bus_flush_rect(ssd, 0, ssd->width - 1, 0, ssd->pages - 1);
+}
+
+bool display_bus_flush_rect(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    uint64_t t0 = time_us_64();
+    bool ok = flush_once(ssd, x0, x1, p0, p1) || flush_once(ssd, x0, x1, p0, p1);
+    uint32_t dt = (uint32_t)(time_us_64() - t0);
+
+    stats.flushes++;
+    if (!ok) {
+        stats.failed++;
+        // Erros seguidos: desce uma velocidade (a mais baixa fica)
+        if (++error_streak >= DISPLAY_BUS_ERROR_LIMIT && stats.level + 1 < BUS_LEVELS) {
+            set_level(stats.level + 1);
+            stats.fallbacks++;
+            error_streak = 0;
+            printf("Display I2C: erros seguidos, caindo para %lu Hz\n", (unsigned long)stats.baud);
+        }
+        return false;
+    }
+
+    error_streak = 0;
+    if (x1 - x0 + 1 < ssd->width || p1 - p0 + 1 < ssd->pages) {
+        stats.partial++;
+        stats.partial_last_us = dt;
+    } else {
+        // Tempos de flush: só telas inteiras, para serem comparáveis
+        stats.flush_last_us = dt;
+        stats.flush_sum_us += dt;
+        if (dt > stats.flush_max_us) stats.flush_max_us = dt;
+    }
+
+    // Fora do tempo medido: o espelho não entra no tempo de flush
+    fb_mirror_frame(&ssd->ram_buffer[1], ssd->bufsize - 1);
+    return true;
+}
+
+void display_bus_get_stats(display_bus_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,63 @@
+/**
+ * display_bus.h
+ * Velocidade do I2C do OLED: sondagem no boot, queda automática com erros
+ *
+ * No boot o barramento é testado da velocidade mais alta para a mais
+ * baixa: em cada uma, DISPLAY_BUS_PROBE_ROUNDS rodadas de comandos e de
+ * uma página de padrões alternados precisam ser todas confirmadas (ACK).
+ * O SSD1306 não permite ler a GDDRAM pelo I2C, então um NAK ou um timeout
+ * é o único sinal de erro disponível. A primeira velocidade sem erro é usada.
+ *
+ * Em operação, DISPLAY_BUS_ERROR_LIMIT flushes seguidos com erro derrubam
+ * o barramento para a próxima velocidade da lista.
+ */
+
+#ifndef DISPLAY_BUS_H
+#define DISPLAY_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "ssd1306.h"
+
+#define DISPLAY_BUS_PROBE_ROUNDS 16
+#define DISPLAY_BUS_ERROR_LIMIT  3     // flushes seguidos com erro antes de cair
+
+typedef struct {
+    uint32_t baud;              // velocidade efetiva (i2c_set_baudrate)
+    uint8_t level;              // índice na lista de velocidades (0 = mais alta)
+    uint32_t flushes;
+    uint32_t failed;            // flushes que não chegaram (nem na repetição)
+    uint32_t partial;           // flushes de um retângulo (sem a tela inteira)
+    uint32_t errors;            // transferências com NAK/timeout
+    uint32_t fallbacks;         // quedas de velocidade em operação
+    uint32_t partial_last_us;
+    uint32_t flush_last_us;     // tela inteira
+    uint32_t flush_max_us;
+    uint64_t flush_sum_us;      // telas inteiras sem erro
+} display_bus_stats_t;
+
+/**
+ * Inicializa o I2C e sonda a maior velocidade estável do display
+ * (chamar antes de ssd1306_config; a GDDRAM é sobrescrita na sondagem)
+ * @return false se o display não responde nem na velocidade mais baixa
+ */
+bool display_bus_init(i2c_inst_t *i2c, uint8_t address);
+
+/**
+ * Envia o ram_buffer inteiro (substitui ssd1306_send_data): endereços de
+ * coluna/página num único comando e os dados em seguida; repete uma vez
+ * em caso de erro
+ * @return false se o quadro não chegou ao display
+ */
+bool display_bus_flush(ssd1306_t *ssd);
+
+/**
+ * Envia só o retângulo de colunas [x0, x1] e páginas [p0, p1]
+ * @return false se o retângulo não chegou ao display
+ */
+bool display_bus_flush_rect(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1);
+
+void display_bus_get_stats(display_bus_stats_t *stats);
+
+#endif // DISPLAY_BUS_H
@@ -0,0 +1,128 @@
+/**
+ * Espelho do framebuffer do OLED: XOR contra o quadro anterior + RLE por página
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "crc32.h"
+#include "fb_mirror.h"
+
+#define WIDTH_PX   128
+#define PAGES      8
+#define FB_BYTES   (WIDTH_PX * PAGES)
+
+static bool enabled = false;
+static bool need_key = true;
+static uint32_t seq = 0;
+static uint32_t since_key = 0;
+static uint8_t last[FB_BYTES];          // último quadro enviado ao host
+static fb_mirror_stats_t stats;
+
+// Linha de saída: pior caso = 8 x (página + 128 literais + 2 ctrl), em hex
+static char hex_line[PAGES * (1 + WIDTH_PX + 2) * 2 + 1];
+static size_t hex_len;
+
+static inline void put_byte(uint8_t b) {
+    static const char digits[] = "0123456789ABCDEF";
+    hex_line[hex_len++] = digits[b >> 4];
+    hex_line[hex_len++] = digits[b & 0x0F];
+}
+
+// RLE de uma página do XOR (128 bytes); @return bytes emitidos
+static uint16_t encode_page(const uint8_t *delta) {
+    uint16_t out = 0;
+    uint8_t i = 0;
+
+    while (i < WIDTH_PX) {
+        uint8_t run = 1;
+        while (i + run < WIDTH_PX && delta[i + run] == delta[i] && run < 128) {
+            run++;
+        }
+        if (run >= 3) {
+            put_byte(0x80 | (run - 1));
+            put_byte(delta[i]);
+            out += 2;
+            i += run;
+            continue;
+        }
+
+        // Literais até a próxima repetição de 3 ou mais
+        uint8_t start = i;
+        while (i < WIDTH_PX &&
+               !(i + 2 < WIDTH_PX && delta[i] == delta[i + 1] && delta[i] == delta[i + 2])) {
+            i++;
+        }
+        put_byte(i - start - 1);
+        for (uint8_t k = start; k < i; k++) {
+            put_byte(delta[k]);
+        }
+        out += 1 + (i - start);
+    }
+    return out;
+}
+
+void fb_mirror_enable(bool enable) {
+    enabled = enable;
+    need_key = true;
+    stats.enabled = enable;
+}
+
+bool fb_mirror_enabled(void) {
+    return enabled;
+}
+
+void fb_mirror_frame(const uint8_t *fb, size_t len) {
+    if (!enabled || len != FB_BYTES) {
+        return;
+    }
+    if (!stdio_usb_connected()) {
+        need_key = true;                // host novo recebe a tela inteira
+        return;
+    }
+
+    bool key = need_key || since_key >= FB_MIRROR_KEY_INTERVAL;
+    if (key) {
+        memset(last, 0, sizeof(last));
+    }
+
+    uint8_t delta[WIDTH_PX];
+    uint16_t payload = 0;
+    hex_len = 0;
+
+    for (uint8_t p = 0; p < PAGES; p++) {
+        bool changed = false;
+        for (uint8_t x = 0; x < WIDTH_PX; x++) {
+            uint16_t idx = p + x * PAGES;
+            delta[x] = fb[idx] ^ last[idx];
+            changed |= delta[x] != 0;
+        }
+        if (!changed && !key) {
+            continue;
+        }
+        put_byte(p);
+        payload += 1 + encode_page(delta);
+    }
+
+    if (payload == 0) {
+        stats.unchanged++;
+        return;
+    }
+
+    memcpy(last, fb, FB_BYTES);
+    hex_line[hex_len] = '\0';
+    printf("@FB %c %lu %08lX %s\n", key ? 'K' : 'D', (unsigned long)seq++,
+           (unsigned long)crc32_compute(last, FB_BYTES), hex_line);
+
+    need_key = false;
+    since_key = key ? 0 : since_key + 1;
+    stats.frames++;
+    stats.keyframes += key;
+    stats.bytes_last = payload;
+    stats.bytes_sum += payload;
+}
+
+void fb_mirror_get_stats(fb_mirror_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,52 @@
+/**
+ * fb_mirror.h
+ * Espelho remoto do framebuffer do OLED pela USB (stdout)
+ *
+ * A cada flush, o ram_buffer é comparado com o último quadro enviado
+ * (XOR) e só as páginas alteradas saem, com RLE, numa linha de texto:
+ *
+ *   @FB <K|D> <seq> <crc32 do quadro> <hex>
+ *
+ * Payload: para cada página alterada, o número da página (0..7) seguido
+ * dos 128 bytes do XOR daquela página (coluna 0..127) em RLE:
+ *   ctrl 0x00-0x7F: (ctrl + 1) bytes literais; 0x80-0xFF: próximo byte
+ *   repetido (ctrl & 0x7F) + 1 vezes (mesmo formato de tools/img2oled.py)
+ *
+ * Quadro K (chave) é o XOR contra uma tela apagada: sai ao ativar, ao
+ * reconectar e a cada FB_MIRROR_KEY_INTERVAL quadros. O CRC permite ao
+ * visualizador (tools/fb_viewer.py) detectar perda e esperar a próxima
+ * chave. Sem host conectado, o custo por flush é um teste de flag.
+ */
+
+#ifndef FB_MIRROR_H
+#define FB_MIRROR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FB_MIRROR_KEY_INTERVAL 64
+
+typedef struct {
+    bool enabled;
+    uint32_t frames;            // quadros enviados (K + D)
+    uint32_t keyframes;
+    uint32_t unchanged;         // flushes iguais ao anterior (nada enviado)
+    uint32_t bytes_last;        // payload do último quadro (antes do hex)
+    uint64_t bytes_sum;
+} fb_mirror_stats_t;
+
+void fb_mirror_enable(bool enable);
+
+bool fb_mirror_enabled(void);
+
+/**
+ * Envia o quadro recém-transmitido ao display (chamado por display_bus_flush)
+ * @param fb ram_buffer sem o byte de controle (páginas por coluna)
+ * @param len tamanho em bytes (largura * páginas)
+ */
+void fb_mirror_frame(const uint8_t *fb, size_t len);
+
+void fb_mirror_get_stats(fb_mirror_stats_t *stats);
+
+#endif // FB_MIRROR_H
@@ -0,0 +1,41 @@
+/**
+ * flash_layout.h
+ * Mapa das áreas de dados no fim da flash (fora da imagem do firmware)
+ *
+ * Offsets relativos ao início da flash (como em flash_range_erase);
+ * para ler via XIP some XIP_BASE.
+ */
+
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+#include "hardware/flash.h"
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+// Armazenamento chave-valor: 2 setores alternados (kv_store.c)
+#define FLASH_KV_SECTORS      2
+#define FLASH_KV_OFFSET       (PICO_FLASH_SIZE_BYTES - FLASH_KV_SECTORS * FLASH_SECTOR_SIZE)
+
+// Registro de emergência em queda de energia: 1 setor mantido apagado
+// (powerfail_log.c), uma página por registro
+#define FLASH_PF_OFFSET       (FLASH_KV_OFFSET - FLASH_SECTOR_SIZE)
+
+// Trace de entradas gravado/reproduzido (input_trace.c): 1 setor
+#define FLASH_TRACE_OFFSET    (FLASH_PF_OFFSET - FLASH_SECTOR_SIZE)
+
+// Perfis de modelo de AC (ac_profile.c): 1 setor, uma página por perfil
+#define FLASH_PROFILE_OFFSET  (FLASH_TRACE_OFFSET - FLASH_SECTOR_SIZE)
+
+// Regras de automação compiladas (rule_engine.c): 1 setor
+#define FLASH_RULES_OFFSET    (FLASH_PROFILE_OFFSET - FLASH_SECTOR_SIZE)
+
+// Início das áreas de dados (o firmware precisa terminar antes daqui)
+#define FLASH_DATA_OFFSET     FLASH_RULES_OFFSET
+
+// Ponteiro XIP para uma área de dados
+#define FLASH_XIP_PTR(offset) ((const uint8_t *)(uintptr_t)(XIP_BASE + (offset)))
+
+#endif // FLASH_LAYOUT_H
@@ -0,0 +1,285 @@
+/**
+ * Tabela de estado da frota de aparelhos
+ * Planejamento das transmissões em grupos (emissor, protocolo, estado)
+ */
+
+#include <string.h>
+#include "fleet.h"
+
+// Depois disso a unidade só volta a ser tentada quando o desejado mudar
+#define FLEET_MAX_FAILURES 3
+
+static fleet_unit_t units[FLEET_MAX_UNITS];
+static uint8_t unit_count = 0;
+static fleet_stats_t stats;
+
+// Reafirmação: uma fatia de tempo por unidade, em rodízio
+static uint32_t reassert_interval_ms = 0;
+static uint32_t reassert_next_ms;
+static uint8_t reassert_cursor;
+
+static fleet_protocol_fn protocol_fn = NULL;
+
+void fleet_init(void) {
+    memset(units, 0, sizeof(units));
+    memset(&stats, 0, sizeof(stats));
+    unit_count = 0;
+    reassert_interval_ms = 0;
+    protocol_fn = NULL;
+}
+
+void fleet_set_protocol_fn(fleet_protocol_fn fn) {
+    protocol_fn = fn;
+}
+
+// Protocolo na hora do envio: o registro pode estar desatualizado
+static void fleet_refresh_protocol(fleet_unit_t *u) {
+    if (protocol_fn) {
+        u->protocol = protocol_fn(u->emitter);
+    }
+}
+
+int fleet_add_unit(uint8_t emitter, uint8_t protocol, char zone) {
+    if (unit_count >= FLEET_MAX_UNITS) {
+        return -1;
+    }
+    fleet_unit_t *u = &units[unit_count];
+    u->emitter = emitter;
+    u->protocol = protocol;
+    u->zone = zone;
+    u->desired = FLEET_STATE_UNKNOWN;
+    u->sent = FLEET_STATE_UNKNOWN;
+    return unit_count++;
+}
+
+uint8_t fleet_count(void) {
+    return unit_count;
+}
+
+const fleet_unit_t *fleet_get(uint8_t unit) {
+    return unit < unit_count ? &units[unit] : NULL;
+}
+
+// ============================================================================
+// COMANDOS (só alteram o estado desejado)
+// ============================================================================
+
+static bool fleet_set_unit(fleet_unit_t *u, uint8_t state, uint32_t now_ms) {
+    if (u->desired == state) {
+        return false;
+    }
+    u->desired = state;
+    u->changed_ms = now_ms;
+    u->failures = 0;
+    return true;
+}
+
+uint8_t fleet_set(uint8_t unit, uint8_t state, uint32_t now_ms) {
+    if (unit >= unit_count) return 0;
+    return fleet_set_unit(&units[unit], state, now_ms) ? 1 : 0;
+}
+
+uint8_t fleet_set_all(uint8_t state, uint32_t now_ms) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < unit_count; i++) {
+        n += fleet_set_unit(&units[i], state, now_ms);
+    }
+    return n;
+}
+
+uint8_t fleet_set_zone(char zone, uint8_t state, uint32_t now_ms) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < unit_count; i++) {
+        if (units[i].zone == zone) {
+            n += fleet_set_unit(&units[i], state, now_ms);
+        }
+    }
+    return n;
+}
+
+void fleet_mark_sent(uint8_t unit, uint8_t state, uint32_t now_ms) {
+    if (unit >= unit_count) return;
+    fleet_unit_t *u = &units[unit];
+    u->desired = state;
+    u->sent = state;
+    u->sent_ms = now_ms;
+    u->failures = 0;
+    u->tx_count++;
+}
+
+// ============================================================================
+// PLANEJAMENTO
+// ============================================================================
+
+static bool fleet_unit_pending(const fleet_unit_t *u) {
+    return u->desired != FLEET_STATE_UNKNOWN && u->desired != u->sent &&
+           u->failures < FLEET_MAX_FAILURES;
+}
+
+bool fleet_pending(void) {
+    for (uint8_t i = 0; i < unit_count; i++) {
+        if (fleet_unit_pending(&units[i])) return true;
+    }
+    return false;
+}
+
+// Chave de agrupamento: unidades com a mesma chave recebem o mesmo quadro
+static uint32_t fleet_group_key(const fleet_unit_t *u) {
+    return ((uint32_t)u->emitter << 16) | ((uint32_t)u->protocol << 8) | u->desired;
+}
+
+// Plano: quadros e a faixa de 'order' que cada um atende
+static uint8_t plan_order[FLEET_MAX_UNITS];
+static uint8_t plan_first[FLEET_MAX_UNITS + 1];
+static fleet_frame_t plan_frames[FLEET_MAX_UNITS];
+
+static uint8_t fleet_plan(void) {
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < unit_count; i++) {
+        if (fleet_unit_pending(&units[i])) {
+            fleet_refresh_protocol(&units[i]);
+            plan_order[n++] = i;
+        }
+    }
+
+    // Ordena por emissor/protocolo/estado (inserção: no máximo 8 itens)
+    for (uint8_t i = 1; i < n; i++) {
+        uint8_t cur = plan_order[i];
+        uint32_t key = fleet_group_key(&units[cur]);
+        int8_t j = i - 1;
+        while (j >= 0 && fleet_group_key(&units[plan_order[j]]) > key) {
+            plan_order[j + 1] = plan_order[j];
+            j--;
+        }
+        plan_order[j + 1] = cur;
+    }
+
+    uint8_t frames = 0;
+    for (uint8_t i = 0; i < n;) {
+        const fleet_unit_t *lead = &units[plan_order[i]];
+        uint32_t key = fleet_group_key(lead);
+        uint8_t end = i + 1;
+        while (end < n && fleet_group_key(&units[plan_order[end]]) == key) {
+            end++;
+        }
+        plan_first[frames] = i;
+        plan_frames[frames] = (fleet_frame_t){
+            .emitter = lead->emitter,
+            .protocol = lead->protocol,
+            .state = lead->desired,
+        };
+        frames++;
+        i = end;
+    }
+    plan_first[frames] = n;
+    return frames;
+}
+
+static uint8_t fleet_apply(uint8_t frames, uint32_t now_ms) {
+    uint8_t sent = 0;
+
+    for (uint8_t f = 0; f < frames; f++) {
+        const fleet_frame_t *fr = &plan_frames[f];
+        if (fr->ok) {
+            sent++;
+            stats.frames++;
+            stats.airtime_us += fr->airtime_us;
+            stats.unit_updates += plan_first[f + 1] - plan_first[f];
+        } else {
+            stats.failures++;
+        }
+
+        for (uint8_t k = plan_first[f]; k < plan_first[f + 1]; k++) {
+            fleet_unit_t *u = &units[plan_order[k]];
+            if (fr->ok) {
+                u->sent = u->desired;
+                u->sent_ms = now_ms;
+                u->failures = 0;
+                u->tx_count++;
+            } else {
+                u->failures++;
+            }
+        }
+    }
+    return sent;
+}
+
+uint8_t fleet_flush(fleet_send_fn send, uint32_t now_ms) {
+    uint8_t frames = fleet_plan();
+    for (uint8_t f = 0; f < frames; f++) {
+        fleet_frame_t *fr = &plan_frames[f];
+        fr->airtime_us = 0;
+        fr->ok = send(fr->emitter, fr->protocol, fr->state, &fr->airtime_us);
+    }
+    return fleet_apply(frames, now_ms);
+}
+
+uint8_t fleet_flush_batch(fleet_batch_fn send, uint32_t now_ms) {
+    uint8_t frames = fleet_plan();
+    if (frames > 0) {
+        send(plan_frames, frames);
+    }
+    return fleet_apply(frames, now_ms);
+}
+
+// ============================================================================
+// REAFIRMAÇÃO PERIÓDICA
+// ============================================================================
+
+void fleet_set_reassert(uint32_t interval_ms, uint32_t now_ms) {
+    reassert_interval_ms = interval_ms;
+    reassert_next_ms = now_ms + interval_ms;
+    reassert_cursor = 0;
+}
+
+// Fatia de cada unidade: o intervalo dividido pela frota
+static uint32_t reassert_slot_ms(void) {
+    uint32_t slot = reassert_interval_ms / (unit_count ? unit_count : 1);
+    return slot > FLEET_REASSERT_MIN_SLOT_MS ? slot : FLEET_REASSERT_MIN_SLOT_MS;
+}
+
+int fleet_reassert(fleet_send_fn send, uint32_t now_ms) {
+    if (reassert_interval_ms == 0 || unit_count == 0 ||
+        (int32_t)(now_ms - reassert_next_ms) < 0) {
+        return -1;
+    }
+    // Uma fatia por chamada; fatias perdidas (loop ocupado) não acumulam
+    reassert_next_ms = now_ms + reassert_slot_ms();
+    uint8_t i = reassert_cursor;
+    reassert_cursor = (reassert_cursor + 1) % unit_count;
+
+    // Pendentes são do fleet_flush(); quem desistiu espera novo comando
+    fleet_unit_t *u = &units[i];
+    if (u->sent == FLEET_STATE_UNKNOWN || u->desired != u->sent) {
+        return -1;
+    }
+    if (now_ms - u->sent_ms < reassert_interval_ms) {
+        stats.reassert_skipped++;
+        return -1;
+    }
+
+    uint32_t airtime_us = 0;
+    fleet_refresh_protocol(u);
+    if (!send(u->emitter, u->protocol, u->sent, &airtime_us)) {
+        stats.failures++;
+        return -1;
+    }
+    u->sent_ms = now_ms;
+    u->tx_count++;
+    stats.frames++;
+    stats.unit_updates++;
+    stats.airtime_us += airtime_us;
+    stats.reasserts++;
+    stats.reassert_airtime_us += airtime_us;
+    return i;
+}
+
+void fleet_add_reassert_airtime(uint32_t airtime_us) {
+    stats.airtime_us += airtime_us;
+    stats.reassert_airtime_us += airtime_us;
+}
+
+void fleet_get_stats(fleet_stats_t *out) {
+    *out = stats;
+}
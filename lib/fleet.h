@@ -0,0 +1,151 @@
+/**
+ * fleet.h
+ * Tabela de estado por aparelho e comandos em grupo (vários ACs na sala)
+ *
+ * Cada unidade guarda o estado desejado, o último estado transmitido e
+ * os instantes de cada um. Comandos ("todos desligados", "zona B em
+ * 20C") só alteram o desejado; fleet_flush() planeja as transmissões:
+ * unidades no mesmo emissor, com o mesmo protocolo e o mesmo estado
+ * desejado recebem um único quadro, e os grupos saem ordenados por
+ * emissor e protocolo.
+ *
+ * O IR não tem confirmação: um quadro perdido (alguém na frente do
+ * aparelho) deixa a unidade no estado errado até o próximo comando.
+ * Com a reafirmação ligada, fleet_reassert() reenvia o estado desejado
+ * de uma unidade por vez: o intervalo é dividido em fatias, uma por
+ * unidade, e cada fatia atende só a sua unidade (nunca duas reenviando
+ * juntas). Unidade que recebeu um quadro há menos de um intervalo perde a
+ * vez.
+ */
+
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FLEET_MAX_UNITS     8
+#define FLEET_STATE_UNKNOWN 0xFF    // nada transmitido ainda
+#define FLEET_REASSERT_MIN_SLOT_MS 2000     // entre duas reafirmações quaisquer
+
+typedef struct {
+    uint8_t emitter;        // índice do emissor (custom_ir)
+    uint8_t protocol;       // modelo/protocolo do aparelho
+    char zone;              // zona da sala ('A', 'B', ...)
+    uint8_t desired;        // estado desejado
+    uint8_t sent;           // último estado transmitido
+    uint8_t failures;       // falhas seguidas de envio
+    uint16_t tx_count;      // quadros que atingiram esta unidade
+    uint32_t changed_ms;    // quando o desejado mudou
+    uint32_t sent_ms;       // última transmissão
+} fleet_unit_t;
+
+typedef struct {
+    uint32_t frames;        // quadros transmitidos
+    uint32_t unit_updates;  // unidades atualizadas por esses quadros
+    uint32_t airtime_us;    // tempo total no ar
+    uint32_t failures;
+    uint32_t reasserts;             // quadros de reafirmação (contados também em frames)
+    uint32_t reassert_skipped;      // vezes perdidas por envio recente
+    uint32_t reassert_airtime_us;   // parte de airtime_us gasta reafirmando (medida)
+} fleet_stats_t;
+
+/**
+ * Transmite 'state' pelo emissor com o protocolo dado
+ * @param airtime_us Tempo no ar do quadro enviado
+ * @return false se o envio falhou
+ */
+typedef bool (*fleet_send_fn)(uint8_t emitter, uint8_t protocol, uint8_t state,
+                              uint32_t *airtime_us);
+
+// Um quadro do plano, para envio em lote (o transmissor preenche ok/airtime)
+typedef struct {
+    uint8_t emitter;
+    uint8_t protocol;
+    uint8_t state;
+    bool ok;
+    uint32_t airtime_us;
+} fleet_frame_t;
+
+/**
+ * Transmite todos os quadros do plano (podem sair simultâneos em emissores
+ * diferentes); preenche ok e airtime_us de cada um. Um transmissor
+ * assíncrono devolve ok = aceito para envio e o airtime previsto
+ */
+typedef void (*fleet_batch_fn)(fleet_frame_t *frames, uint8_t count);
+
+/**
+ * Protocolo atual do aparelho ligado ao emissor (ex: perfil de AC
+ * selecionado)
+ */
+typedef uint8_t (*fleet_protocol_fn)(uint8_t emitter);
+
+void fleet_init(void);
+
+/**
+ * Consulta o protocolo de cada unidade no planejamento, em vez de usar o
+ * do registro (o modelo do emissor pode mudar depois de fleet_add_unit)
+ * @param fn NULL = protocolo fixo do registro
+ */
+void fleet_set_protocol_fn(fleet_protocol_fn fn);
+
+/**
+ * @return Índice da unidade, ou -1 se a tabela está cheia
+ */
+int fleet_add_unit(uint8_t emitter, uint8_t protocol, char zone);
+
+uint8_t fleet_count(void);
+const fleet_unit_t *fleet_get(uint8_t unit);
+
+/**
+ * Altera o estado desejado (não transmite)
+ * @return Número de unidades afetadas
+ */
+uint8_t fleet_set(uint8_t unit, uint8_t state, uint32_t now_ms);
+uint8_t fleet_set_all(uint8_t state, uint32_t now_ms);
+uint8_t fleet_set_zone(char zone, uint8_t state, uint32_t now_ms);
+
+/**
+ * Registra um envio feito fora do planejador (caminho direto)
+ */
+void fleet_mark_sent(uint8_t unit, uint8_t state, uint32_t now_ms);
+
+/**
+ * @return true se alguma unidade está fora do estado desejado
+ */
+bool fleet_pending(void);
+
+/**
+ * Transmite o necessário para levar todas as unidades ao desejado
+ * @return Quadros transmitidos
+ */
+uint8_t fleet_flush(fleet_send_fn send, uint32_t now_ms);
+
+/**
+ * Igual a fleet_flush(), mas entrega todos os quadros de uma vez
+ * @return Quadros transmitidos
+ */
+uint8_t fleet_flush_batch(fleet_batch_fn send, uint32_t now_ms);
+
+/**
+ * Intervalo de reafirmação de cada unidade
+ * @param interval_ms 0 desliga
+ */
+void fleet_set_reassert(uint32_t interval_ms, uint32_t now_ms);
+
+/**
+ * Na fatia de tempo da vez, reenvia o estado da unidade correspondente se
+ * ela está em dia (desejado == transmitido) e sem quadro há um intervalo
+ * @return Índice da unidade reafirmada, ou -1
+ */
+int fleet_reassert(fleet_send_fn send, uint32_t now_ms);
+
+/**
+ * Soma o tempo no ar medido das reafirmações (o envio é assíncrono: o
+ * airtime devolvido pelo fleet_send_fn da reafirmação é só o já medido)
+ */
+void fleet_add_reassert_airtime(uint32_t airtime_us);
+
+void fleet_get_stats(fleet_stats_t *stats);
+
+#endif // FLEET_H
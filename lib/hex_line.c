@@ -0,0 +1,44 @@
+/**
+ * hex_line.c
+ * Decodificação das linhas hexadecimais coladas no console
+ */
+
+#include "hex_line.h"
+#include <string.h>
+
+static int hex_value(int ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    return -1;
+}
+
+void hex_line_begin(hex_line_t *line, uint8_t *buf, size_t max, const char *skip) {
+    line->buf = buf;
+    line->max = max;
+    line->length = 0;
+    line->skip = skip;
+    line->high = -1;
+    line->ok = true;
+}
+
+bool hex_line_feed(hex_line_t *line, int ch) {
+    if (ch == '\r' || ch == '\n') {
+        return false;
+    }
+    if (ch > 0 && strchr(line->skip, ch)) {
+        return true;
+    }
+    int v = hex_value(ch);
+    if (v < 0 || line->length >= line->max) {
+        line->ok = false;
+        return true;
+    }
+    if (line->high < 0) {
+        line->high = v;
+    } else {
+        line->buf[line->length++] = (uint8_t)(line->high << 4 | v);
+        line->high = -1;
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+/**
+ * hex_line.h
+ * Decodificação das linhas hexadecimais coladas no console (@AP, @TR)
+ *
+ * O chamador lê o console e entrega um caractere por vez; o decodificador
+ * ignora o resto do prefixo e os espaços, junta pares de dígitos em bytes
+ * e para no fim da linha. Sem dependências do SDK (também compila no host).
+ */
+
+#ifndef HEX_LINE_H
+#define HEX_LINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    uint8_t *buf;
+    size_t max;
+    size_t length;          // bytes decodificados
+    const char *skip;       // caracteres ignorados (resto do prefixo, espaço)
+    int high;               // nibble alto pendente, -1 = nenhum
+    bool ok;                // false: caractere inválido ou linha longa demais
+} hex_line_t;
+
+/**
+ * Começa uma linha
+ * @param buf Destino dos bytes
+ * @param max Tamanho de buf
+ * @param skip Caracteres a ignorar (ex.: "P " depois de "@A")
+ */
+void hex_line_begin(hex_line_t *line, uint8_t *buf, size_t max, const char *skip);
+
+/**
+ * Entrega um caractere
+ * @return false no fim da linha ('\r' ou '\n')
+ */
+bool hex_line_feed(hex_line_t *line, int ch);
+
+#endif // HEX_LINE_H
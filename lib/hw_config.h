@@ -0,0 +1,105 @@
+/**
+ * hw_config.h
+ * Configuração de hardware da placa (BitDogLab + Pico) conferida na compilação
+ *
+ * Todos os pinos fixos ficam aqui. O mapeamento do RP2040 (GPIO -> slice
+ * e canal PWM, GPIO -> instância e função I2C) é refeito em macros, para
+ * que os _Static_assert abaixo recusem na compilação:
+ *   - pino repetido entre duas funções ou fora do chip;
+ *   - SDA/SCL do display em pinos sem essa função na instância I2C usada;
+ *   - pino IR no mesmo slice PWM de outro pino da placa (o DMA escreve o
+ *     CC inteiro, o que replica a portadora nos canais A e B).
+ *
+ * O pino IR e os pinos do display podem ser trocados em campo (comando
+ * 'c'); hw_pins_valid() aplica as mesmas regras aos valores gravados.
+ */
+
+#ifndef HW_CONFIG_H
+#define HW_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HW_SYS_CLOCK_HZ     125000000u  // clk_sys padrão (PWM com clkdiv 1)
+#define HW_GPIO_COUNT       30
+
+// ===================== PINOS BITDOGLAB =====================
+#define LED_BOOT_RED     13   // LED vermelho: indica boot/reset
+#define LED_OK_GREEN     11   // LED verde: operação normal
+#define LED_TRAVA_BLUE   12   // LED azul: falha/travamento
+#define BOTAO_A           5   // Botão A: falha proposital
+#define BOTAO_B           6   // Botão B: comandos IR
+#define LED_PIN          25   // LED onboard do Pico
+#define HW_PIN_VSYS      29   // ADC3: VSYS/3 (power_monitor)
+
+// ===================== PINOS IR =====================
+#define IR_PIN           16   // Pino para saída IR
+
+// ===================== DISPLAY =====================
+#define HW_DISPLAY_I2C   1    // instância I2C do display
+#define I2C_PORT_DISP    (HW_DISPLAY_I2C ? i2c1 : i2c0)
+#define SDA_DISP         14
+#define SCL_DISP         15
+#define DISPLAY_ADDR     0x3C
+
+// ===================== MAPEAMENTO RP2040 =====================
+// Mesmas contas de pwm_gpio_to_slice_num()/pwm_gpio_to_channel()
+#define HW_PWM_SLICE(gpio)      (((gpio) >> 1) & 7u)
+#define HW_PWM_CHANNEL(gpio)    ((gpio) & 1u)
+#define HW_PWM_WRAP(freq_hz)    (HW_SYS_CLOCK_HZ / (freq_hz) - 1u)
+
+// Função I2C de cada GPIO: instância (gpio / 2) % 2, SDA nos pares
+#define HW_I2C_INDEX(gpio)      (((gpio) >> 1) & 1u)
+#define HW_I2C_IS_SDA(gpio)     (((gpio) & 1u) == 0)
+
+#define HW_PIN_BIT(gpio)        (1ull << (gpio))
+
+// Pinos que não mudam em campo
+#define HW_FIXED_PINS(op) \
+    (HW_PIN_BIT(LED_BOOT_RED) op HW_PIN_BIT(LED_OK_GREEN) op HW_PIN_BIT(LED_TRAVA_BLUE) op \
+     HW_PIN_BIT(BOTAO_A) op HW_PIN_BIT(BOTAO_B) op HW_PIN_BIT(LED_PIN) op HW_PIN_BIT(HW_PIN_VSYS))
+
+// Todos os pinos da placa; com pinos distintos, soma e OR dos bits coincidem
+#define HW_ALL_PINS(op) \
+    (HW_FIXED_PINS(op) op HW_PIN_BIT(IR_PIN) op HW_PIN_BIT(SDA_DISP) op HW_PIN_BIT(SCL_DISP))
+
+// ===================== VERIFICAÇÃO =====================
+_Static_assert(LED_BOOT_RED < HW_GPIO_COUNT && LED_OK_GREEN < HW_GPIO_COUNT &&
+               LED_TRAVA_BLUE < HW_GPIO_COUNT && BOTAO_A < HW_GPIO_COUNT &&
+               BOTAO_B < HW_GPIO_COUNT && LED_PIN < HW_GPIO_COUNT &&
+               HW_PIN_VSYS < HW_GPIO_COUNT && IR_PIN < HW_GPIO_COUNT &&
+               SDA_DISP < HW_GPIO_COUNT && SCL_DISP < HW_GPIO_COUNT,
+               "pino fora do RP2040");
+_Static_assert(HW_ALL_PINS(+) == HW_ALL_PINS(|), "pino usado por duas funcoes");
+_Static_assert(HW_PIN_VSYS >= 26, "VSYS precisa de um pino com ADC (26-29)");
+_Static_assert(HW_DISPLAY_I2C <= 1, "RP2040 tem i2c0 e i2c1");
+_Static_assert(HW_I2C_IS_SDA(SDA_DISP) && HW_I2C_INDEX(SDA_DISP) == HW_DISPLAY_I2C,
+               "SDA_DISP nao e SDA da instancia I2C do display");
+_Static_assert(!HW_I2C_IS_SDA(SCL_DISP) && HW_I2C_INDEX(SCL_DISP) == HW_DISPLAY_I2C,
+               "SCL_DISP nao e SCL da instancia I2C do display");
+_Static_assert((HW_ALL_PINS(|) & HW_PIN_BIT(IR_PIN ^ 1u)) == 0,
+               "o outro canal do slice PWM do IR_PIN esta em uso");
+
+/**
+ * Confere pinos trocados em campo com as regras acima
+ * @return false se algum pino conflita (usar os padrões)
+ */
+static inline bool hw_pins_valid(uint32_t ir_pin, uint32_t sda, uint32_t scl) {
+    if (ir_pin >= HW_GPIO_COUNT || sda >= HW_GPIO_COUNT || scl >= HW_GPIO_COUNT) {
+        return false;
+    }
+    uint64_t fixed = HW_FIXED_PINS(|);
+    uint64_t pins[] = { HW_PIN_BIT(ir_pin), HW_PIN_BIT(sda), HW_PIN_BIT(scl) };
+    uint64_t used = fixed;
+    for (unsigned i = 0; i < 3; i++) {
+        if (used & pins[i]) {
+            return false;
+        }
+        used |= pins[i];
+    }
+    return HW_I2C_IS_SDA(sda) && HW_I2C_INDEX(sda) == HW_DISPLAY_I2C &&
+           !HW_I2C_IS_SDA(scl) && HW_I2C_INDEX(scl) == HW_DISPLAY_I2C &&
+           (used & HW_PIN_BIT(ir_pin ^ 1u)) == 0;
+}
+
+#endif // HW_CONFIG_H
@@ -0,0 +1,416 @@
+/**
+ * Gravação e reprodução de entradas com o tempo
+ * Eventos compactos em RAM não inicializada, salvos em um setor de flash
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "hex_line.h"
+#include "power_monitor.h"
+#include "powerfail_log.h"
+#include "wdt_lease.h"
+#include "input_trace.h"
+
+// Códigos acima de 0x7F: botão (0x80 | botão<<1 | nível) e byte alto
+#define CODE_BUTTON         0x80
+#define CODE_HIGH_BYTE      0x8F
+
+#define TRACE_RAM_RECORDING 0x43455254u   // "TREC": gravação em andamento
+#define TRACE_ERASE_LEASE_MS 1000
+#define TRACE_EVENT_MAX     7             // varint de 5 bytes + código + byte
+
+// Setor inteiro em RAM: cabeçalho + eventos, pronto para programar
+static uint8_t __uninitialized_ram(trace_ram)[FLASH_SECTOR_SIZE] __attribute__((aligned(4)));
+static uint32_t __uninitialized_ram(trace_ram_state);
+
+#define trace_hdr    ((input_trace_header_t *)trace_ram)
+#define trace_data   (trace_ram + sizeof(input_trace_header_t))
+
+static input_trace_mode_t mode = INPUT_TRACE_IDLE;
+static bool trace_valid = false;        // trace_ram tem um trace completo
+static uint64_t t0_us;                  // início da gravação/reprodução
+static uint32_t last_ms;                // instante do último evento
+static uint16_t last_event_at;          // offset do último evento gravado
+static uint32_t undo_ms;                // last_ms antes do último evento
+static bool button_level[INPUT_BUTTON_COUNT];
+static input_trace_stats_t stats;
+
+// Reprodução: próximo evento já decodificado
+static uint16_t rp_pos;
+static uint32_t rp_due_ms;
+static uint8_t rp_code;
+static uint8_t rp_byte;
+static bool rp_has_next;
+
+static const input_trace_header_t *flash_hdr(void) {
+    return (const input_trace_header_t *)FLASH_XIP_PTR(FLASH_TRACE_OFFSET);
+}
+
+static uint32_t trace_crc(const input_trace_header_t *hdr, const uint8_t *data) {
+    uint32_t crc = crc32_update(CRC32_INIT, &hdr->length,
+                                offsetof(input_trace_header_t, flags) -
+                                offsetof(input_trace_header_t, length));
+    return crc32_update(crc, data, hdr->length);
+}
+
+static bool header_ok(const input_trace_header_t *hdr) {
+    return hdr->magic == INPUT_TRACE_MAGIC && hdr->length <= INPUT_TRACE_MAX_BYTES;
+}
+
+// ===== FLASH =====
+// Com VSYS sem folga o trace fica só na RAM (o da flash não muda)
+static bool save_to_flash(void) {
+    trace_hdr->magic = INPUT_TRACE_MAGIC;
+    trace_hdr->reserved = 0;
+    trace_hdr->crc = trace_crc(trace_hdr, trace_data);
+    trace_ram_state = 0;
+    trace_valid = true;
+
+    // Só as páginas usadas; o resto do setor fica apagado
+    size_t size = sizeof(input_trace_header_t) + trace_hdr->length;
+    size = (size + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1);
+
+    if (!power_monitor_flash_ok()) {
+        return false;
+    }
+    bool leased = wdt_lease_begin(TRACE_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(FLASH_TRACE_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(FLASH_TRACE_OFFSET, trace_ram, size);
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+    return true;
+}
+
+static bool load_from_flash(void) {
+    const input_trace_header_t *hdr = flash_hdr();
+    if (!header_ok(hdr)) {
+        return false;
+    }
+    const uint8_t *data = (const uint8_t *)(hdr + 1);
+    if (hdr->crc != trace_crc(hdr, data)) {
+        printf("Trace: CRC invalido na flash\n");
+        return false;
+    }
+    memcpy(trace_ram, hdr, sizeof(input_trace_header_t) + hdr->length);
+    return true;
+}
+
+static void print_summary(const char *what) {
+    printf("Trace %s: %u eventos, %u bytes, %lums\n", what, trace_hdr->events,
+           trace_hdr->length, (unsigned long)trace_hdr->duration_ms);
+}
+
+// Exporta o setor (cabeçalho + eventos) numa linha só
+static void dump_line(void) {
+    printf("@TR ");
+    for (size_t i = 0; i < sizeof(input_trace_header_t) + trace_hdr->length; i++) {
+        printf("%02X", trace_ram[i]);
+    }
+    printf("\n");
+}
+
+void input_trace_init(void) {
+    mode = INPUT_TRACE_IDLE;
+
+    // Reset (watchdog) no meio de uma gravação: a RAM ainda tem os eventos
+    if (trace_ram_state == TRACE_RAM_RECORDING && header_ok(trace_hdr)) {
+        save_to_flash();
+        print_summary("interrompido por reset, salvo");
+        return;
+    }
+    trace_ram_state = 0;
+    trace_valid = load_from_flash();
+    if (trace_valid) {
+        print_summary("na flash");
+    }
+}
+
+bool input_trace_boot_replay(void) {
+    return trace_valid && (trace_hdr->flags & INPUT_TRACE_FLAG_BOOT);
+}
+
+input_trace_mode_t input_trace_mode(void) {
+    return mode;
+}
+
+// ===== GRAVAÇÃO =====
+bool input_trace_record_start(void) {
+    if (mode != INPUT_TRACE_IDLE) {
+        return false;
+    }
+    memset(trace_hdr, 0, sizeof(input_trace_header_t));
+    trace_hdr->magic = INPUT_TRACE_MAGIC;
+    trace_hdr->flags = 0;
+    trace_valid = false;
+    trace_ram_state = TRACE_RAM_RECORDING;
+
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        button_level[i] = true;     // solto (pull-up)
+    }
+    t0_us = time_us_64();
+    last_ms = 0;
+    mode = INPUT_TRACE_RECORD;
+    printf("Trace: gravando (r para parar, max %u bytes)\n", (unsigned)INPUT_TRACE_MAX_BYTES);
+    return true;
+}
+
+static void record_event(uint8_t code, uint8_t byte) {
+    uint32_t now_ms = (uint32_t)((time_us_64() - t0_us) / 1000);
+    uint16_t pos = trace_hdr->length;
+
+    if ((size_t)pos + TRACE_EVENT_MAX > INPUT_TRACE_MAX_BYTES) {
+        printf("Trace: buffer cheio\n");
+        input_trace_stop();
+        return;
+    }
+    uint32_t delta = now_ms - last_ms;
+    do {
+        trace_data[pos++] = (uint8_t)((delta & 0x7F) | (delta > 0x7F ? 0x80 : 0));
+        delta >>= 7;
+    } while (delta);
+    trace_data[pos++] = code;
+    if (code == CODE_HIGH_BYTE) {
+        trace_data[pos++] = byte;
+    }
+
+    last_event_at = trace_hdr->length;
+    undo_ms = last_ms;
+    last_ms = now_ms;
+    trace_hdr->length = pos;
+    trace_hdr->events++;
+    trace_hdr->duration_ms = now_ms;
+}
+
+static void record_byte(uint8_t ch) {
+    if (ch < CODE_BUTTON) {
+        record_event(ch, 0);
+    } else {
+        record_event(CODE_HIGH_BYTE, ch);
+    }
+}
+
+// ===== REPRODUÇÃO =====
+static bool replay_decode_next(void) {
+    uint32_t delta = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+
+    if (rp_pos >= trace_hdr->length) {
+        return false;
+    }
+    do {
+        b = trace_data[rp_pos++];
+        delta |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && rp_pos < trace_hdr->length);
+    if (rp_pos >= trace_hdr->length) {
+        return false;
+    }
+    rp_code = trace_data[rp_pos++];
+    if (rp_code == CODE_HIGH_BYTE) {
+        if (rp_pos >= trace_hdr->length) return false;
+        rp_byte = trace_data[rp_pos++];
+    } else {
+        rp_byte = rp_code;
+    }
+    rp_due_ms += delta;
+    return true;
+}
+
+bool input_trace_replay_start(void) {
+    if (mode != INPUT_TRACE_IDLE || !trace_valid || trace_hdr->events == 0) {
+        return false;
+    }
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+        button_level[i] = true;
+    }
+    rp_pos = 0;
+    rp_due_ms = 0;
+    rp_has_next = replay_decode_next();
+    if (!rp_has_next) {
+        return false;
+    }
+    stats.position = 0;
+    stats.late_last_us = 0;
+    stats.late_max_us = 0;
+    stats.late_sum_us = 0;
+    t0_us = time_us_64();
+    mode = INPUT_TRACE_REPLAY;
+    print_summary("reproduzindo");
+    return true;
+}
+
+static uint64_t replay_due_us(void) {
+    return t0_us + (uint64_t)rp_due_ms * 1000;
+}
+
+// Entrega o próximo evento (já vencido) e decodifica o seguinte
+static void replay_consume(uint64_t now) {
+    uint32_t late = (uint32_t)(now - replay_due_us());
+    stats.late_last_us = late;
+    stats.late_sum_us += late;
+    if (late > stats.late_max_us) stats.late_max_us = late;
+    stats.position++;
+
+    rp_has_next = replay_decode_next();
+    if (!rp_has_next) {
+        input_trace_stop();
+    }
+}
+
+static bool replay_next_is_button(void) {
+    return rp_code >= CODE_BUTTON && rp_code < CODE_BUTTON + 2 * INPUT_BUTTON_COUNT;
+}
+
+// Botões vencidos entram sozinhos; bytes esperam o próximo getchar
+static void replay_buttons(uint64_t now) {
+    while (mode == INPUT_TRACE_REPLAY && replay_next_is_button() && now >= replay_due_us()) {
+        button_level[(rp_code - CODE_BUTTON) >> 1] = rp_code & 1;
+        replay_consume(now);
+    }
+}
+
+void input_trace_stop(void) {
+    if (mode == INPUT_TRACE_RECORD) {
+        mode = INPUT_TRACE_IDLE;
+        trace_hdr->duration_ms = (uint32_t)((time_us_64() - t0_us) / 1000);
+        print_summary(save_to_flash() ? "gravado" : "gravado so na RAM");
+        dump_line();
+    } else if (mode == INPUT_TRACE_REPLAY) {
+        mode = INPUT_TRACE_IDLE;
+        uint32_t elapsed_ms = (uint32_t)((time_us_64() - t0_us) / 1000);
+        printf("Reproducao %s: %u/%u eventos em %lums, atraso medio %luus, max %luus\n",
+               rp_has_next ? "interrompida" : "concluida",
+               stats.position, trace_hdr->events, (unsigned long)elapsed_ms,
+               (unsigned long)(stats.position ? stats.late_sum_us / stats.position : 0),
+               (unsigned long)stats.late_max_us);
+    }
+}
+
+void input_trace_console(char cmd) {
+    if (mode == INPUT_TRACE_RECORD) {
+        // O comando acabou de ser gravado como byte do console: remove
+        trace_hdr->length = last_event_at;
+        trace_hdr->events--;
+        last_ms = undo_ms;
+        if (cmd == 'r') {
+            input_trace_stop();
+        } else {
+            printf("Trace: gravando, 'r' para parar\n");
+        }
+        return;
+    }
+    if (cmd == 'r') {
+        input_trace_record_start();
+    } else if (mode == INPUT_TRACE_REPLAY) {
+        input_trace_stop();
+    } else if (!input_trace_replay_start()) {
+        printf("Trace: nada gravado\n");
+    }
+}
+
+// ===== ENTRADAS =====
+bool input_trace_button(input_button_t button, bool level) {
+    if (mode == INPUT_TRACE_REPLAY) {
+        replay_buttons(time_us_64());
+        return mode == INPUT_TRACE_REPLAY ? button_level[button] : level;
+    }
+    if (mode == INPUT_TRACE_RECORD && level != button_level[button]) {
+        button_level[button] = level;
+        record_event((uint8_t)(CODE_BUTTON | (button << 1) | level), 0);
+    }
+    return level;
+}
+
+int input_trace_getchar(uint32_t timeout_us) {
+    // Esperas do console são ponto seguro para gravar a queda de energia
+    powerfail_log_service();
+    if (mode != INPUT_TRACE_REPLAY) {
+        int ch = getchar_timeout_us(timeout_us);
+        if (ch != PICO_ERROR_TIMEOUT && mode == INPUT_TRACE_RECORD) {
+            record_byte((uint8_t)ch);
+        }
+        return ch;
+    }
+
+    uint64_t now = time_us_64();
+    replay_buttons(now);
+
+    // Espera no máximo até o próximo byte vencer; um 'p' real interrompe
+    uint32_t wait = timeout_us;
+    if (mode == INPUT_TRACE_REPLAY && !replay_next_is_button()) {
+        uint64_t due = replay_due_us();
+        if (due <= now) {
+            wait = 0;
+        } else if (due - now < wait) {
+            wait = (uint32_t)(due - now);
+        }
+    }
+    if (getchar_timeout_us(wait) == 'p') {
+        input_trace_stop();
+        return PICO_ERROR_TIMEOUT;
+    }
+
+    now = time_us_64();
+    if (mode == INPUT_TRACE_REPLAY && !replay_next_is_button() && now >= replay_due_us()) {
+        uint8_t ch = rp_byte;
+        replay_consume(now);
+        return ch;
+    }
+    return PICO_ERROR_TIMEOUT;
+}
+
+// ===== IMPORTAÇÃO =====
+bool input_trace_load_line(void) {
+    if (mode != INPUT_TRACE_IDLE) {
+        printf("Trace: ocupado\n");
+        return false;
+    }
+    absolute_time_t deadline = make_timeout_time_ms(INPUT_TRACE_LOAD_MS);
+    hex_line_t line;
+
+    trace_valid = false;
+    hex_line_begin(&line, trace_ram, FLASH_SECTOR_SIZE, "TR ");
+    bool leased = wdt_lease_begin(INPUT_TRACE_LOAD_MS + 100, WDT_LEASE_CONSOLE);
+    while (!time_reached(deadline)) {
+        powerfail_log_service();
+        int ch = getchar_timeout_us(1000);
+        if (ch == PICO_ERROR_TIMEOUT) {
+            continue;
+        }
+        if (!hex_line_feed(&line, ch)) {
+            break;
+        }
+    }
+    if (leased) {
+        wdt_lease_end();
+    }
+
+    size_t n = line.length;
+    if (!line.ok || n < sizeof(input_trace_header_t) || !header_ok(trace_hdr) ||
+        n != sizeof(input_trace_header_t) + trace_hdr->length ||
+        trace_hdr->crc != trace_crc(trace_hdr, trace_data)) {
+        printf("Trace: linha @TR invalida (%u bytes)\n", (unsigned)n);
+        trace_valid = load_from_flash();
+        return false;
+    }
+    trace_hdr->flags &= ~INPUT_TRACE_FLAG_BOOT;
+    print_summary(save_to_flash() ? "carregado" : "carregado so na RAM");
+    return true;
+}
+
+void input_trace_get_stats(input_trace_stats_t *out) {
+    *out = stats;
+    out->mode = mode;
+    out->length = trace_hdr->length;
+    out->events = trace_hdr->events;
+    out->duration_ms = trace_hdr->duration_ms;
+}
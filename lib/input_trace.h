@@ -0,0 +1,124 @@
+/**
+ * input_trace.h
+ * Gravação e reprodução das entradas (botões e console) com o tempo
+ *
+ * Cada evento ocupa 2 a 4 bytes: intervalo desde o evento anterior em ms
+ * (varint, 7 bits por byte) + código. Códigos 0x00-0x7F são o próprio
+ * byte do console; botões e bytes altos têm códigos próprios. A gravação
+ * fica em RAM não inicializada (sobrevive ao reset do watchdog) e vai
+ * para um setor de flash ao parar ou no boot seguinte a um reset.
+ *
+ * A reprodução entrega os mesmos eventos, na mesma ordem, nos mesmos
+ * instantes relativos ao início; botões e console reais são ignorados
+ * (um 'p' real interrompe). O atraso de cada entrega é medido, então o
+ * mesmo trace serve de teste de regressão e de desempenho, na placa ou
+ * no simulador (tools/host/fleet_sim -r).
+ *
+ * Exportação: linha "@TR <hex>" com o setor inteiro (cabeçalho + eventos).
+ * Colar a mesma linha no console de outra placa carrega o trace.
+ */
+
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_layout.h"
+
+#define INPUT_TRACE_MAGIC       0x31525449u   // "ITR1"
+#define INPUT_TRACE_FLAG_BOOT   0x0001        // reproduz logo no boot
+#define INPUT_TRACE_LOAD_MS     10000         // prazo para colar uma linha @TR
+
+typedef struct {
+    uint32_t magic;
+    uint16_t length;        // bytes de eventos após o cabeçalho
+    uint16_t events;
+    uint32_t duration_ms;   // do início da gravação até a parada
+    uint16_t flags;         // INPUT_TRACE_FLAG_* (fora do CRC)
+    uint16_t reserved;
+    uint32_t crc;           // CRC de length a duration_ms + eventos
+} input_trace_header_t;
+
+#define INPUT_TRACE_MAX_BYTES   (FLASH_SECTOR_SIZE - sizeof(input_trace_header_t))
+
+typedef enum {
+    INPUT_TRACE_IDLE = 0,
+    INPUT_TRACE_RECORD,
+    INPUT_TRACE_REPLAY,
+} input_trace_mode_t;
+
+typedef enum {
+    INPUT_BUTTON_A = 0,
+    INPUT_BUTTON_B,
+    INPUT_BUTTON_COUNT
+} input_button_t;
+
+typedef struct {
+    input_trace_mode_t mode;
+    uint16_t length;            // bytes do trace atual
+    uint16_t events;
+    uint32_t duration_ms;
+    uint16_t position;          // eventos já entregues na reprodução
+    uint32_t late_last_us;      // atraso da entrega vs. instante gravado
+    uint32_t late_max_us;
+    uint64_t late_sum_us;
+} input_trace_stats_t;
+
+/**
+ * Carrega o trace salvo e, se um reset interrompeu uma gravação, salva
+ * o que estava na RAM (chamar depois de kv_store_init)
+ */
+void input_trace_init(void);
+
+/**
+ * @return true se o trace salvo pede reprodução no boot
+ */
+bool input_trace_boot_replay(void);
+
+/**
+ * Começa a gravar (descarta o trace em RAM)
+ * @return false se já está gravando ou reproduzindo
+ */
+bool input_trace_record_start(void);
+
+/**
+ * Começa a reproduzir o trace salvo
+ * @return false se não há trace ou já está ocupado
+ */
+bool input_trace_replay_start(void);
+
+/**
+ * Para a gravação (salva na flash e exporta @TR) ou a reprodução (resumo)
+ */
+void input_trace_stop(void);
+
+/**
+ * Comandos do console: 'r' liga/desliga a gravação, 'p' a reprodução.
+ * O próprio comando não entra no trace.
+ */
+void input_trace_console(char cmd);
+
+/**
+ * Lê uma linha "TR <hex>" (o '@' já foi lido) e grava o trace na flash
+ * @return false se a linha é inválida
+ */
+bool input_trace_load_line(void);
+
+/**
+ * Nível efetivo de um botão
+ * @param button Botão
+ * @param level Nível lido do pino (gravado se mudou)
+ * @return O próprio nível, ou o nível reproduzido
+ */
+bool input_trace_button(input_button_t button, bool level);
+
+/**
+ * getchar_timeout_us com gravação/reprodução
+ * @return Byte, ou PICO_ERROR_TIMEOUT
+ */
+int input_trace_getchar(uint32_t timeout_us);
+
+input_trace_mode_t input_trace_mode(void);
+void input_trace_get_stats(input_trace_stats_t *stats);
+
+#endif // INPUT_TRACE_H
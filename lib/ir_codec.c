@@ -0,0 +1,390 @@
+/**
+ * ir_codec.c
+ * Compressão de quadros RAW: níveis aprendidos + Huffman canônico
+ */
+
+#include "ir_codec.h"
+#include <string.h>
+
+// ===== FORMATO =====
+
+#define HEADER_SIZE         sizeof(ir_codec_header_t)
+#define SYMBOL_SIZE         4       // marca + espaço (uint16_t cada)
+
+static size_t table_size(uint8_t symbols) {
+    return HEADER_SIZE + (size_t)symbols * SYMBOL_SIZE + (symbols + 1u) / 2u;
+}
+
+static void put_u16(uint8_t *dst, uint16_t value) {
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *src) {
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+size_t ir_codec_max_size(size_t count) {
+    // Pior caso: todos os símbolos com o código mais longo
+    size_t pairs = (count + 1) / 2;
+    return table_size(IR_CODEC_MAX_SYMBOLS) + (pairs * IR_CODEC_MAX_CODE_BITS + 7) / 8;
+}
+
+// ===== QUANTIZAÇÃO =====
+
+typedef struct {
+    uint8_t count;
+    uint16_t upper[IR_CODEC_MAX_SYMBOLS];   // maior duração do nível
+    uint16_t center[IR_CODEC_MAX_SYMBOLS];  // média arredondada
+} levels_t;
+
+// Agrupa os timings de mesma paridade (marcas ou espaços). Cada nível
+// começa na menor duração ainda sem nível e vai até TOLERANCE_PCT acima.
+static bool find_levels(const uint16_t *timings, size_t count, size_t first, levels_t *lv) {
+    uint32_t floor_us = 0;      // durações já agrupadas ficam abaixo disto
+
+    lv->count = 0;
+    while (true) {
+        uint32_t low = UINT32_MAX;
+        for (size_t i = first; i < count; i += 2) {
+            if (timings[i] >= floor_us && timings[i] < low) {
+                low = timings[i];
+            }
+        }
+        if (low == UINT32_MAX) {
+            return true;
+        }
+        if (lv->count == IR_CODEC_MAX_SYMBOLS) {
+            return false;
+        }
+
+        uint32_t high = low + low * IR_CODEC_TOLERANCE_PCT / 100;
+        uint32_t sum = 0, members = 0, top = low;
+        for (size_t i = first; i < count; i += 2) {
+            if (timings[i] >= low && timings[i] <= high) {
+                sum += timings[i];
+                members++;
+                if (timings[i] > top) {
+                    top = timings[i];
+                }
+            }
+        }
+        lv->upper[lv->count] = (uint16_t)top;
+        lv->center[lv->count] = (uint16_t)((sum + members / 2) / members);
+        lv->count++;
+        floor_us = top + 1;
+    }
+}
+
+static uint8_t level_of(const levels_t *lv, uint16_t value) {
+    uint8_t k = 0;
+    while (k + 1 < lv->count && value > lv->upper[k]) {
+        k++;
+    }
+    return k;
+}
+
+// ===== HUFFMAN =====
+
+// Comprimentos dos códigos; se passar do limite, as frequências são
+// reduzidas à metade (mínimo 1) até a árvore caber
+static void huffman_lengths(const uint32_t *freq, uint8_t n, uint8_t *len) {
+    uint32_t weight[2 * IR_CODEC_MAX_SYMBOLS];
+    uint8_t parent[2 * IR_CODEC_MAX_SYMBOLS];
+    bool active[2 * IR_CODEC_MAX_SYMBOLS];
+    uint32_t scaled[IR_CODEC_MAX_SYMBOLS];
+
+    if (n == 1) {
+        len[0] = 0;     // símbolo único: nenhum bit por par
+        return;
+    }
+    memcpy(scaled, freq, n * sizeof(scaled[0]));
+
+    while (true) {
+        uint8_t nodes = n;
+        for (uint8_t i = 0; i < n; i++) {
+            weight[i] = scaled[i];
+            active[i] = true;
+        }
+        for (uint8_t merges = 0; merges < n - 1; merges++) {
+            int a = -1, b = -1;
+            for (int i = 0; i < nodes; i++) {
+                if (!active[i]) continue;
+                if (a < 0 || weight[i] < weight[a]) {
+                    b = a;
+                    a = i;
+                } else if (b < 0 || weight[i] < weight[b]) {
+                    b = i;
+                }
+            }
+            weight[nodes] = weight[a] + weight[b];
+            active[nodes] = true;
+            active[a] = active[b] = false;
+            parent[a] = parent[b] = nodes;
+            nodes++;
+        }
+
+        uint8_t root = nodes - 1;
+        bool fits = true;
+        for (uint8_t i = 0; i < n; i++) {
+            uint8_t depth = 0;
+            for (uint8_t node = i; node != root; node = parent[node]) {
+                depth++;
+            }
+            len[i] = depth;
+            if (depth > IR_CODEC_MAX_CODE_BITS) {
+                fits = false;
+            }
+        }
+        if (fits) {
+            return;
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            scaled[i] = (scaled[i] + 1) / 2;
+        }
+    }
+}
+
+// Ordem canônica: comprimento crescente, depois índice do símbolo
+static void canonical_order(const uint8_t *len, uint8_t n, uint8_t *sorted) {
+    uint8_t k = 0;
+    for (uint8_t l = 0; l <= IR_CODEC_MAX_CODE_BITS; l++) {
+        for (uint8_t s = 0; s < n; s++) {
+            if (len[s] == l) {
+                sorted[k++] = s;
+            }
+        }
+    }
+}
+
+// ===== CODIFICAÇÃO =====
+
+size_t ir_codec_encode(const uint16_t *timings, size_t count,
+                       uint8_t *out, size_t max, ir_codec_info_t *info) {
+    levels_t marks, spaces;
+    uint16_t pair_mark[IR_CODEC_MAX_SYMBOLS];
+    uint16_t pair_space[IR_CODEC_MAX_SYMBOLS];
+    uint32_t freq[IR_CODEC_MAX_SYMBOLS] = {0};
+    uint8_t len[IR_CODEC_MAX_SYMBOLS];
+    uint8_t sorted[IR_CODEC_MAX_SYMBOLS];
+    uint16_t code[IR_CODEC_MAX_SYMBOLS];
+    uint8_t symbols = 0;
+
+    if (count == 0 || count > UINT16_MAX) {
+        return 0;
+    }
+    if (!find_levels(timings, count, 0, &marks) || !find_levels(timings, count, 1, &spaces)) {
+        return 0;
+    }
+
+    // Primeira passada: tabela de pares (índices de nível) e frequências
+    size_t pairs = (count + 1) / 2;
+    for (size_t p = 0; p < pairs; p++) {
+        uint16_t m = level_of(&marks, timings[2 * p]);
+        bool lone = (2 * p + 1 >= count);
+        uint16_t s = lone ? UINT16_MAX : level_of(&spaces, timings[2 * p + 1]);
+        uint8_t k;
+        for (k = 0; k < symbols; k++) {
+            if (pair_mark[k] == m && (lone || pair_space[k] == s)) {
+                break;
+            }
+        }
+        if (k == symbols) {
+            if (symbols == IR_CODEC_MAX_SYMBOLS) {
+                return 0;
+            }
+            pair_mark[k] = m;
+            pair_space[k] = s;
+            symbols++;
+        }
+        freq[k]++;
+    }
+
+    huffman_lengths(freq, symbols, len);
+    canonical_order(len, symbols, sorted);
+    uint16_t next_code = 0;
+    uint8_t prev_len = len[sorted[0]];
+    for (uint8_t i = 0; i < symbols; i++) {
+        uint8_t s = sorted[i];
+        next_code <<= (len[s] - prev_len);
+        code[s] = next_code++;
+        prev_len = len[s];
+    }
+
+    uint32_t bits = 0;
+    for (uint8_t s = 0; s < symbols; s++) {
+        bits += freq[s] * len[s];
+    }
+    size_t total = table_size(symbols) + (bits + 7) / 8;
+    if (total > max) {
+        return 0;
+    }
+
+    // Cabeçalho, tabela de níveis e comprimentos
+    memset(out, 0, total);
+    out[0] = IR_CODEC_VERSION;
+    out[1] = symbols;
+    put_u16(&out[2], (uint16_t)count);
+    uint8_t *pos = out + HEADER_SIZE;
+    for (uint8_t s = 0; s < symbols; s++) {
+        put_u16(pos, marks.center[pair_mark[s]]);
+        put_u16(pos + 2, pair_space[s] == UINT16_MAX ? 0 : spaces.center[pair_space[s]]);
+        pos += SYMBOL_SIZE;
+    }
+    for (uint8_t s = 0; s < symbols; s++) {
+        pos[s / 2] |= (uint8_t)(len[s] << ((s & 1) * 4));
+    }
+    pos += (symbols + 1) / 2;
+
+    // Segunda passada: códigos e erro de quantização
+    uint32_t bit_pos = 0;
+    uint16_t max_err = 0;
+    uint8_t max_pct = 0;
+    for (size_t p = 0; p < pairs; p++) {
+        uint16_t m = level_of(&marks, timings[2 * p]);
+        bool lone = (2 * p + 1 >= count);
+        uint16_t sp = lone ? UINT16_MAX : level_of(&spaces, timings[2 * p + 1]);
+        uint8_t k = 0;
+        while (pair_mark[k] != m || (!lone && pair_space[k] != sp)) {
+            k++;
+        }
+        for (uint8_t b = len[k]; b > 0; b--, bit_pos++) {
+            if (code[k] & (1u << (b - 1))) {
+                pos[bit_pos / 8] |= (uint8_t)(0x80 >> (bit_pos % 8));
+            }
+        }
+
+        for (size_t i = 2 * p; i < 2 * p + 2 && i < count; i++) {
+            uint16_t level = (i & 1) ? spaces.center[sp] : marks.center[m];
+            uint16_t err = (uint16_t)(timings[i] > level ? timings[i] - level : level - timings[i]);
+            uint8_t pct = timings[i] ? (uint8_t)((uint32_t)err * 100 / timings[i]) : 0;
+            if (err > max_err) max_err = err;
+            if (pct > max_pct) max_pct = pct;
+        }
+    }
+
+    if (info) {
+        info->symbols = symbols;
+        info->mark_levels = marks.count;
+        info->space_levels = spaces.count;
+        info->bits = bits;
+        info->max_error_us = max_err;
+        info->max_error_pct = max_pct;
+    }
+    return total;
+}
+
+// ===== DECODIFICAÇÃO =====
+
+static uint8_t decode_symbol(ir_codec_decoder_t *dec) {
+    uint32_t code = 0, first = 0, index = 0;
+
+    if (dec->max_len == 0) {
+        return dec->sorted[0];
+    }
+    for (uint8_t l = 1; l <= dec->max_len; l++) {
+        if (dec->bit_pos >= dec->stream_bits) {
+            break;
+        }
+        uint32_t bit = (dec->stream[dec->bit_pos / 8] >> (7 - dec->bit_pos % 8)) & 1u;
+        dec->bit_pos++;
+        code |= bit;
+        uint32_t n = dec->len_count[l];
+        if (code - first < n) {
+            return dec->sorted[index + code - first];
+        }
+        index += n;
+        first = (first + n) << 1;
+        code <<= 1;
+    }
+    dec->error = true;
+    return dec->sorted[0];
+}
+
+static uint16_t decoder_next(ir_timing_source_t *src) {
+    ir_codec_decoder_t *dec = (ir_codec_decoder_t *)src;
+    uint16_t value;
+
+    if (dec->emitted >= src->length) {
+        return 0;
+    }
+    if (dec->emitted & 1) {
+        value = dec->pending_space;
+    } else {
+        uint8_t s = decode_symbol(dec);
+        value = dec->marks[s];
+        dec->pending_space = dec->spaces[s];
+    }
+    dec->emitted++;
+    return value;
+}
+
+static void decoder_rewind(ir_timing_source_t *src) {
+    ir_codec_decoder_t *dec = (ir_codec_decoder_t *)src;
+    dec->bit_pos = 0;
+    dec->emitted = 0;
+    dec->error = false;
+}
+
+bool ir_codec_decoder_init(ir_codec_decoder_t *dec, const uint8_t *blob, size_t size) {
+    uint8_t len[IR_CODEC_MAX_SYMBOLS];
+
+    if (size < HEADER_SIZE || blob[0] != IR_CODEC_VERSION) {
+        return false;
+    }
+    uint8_t symbols = blob[1];
+    uint16_t count = get_u16(&blob[2]);
+    if (symbols == 0 || symbols > IR_CODEC_MAX_SYMBOLS || count == 0 ||
+        size < table_size(symbols)) {
+        return false;
+    }
+
+    memset(dec, 0, sizeof(*dec));
+    const uint8_t *pos = blob + HEADER_SIZE;
+    for (uint8_t s = 0; s < symbols; s++) {
+        dec->marks[s] = get_u16(pos);
+        dec->spaces[s] = get_u16(pos + 2);
+        pos += SYMBOL_SIZE;
+    }
+    for (uint8_t s = 0; s < symbols; s++) {
+        len[s] = (pos[s / 2] >> ((s & 1) * 4)) & 0x0F;
+        if (len[s] > IR_CODEC_MAX_CODE_BITS || (len[s] == 0) != (symbols == 1)) {
+            return false;
+        }
+        dec->len_count[len[s]]++;
+        if (len[s] > dec->max_len) {
+            dec->max_len = len[s];
+        }
+    }
+    pos += (symbols + 1) / 2;
+
+    // Desigualdade de Kraft: comprimentos de um código de prefixo válido
+    uint32_t kraft = 0;
+    for (uint8_t l = 1; l <= dec->max_len; l++) {
+        kraft += (uint32_t)dec->len_count[l] << (IR_CODEC_MAX_CODE_BITS - l);
+    }
+    if (kraft > (1u << IR_CODEC_MAX_CODE_BITS)) {
+        return false;
+    }
+
+    canonical_order(len, symbols, dec->sorted);
+    dec->symbols = symbols;
+    dec->stream = pos;
+    dec->stream_bits = (uint32_t)(size - table_size(symbols)) * 8;
+    dec->source.length = count;
+    dec->source.next = decoder_next;
+    dec->source.rewind = decoder_rewind;
+    return true;
+}
+
+size_t ir_codec_decode(const uint8_t *blob, size_t size, uint16_t *out, size_t max) {
+    ir_codec_decoder_t dec;
+
+    if (!ir_codec_decoder_init(&dec, blob, size) || dec.source.length > max) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < dec.source.length; i++) {
+        out[i] = decoder_next(&dec.source);
+    }
+    return dec.error ? 0 : dec.source.length;
+}
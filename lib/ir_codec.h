@@ -0,0 +1,105 @@
+/**
+ * ir_codec.h
+ * Compressão de quadros RAW (timings em us) para armazenamento
+ *
+ * Um quadro aprendido que não decodifica para um protocolo conhecido só
+ * pode ser guardado como tabela de timings (2 bytes cada, ~400 bytes por
+ * quadro). O codec reduz isso em duas etapas:
+ *
+ *  1. Quantização: marcas e espaços são agrupados em níveis (durações que
+ *     diferem menos que IR_CODEC_TOLERANCE_PCT viram a média do grupo) e
+ *     cada par (marca, espaço) vira um símbolo de uma tabela aprendida
+ *     do próprio quadro (até IR_CODEC_MAX_SYMBOLS).
+ *  2. Entropia: os símbolos são codificados com Huffman canônico limitado
+ *     a IR_CODEC_MAX_CODE_BITS bits (só o comprimento de cada código é
+ *     gravado).
+ *
+ * Formato (little-endian):
+ *   ir_codec_header_t
+ *   símbolos x {uint16_t marca, uint16_t espaço}
+ *   comprimentos dos códigos, 4 bits cada (nibble baixo primeiro)
+ *   códigos, MSB primeiro, um por par; com número ímpar de timings o
+ *   último símbolo só contribui a marca
+ *
+ * O decodificador é uma fonte de timings (ir_timing_source_t): o
+ * transmissor puxa um timing por vez, sem expandir o quadro em RAM.
+ * Sem dependências do SDK (também compila no host).
+ */
+
+#ifndef IR_CODEC_H
+#define IR_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "custom_ir.h"
+
+#define IR_CODEC_VERSION        1
+#define IR_CODEC_MAX_SYMBOLS    16
+#define IR_CODEC_MAX_CODE_BITS  12
+#define IR_CODEC_TOLERANCE_PCT  20      // variação aceita dentro de um nível
+
+typedef struct {
+    uint8_t version;
+    uint8_t symbols;
+    uint16_t count;             // timings no quadro
+} ir_codec_header_t;
+
+// Resultado da codificação
+typedef struct {
+    uint8_t symbols;
+    uint8_t mark_levels;
+    uint8_t space_levels;
+    uint32_t bits;              // tamanho do fluxo de códigos
+    uint16_t max_error_us;      // maior diferença timing original vs. nível
+    uint8_t max_error_pct;
+} ir_codec_info_t;
+
+// Decodificador em streaming (source deve ser o primeiro membro)
+typedef struct {
+    ir_timing_source_t source;
+    const uint8_t *stream;
+    uint32_t stream_bits;
+    uint32_t bit_pos;
+    uint16_t emitted;
+    uint16_t pending_space;
+    bool error;                 // código inválido ou fluxo truncado
+    uint8_t symbols;
+    uint8_t max_len;
+    uint16_t marks[IR_CODEC_MAX_SYMBOLS];
+    uint16_t spaces[IR_CODEC_MAX_SYMBOLS];
+    uint8_t len_count[IR_CODEC_MAX_CODE_BITS + 1];
+    uint8_t sorted[IR_CODEC_MAX_SYMBOLS];   // símbolos em ordem canônica
+} ir_codec_decoder_t;
+
+/**
+ * Tamanho máximo do blob de um quadro com 'count' timings
+ */
+size_t ir_codec_max_size(size_t count);
+
+/**
+ * Comprime um quadro
+ * @param timings Timings em us (marca, espaço, marca, ...)
+ * @param out Destino do blob
+ * @param max Tamanho de out
+ * @param info Estatísticas (pode ser NULL)
+ * @return Bytes escritos, ou 0 se o quadro tem níveis demais para o codec,
+ *         é vazio ou não cabe em out
+ */
+size_t ir_codec_encode(const uint16_t *timings, size_t count,
+                       uint8_t *out, size_t max, ir_codec_info_t *info);
+
+/**
+ * Prepara o decodificador (copia as tabelas; o fluxo de códigos continua
+ * sendo lido do blob, que deve permanecer válido - ex.: na flash)
+ * @return false se o blob é inválido
+ */
+bool ir_codec_decoder_init(ir_codec_decoder_t *dec, const uint8_t *blob, size_t size);
+
+/**
+ * Descomprime o quadro inteiro
+ * @return Timings escritos, ou 0 se o blob é inválido ou não cabe em out
+ */
+size_t ir_codec_decode(const uint8_t *blob, size_t size, uint16_t *out, size_t max);
+
+#endif // IR_CODEC_H
@@ -0,0 +1,206 @@
+/**
+ * Planejador de transmissões simultâneas com limite de corrente
+ * Deslocamento de início por quadro + envio pela fila IR
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "ir_planner.h"
+
+// Margem entre o fim do planejamento e o início do plano
+#define IR_PLAN_START_MARGIN_US 1000
+
+_Static_assert(IR_PLAN_MAX_FRAMES <= IR_QUEUE_DEPTH, "plano maior que a fila IR");
+
+static uint16_t emitter_ma[IR_MAX_EMITTERS] = {
+    IR_PLAN_DEFAULT_MA, IR_PLAN_DEFAULT_MA, IR_PLAN_DEFAULT_MA, IR_PLAN_DEFAULT_MA
+};
+static uint16_t budget_ma = IR_PLAN_DEFAULT_BUDGET_MA;
+static ir_planner_stats_t stats;
+
+// Marcas de cada quadro do plano em andamento
+static ir_interval_t marks[IR_PLAN_MAX_FRAMES][IR_PLAN_MAX_MARKS];
+static uint16_t mark_count[IR_PLAN_MAX_FRAMES];
+
+void ir_planner_set_emitter_current(uint8_t emitter, uint16_t ma) {
+    if (emitter < IR_MAX_EMITTERS) {
+        emitter_ma[emitter] = ma;
+    }
+}
+
+void ir_planner_set_budget(uint16_t ma) {
+    budget_ma = ma;
+}
+
+// ============================================================================
+// PLANEJAMENTO
+// ============================================================================
+
+/**
+ * Verifica o quadro 'f' no deslocamento 'offset' contra os já colocados.
+ * A carga de uma marca soma todo quadro com alguma marca sobreposta a ela
+ * (estimativa conservadora: nunca subestima o pico)
+ * @return true se viável; senão 'next' recebe o menor deslocamento que
+ *         ainda pode ser viável
+ */
+static bool check_offset(const ir_plan_frame_t *frames, uint8_t f, uint32_t offset,
+                         const uint8_t *placed, uint8_t placed_count,
+                         uint32_t *next, uint16_t *peak_ma) {
+    uint16_t cursor[IR_PLAN_MAX_FRAMES] = {0};
+    uint16_t peak = 0;
+
+    for (uint16_t m = 0; m < mark_count[f]; m++) {
+        uint32_t ms = offset + marks[f][m].start_us;
+        uint32_t me = offset + marks[f][m].end_us + IR_PLAN_GUARD_US;
+        uint32_t load = emitter_ma[frames[f].emitter];
+        uint32_t first_free = UINT32_MAX;
+
+        for (uint8_t k = 0; k < placed_count; k++) {
+            uint8_t p = placed[k];
+            uint32_t po = frames[p].offset_us;
+            // Marcas de 'p' que terminaram antes desta não voltam a importar
+            while (cursor[k] < mark_count[p] &&
+                   po + marks[p][cursor[k]].end_us + IR_PLAN_GUARD_US <= ms) {
+                cursor[k]++;
+            }
+            if (cursor[k] < mark_count[p] && po + marks[p][cursor[k]].start_us < me) {
+                load += emitter_ma[frames[p].emitter];
+                uint32_t pe = po + marks[p][cursor[k]].end_us + IR_PLAN_GUARD_US;
+                if (pe < first_free) first_free = pe;
+            }
+        }
+
+        if (load > budget_ma) {
+            // Deslocamentos menores mantêm todas as sobreposições desta marca
+            *next = offset + (first_free - ms);
+            return false;
+        }
+        if (load > peak) peak = (uint16_t)load;
+    }
+
+    *peak_ma = peak;
+    return true;
+}
+
+bool ir_planner_plan(ir_plan_frame_t *frames, uint8_t count, uint32_t *makespan_us) {
+    uint8_t order[IR_PLAN_MAX_FRAMES];
+    uint8_t placed[IR_PLAN_MAX_FRAMES];
+    uint8_t placed_count = 0;
+    uint32_t makespan = 0;
+    uint32_t serial = 0;
+    uint16_t peak = 0;
+
+    if (count > IR_PLAN_MAX_FRAMES) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        ir_plan_frame_t *fr = &frames[i];
+        if (fr->emitter >= IR_MAX_EMITTERS || emitter_ma[fr->emitter] > budget_ma) {
+            printf("ERRO: emissor %u passa do orcamento de %umA\n", fr->emitter, budget_ma);
+            return false;
+        }
+        mark_count[i] = custom_ir_mark_intervals(fr->emitter, fr->signal, fr->length,
+                                                 marks[i], IR_PLAN_MAX_MARKS);
+        if (mark_count[i] == 0 || mark_count[i] == IR_PLAN_MAX_MARKS) {
+            printf("ERRO: quadro com %u marcas nao planejavel\n", mark_count[i]);
+            return false;
+        }
+        fr->duration_us = marks[i][mark_count[i] - 1].end_us;
+        fr->offset_us = 0;
+        serial += fr->duration_us;
+        order[i] = i;
+    }
+
+    // Mais longos primeiro (inserção)
+    for (uint8_t i = 1; i < count; i++) {
+        uint8_t cur = order[i];
+        int8_t j = i - 1;
+        while (j >= 0 && frames[order[j]].duration_us < frames[cur].duration_us) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = cur;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t f = order[i];
+        uint32_t offset = 0;
+
+        // Um emissor transmite um quadro por vez, com intervalo entre eles
+        for (uint8_t k = 0; k < placed_count; k++) {
+            const ir_plan_frame_t *p = &frames[placed[k]];
+            if (p->emitter == frames[f].emitter) {
+                uint32_t gap = p->gap_us ? p->gap_us : IR_PLAN_FRAME_GAP_US;
+                uint32_t free_at = p->offset_us + p->duration_us + gap;
+                if (free_at > offset) offset = free_at;
+            }
+        }
+
+        uint16_t frame_peak = 0;
+        uint32_t next;
+        while (!check_offset(frames, f, offset, placed, placed_count, &next, &frame_peak)) {
+            offset = next;
+        }
+
+        frames[f].offset_us = offset;
+        placed[placed_count++] = f;
+        if (offset + frames[f].duration_us > makespan) makespan = offset + frames[f].duration_us;
+        if (frame_peak > peak) peak = frame_peak;
+    }
+
+    stats.plans++;
+    stats.last_makespan_us = makespan;
+    stats.last_serial_us = serial;
+    stats.last_peak_ma = peak;
+    if (makespan_us) *makespan_us = makespan;
+    return true;
+}
+
+// ============================================================================
+// ENVIO PELA FILA
+// ============================================================================
+
+uint8_t ir_planner_submit(ir_plan_frame_t *frames, uint8_t count, ir_prio_t prio) {
+    uint8_t order[IR_PLAN_MAX_FRAMES];
+    uint8_t sent = 0;
+
+    for (uint8_t i = 0; i < count && i < IR_PLAN_MAX_FRAMES; i++) {
+        frames[i].ok = false;
+    }
+    if (!ir_planner_plan(frames, count, NULL)) {
+        return 0;
+    }
+
+    // Na fila em ordem de início: no mesmo emissor, a fila segue a chegada
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t cur = i;
+        int8_t j = i - 1;
+        while (j >= 0 && frames[order[j]].offset_us > frames[cur].offset_us) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = cur;
+    }
+
+    uint64_t t0 = time_us_64() + IR_PLAN_START_MARGIN_US;
+    for (uint8_t i = 0; i < count; i++) {
+        ir_plan_frame_t *fr = &frames[order[i]];
+        ir_queue_item_t item = {
+            .emitter = fr->emitter,
+            .prio = prio,
+            .key = fr->key,
+            .signal = fr->signal,
+            .length = fr->length,
+            .start_us = t0 + fr->offset_us,
+        };
+        fr->ok = ir_queue_submit(&item);
+        sent += fr->ok;
+    }
+    return sent;
+}
+
+void ir_planner_get_stats(ir_planner_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,74 @@
+/**
+ * ir_planner.h
+ * Planejador de transmissões simultâneas com limite de corrente
+ *
+ * Vários LEDs IR ligados ao mesmo tempo derrubam a alimentação (3V3/VSYS)
+ * e o OLED reinicia. O planejador conhece a corrente de cada emissor e o
+ * orçamento da fonte, e escolhe o deslocamento de início de cada quadro
+ * para que a soma das portadoras ligadas nunca passe do orçamento:
+ * quadros mais longos primeiro, cada um no menor deslocamento viável
+ * (marcas de um quadro podem cair nos espaços de outro).
+ *
+ * O plano sai pela fila IR (ir_queue.h), com o instante de início de cada
+ * quadro: o envio não bloqueia e uma emergência corta o que faltar.
+ */
+
+#ifndef IR_PLANNER_H
+#define IR_PLANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "custom_ir.h"
+#include "ir_queue.h"
+
+#define IR_PLAN_MAX_FRAMES          8
+#define IR_PLAN_MAX_MARKS           (IR_MAX_FRAME_TIMINGS / 2 + 2)  // marcas por quadro (+1: cheio = cortado)
+#define IR_PLAN_GUARD_US            30      // folga no fim de cada marca (atraso do disparo)
+#define IR_PLAN_FRAME_GAP_US        20000   // entre quadros no mesmo emissor
+#define IR_PLAN_DEFAULT_MA          100     // corrente de um LED IR
+#define IR_PLAN_DEFAULT_BUDGET_MA   250     // orçamento da fonte para os LEDs
+
+typedef struct {
+    uint8_t emitter;
+    uint32_t key;               // chave da cache de quadros (0 = sem cache)
+    const uint16_t *signal;
+    size_t length;
+    uint32_t gap_us;            // até o próximo quadro no emissor (0 = IR_PLAN_FRAME_GAP_US)
+    uint32_t offset_us;         // saída: início relativo ao começo do plano
+    uint32_t duration_us;       // saída: fim da última marca
+    bool ok;                    // saída de ir_planner_submit(): na fila
+} ir_plan_frame_t;
+
+typedef struct {
+    uint32_t plans;
+    uint32_t last_makespan_us;  // duração do último plano
+    uint32_t last_serial_us;    // soma das durações (envio um por vez)
+    uint16_t last_peak_ma;      // pico de corrente previsto
+} ir_planner_stats_t;
+
+/**
+ * Corrente de pico de um emissor e orçamento total
+ */
+void ir_planner_set_emitter_current(uint8_t emitter, uint16_t ma);
+void ir_planner_set_budget(uint16_t ma);
+
+/**
+ * Calcula offset_us e duration_us de cada quadro
+ * @param makespan_us Duração total do plano (pode ser NULL)
+ * @return false se algum emissor sozinho passa do orçamento ou o quadro
+ *         tem marcas demais
+ */
+bool ir_planner_plan(ir_plan_frame_t *frames, uint8_t count, uint32_t *makespan_us);
+
+/**
+ * Planeja e põe os quadros na fila com o início de cada um (não espera a
+ * transmissão); cada quadro recebe ok
+ * @param prio Classe na fila (ir_prio_t)
+ * @return Número de quadros aceitos pela fila
+ */
+uint8_t ir_planner_submit(ir_plan_frame_t *frames, uint8_t count, ir_prio_t prio);
+
+void ir_planner_get_stats(ir_planner_stats_t *stats);
+
+#endif // IR_PLANNER_H
@@ -0,0 +1,307 @@
+/**
+ * Fila de transmissão IR com classes de prioridade
+ * Preempção no próximo espaço, repetições e início planejado sem bloquear,
+ * e medição da latência até a primeira borda
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "custom_ir.h"
+#include "ir_queue.h"
+
+// Tempo para armar um quadro antes do início planejado
+#define IR_QUEUE_ARM_LEAD_US 300
+
+// Fila ordenada: classe crescente, ordem de chegada dentro da classe
+static ir_queue_item_t queue[IR_QUEUE_DEPTH];
+static uint8_t queue_len = 0;
+
+// Quadro no ar por emissor
+static struct {
+    bool active;
+    bool solo;              // planejado atrasado: nenhum planejado entra junto
+    uint8_t left;           // repetições ainda por armar
+    ir_queue_item_t item;
+    uint64_t armed_us;
+    uint32_t duration_us;
+    uint64_t deadline_us;   // depois disso o quadro é dado como travado
+} inflight[IR_MAX_EMITTERS];
+
+// Medição de preempção em andamento
+static bool preempt_pending = false;
+static uint8_t preempt_emitter;
+static uint64_t preempt_req_us;
+
+// Item que não armou só tenta de novo quando algo muda no ar ou na fila
+// (sem isso, cada poll repetiria a tentativa e o erro no console)
+static uint32_t air_epoch = 1;
+static uint32_t stalled_epoch[IR_MAX_EMITTERS];    // 0 = não travado
+static bool air_was_busy = false;
+
+static ir_queue_stats_t stats;
+
+void ir_queue_init(void) {
+    queue_len = 0;
+    memset(inflight, 0, sizeof(inflight));
+    memset(stalled_epoch, 0, sizeof(stalled_epoch));
+    memset(&stats, 0, sizeof(stats));
+    preempt_pending = false;
+}
+
+// Tempo no ar do quadro da fila que acabou de terminar (ou ser cortado)
+// no emissor; cortado ainda armado não conta
+static void account_airtime(uint8_t e) {
+    uint64_t started = custom_ir_started_at(e);
+    uint64_t finished = custom_ir_finished_at(e);
+    if (started >= inflight[e].armed_us && finished > started) {
+        stats.airtime_us[inflight[e].item.prio] += (uint32_t)(finished - started);
+    }
+}
+
+static void queue_remove(uint8_t pos) {
+    queue_len--;
+    memmove(&queue[pos], &queue[pos + 1], (queue_len - pos) * sizeof(queue[0]));
+}
+
+// Insere no fim da classe (head = no início, para quem volta por falha
+// ao armar). Fila cheia: o último de classe mais baixa cede a vaga
+static bool queue_insert(const ir_queue_item_t *item, bool head) {
+    if (queue_len >= IR_QUEUE_DEPTH) {
+        if (queue[queue_len - 1].prio <= item->prio) {
+            stats.dropped++;
+            return false;
+        }
+        queue_remove(queue_len - 1);
+        stats.dropped++;
+    }
+    uint8_t pos = 0;
+    while (pos < queue_len && (head ? queue[pos].prio < item->prio : queue[pos].prio <= item->prio)) {
+        pos++;
+    }
+    memmove(&queue[pos + 1], &queue[pos], (queue_len - pos) * sizeof(queue[0]));
+    queue[pos] = *item;
+    queue_len++;
+    return true;
+}
+
+// Corta os quadros no ar de classe mais baixa em outros emissores: o
+// backend de bordas tem um alarme só
+static bool preempt_lower(const ir_queue_item_t *item) {
+    bool any = false;
+    for (uint8_t e = 0; e < IR_MAX_EMITTERS; e++) {
+        if (e != item->emitter && inflight[e].active && inflight[e].item.prio > item->prio) {
+            custom_ir_cancel(e);
+            account_airtime(e);
+            inflight[e].active = false;
+            stats.preempted++;
+            air_epoch++;
+            any = true;
+        }
+    }
+    return any;
+}
+
+// Planejado no horário arma já (início no futuro); atrasado, só com o ar
+// livre, e com um atrasado no ar os demais planejados esperam: fora do
+// horário o plano não garante mais o orçamento de corrente
+static bool planned_can_start(const ir_queue_item_t *item) {
+    for (uint8_t e = 0; e < IR_MAX_EMITTERS; e++) {
+        if (inflight[e].active && inflight[e].solo) {
+            return false;
+        }
+    }
+    bool late = time_us_64() + IR_QUEUE_ARM_LEAD_US > item->start_us;
+    return !late || !custom_ir_any_busy();
+}
+
+// Início no plano, ou agora (lido de novo a cada tentativa: o corte de
+// outro emissor pode demorar até o próximo espaço)
+static bool arm_planned(const ir_queue_item_t *item, bool late, uint64_t *start_us) {
+    *start_us = item->start_us && !late ? item->start_us : time_us_64();
+    return custom_ir_arm(item->emitter, item->key, item->signal, item->length,
+                         from_us_since_boot(*start_us));
+}
+
+// Falha ao armar não descarta: o item volta à fila e o poll tenta de novo
+static bool start_item(const ir_queue_item_t *item) {
+    uint64_t now = time_us_64();
+    bool late = item->start_us && now + IR_QUEUE_ARM_LEAD_US > item->start_us;
+    uint64_t start;
+    bool ok = arm_planned(item, late, &start);
+    if (!ok && preempt_lower(item)) {
+        ok = arm_planned(item, late, &start);
+    }
+    if (!ok) {
+        return false;
+    }
+    uint8_t e = item->emitter;
+    inflight[e].active = true;
+    inflight[e].solo = late;
+    inflight[e].left = item->repeat > 1 ? item->repeat - 1 : 0;
+    inflight[e].item = *item;
+    inflight[e].armed_us = now;
+    inflight[e].duration_us = ir_signal_duration_us(item->signal, item->length);
+    inflight[e].deadline_us = start + inflight[e].duration_us + IR_QUEUE_STUCK_MARGIN_US;
+    if (late) {
+        stats.late++;
+    }
+    return true;
+}
+
+// Próxima repetição do quadro que acabou de terminar: fim dele + pausa
+static bool start_repeat(uint8_t e) {
+    uint64_t now = time_us_64();
+    uint64_t start = custom_ir_finished_at(e) + (uint64_t)inflight[e].item.gap_ms * 1000;
+    if (start < now) {
+        start = now;
+    }
+    const ir_queue_item_t *it = &inflight[e].item;
+    if (!custom_ir_arm(e, it->key, it->signal, it->length, from_us_since_boot(start))) {
+        return false;
+    }
+    inflight[e].left--;
+    inflight[e].armed_us = now;
+    inflight[e].deadline_us = start + inflight[e].duration_us + IR_QUEUE_STUCK_MARGIN_US;
+    return true;
+}
+
+bool ir_queue_submit(const ir_queue_item_t *item) {
+    if (item->emitter >= IR_MAX_EMITTERS || item->prio >= IR_PRIO_COUNT) {
+        return false;
+    }
+    stats.submitted++;
+    air_epoch++;
+
+    // Classe mais alta que a do quadro no ar: corta no próximo espaço
+    if (inflight[item->emitter].active && item->prio < inflight[item->emitter].item.prio) {
+        uint64_t t_req = time_us_64();
+
+        custom_ir_cancel(item->emitter);
+        account_airtime(item->emitter);
+        inflight[item->emitter].active = false;
+        stats.preempted++;
+
+        if ((!item->start_us || planned_can_start(item)) && start_item(item)) {
+            preempt_pending = true;
+            preempt_emitter = item->emitter;
+            preempt_req_us = t_req;
+            return true;
+        }
+        return queue_insert(item, true);
+    }
+
+    if (!queue_insert(item, false)) {
+        return false;
+    }
+    ir_queue_poll();
+    return true;
+}
+
+void ir_queue_poll(void) {
+    // Quadros que terminaram: arma a próxima repetição ou libera o emissor.
+    // Repetição que não armou (bordas, outro emissor no ar) se perde
+    uint64_t now = time_us_64();
+    for (uint8_t e = 0; e < IR_MAX_EMITTERS; e++) {
+        if (!inflight[e].active) {
+            continue;
+        }
+        if (custom_ir_busy(e)) {
+            if (now > inflight[e].deadline_us) {
+                printf("ERRO: quadro travado no emissor %u, cortando\n", e);
+                custom_ir_cancel(e);
+                account_airtime(e);
+                inflight[e].active = false;
+                stats.stuck++;
+                air_epoch++;
+            }
+            continue;
+        }
+        account_airtime(e);
+        stats.sent++;
+        air_epoch++;
+        if (inflight[e].left > 0 && start_repeat(e)) {
+            continue;
+        }
+        if (inflight[e].left > 0) {
+            stats.dropped++;
+        }
+        inflight[e].active = false;
+    }
+    bool busy = custom_ir_any_busy();
+    if (air_was_busy && !busy) {
+        air_epoch++;
+    }
+    air_was_busy = busy;
+
+    // Latência da preempção: disponível quando o novo quadro começou
+    if (preempt_pending) {
+        uint64_t started = custom_ir_started_at(preempt_emitter);
+        if (started >= preempt_req_us) {
+            uint32_t dt = (uint32_t)(started - preempt_req_us);
+            stats.preempt_last_us = dt;
+            if (dt > stats.preempt_max_us) stats.preempt_max_us = dt;
+            preempt_pending = false;
+        }
+    }
+
+    // Próximo da fila para cada emissor livre (a fila já está por classe).
+    // Quem não armou fica no lugar e segura os seguintes do mesmo emissor
+    uint32_t blocked = 0;
+    for (uint8_t pos = 0; pos < queue_len;) {
+        uint8_t e = queue[pos].emitter;
+        if ((blocked & (1u << e)) || inflight[e].active || custom_ir_busy(e) ||
+            stalled_epoch[e] == air_epoch ||
+            (queue[pos].start_us && !planned_can_start(&queue[pos]))) {
+            blocked |= 1u << e;
+            pos++;
+            continue;
+        }
+        if (!start_item(&queue[pos])) {
+            // Nada no ar e mesmo assim não armou: não vai armar. Emergência
+            // nunca é descartada
+            if (!custom_ir_any_busy() && queue[pos].prio != IR_PRIO_EMERGENCY) {
+                queue_remove(pos);
+                stats.dropped++;
+                continue;
+            }
+            stalled_epoch[e] = air_epoch;
+            blocked |= 1u << e;
+            pos++;
+            continue;
+        }
+        stalled_epoch[e] = 0;
+        queue_remove(pos);
+    }
+}
+
+bool ir_queue_idle(void) {
+    if (queue_len > 0) return false;
+    for (uint8_t e = 0; e < IR_MAX_EMITTERS; e++) {
+        if (inflight[e].active) return false;
+    }
+    return true;
+}
+
+void ir_queue_flush(ir_prio_t from_prio) {
+    for (uint8_t pos = 0; pos < queue_len;) {
+        if (queue[pos].prio >= from_prio) {
+            queue_remove(pos);
+            stats.dropped++;
+        } else {
+            pos++;
+        }
+    }
+    for (uint8_t e = 0; e < IR_MAX_EMITTERS; e++) {
+        if (inflight[e].active && inflight[e].item.prio >= from_prio) {
+            custom_ir_cancel(e);
+            account_airtime(e);
+            inflight[e].active = false;
+            stats.dropped++;
+        }
+    }
+    air_epoch++;
+}
+
+void ir_queue_get_stats(ir_queue_stats_t *out) {
+    *out = stats;
+}
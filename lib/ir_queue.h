@@ -0,0 +1,101 @@
+/**
+ * ir_queue.h
+ * Fila de transmissão IR com classes de prioridade e preempção
+ *
+ * Um quadro por emissor fica no ar; os demais esperam na fila, por classe
+ * e em ordem de chegada. Um quadro de classe mais alta que o do ar corta
+ * o atual no próximo espaço (custom_ir_cancel) e sai em seguida. O quadro
+ * cortado é descartado: retransmiti-lo depois de um "desligar" de
+ * emergência desfaria o desligamento.
+ *
+ * Um quadro que não consegue armar (backend de bordas com outro emissor no
+ * ar) não é perdido: quadros de classe
+ * mais baixa nos outros emissores são cortados e, se ainda assim não
+ * armar, ele fica no início da sua classe até o próximo poll.
+ *
+ * As repetições de um quadro (perfil do aparelho) ficam no mesmo item: o
+ * poll arma a próxima no fim da anterior mais a pausa, e um corte descarta
+ * as que faltam. Quadros planejados (ir_planner) trazem o instante de
+ * início; um que perdeu o instante só sai com o ar livre, e nenhum outro
+ * planejado entra junto com ele (o orçamento de corrente vale para o plano
+ * no horário).
+ *
+ * Nada aqui bloqueia: usuário, frota e emergência passam pela fila e o
+ * laço principal continua lendo o console durante o envio. Só os envios
+ * diretos (send_raw_signal_keyed, demo) não podem ser cortados. A queda de
+ * energia não espera a fila (custom_ir_abort na IRQ).
+ */
+
+#ifndef IR_QUEUE_H
+#define IR_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define IR_QUEUE_DEPTH 16
+// Quadro no ar além da duração mais isto: considerado travado e cortado
+#define IR_QUEUE_STUCK_MARGIN_US 200000
+
+// Menor valor = maior prioridade
+typedef enum {
+    IR_PRIO_EMERGENCY,      // desligamento de emergência, falha
+    IR_PRIO_USER,           // comandos do usuário/gateway
+    IR_PRIO_BACKGROUND,     // reafirmação periódica de estado
+    IR_PRIO_COUNT
+} ir_prio_t;
+
+typedef struct {
+    uint8_t emitter;
+    uint8_t prio;           // ir_prio_t
+    uint32_t key;           // chave da cache de quadros (0 = sem cache)
+    const uint16_t *signal;
+    size_t length;
+    uint8_t repeat;         // quadros iguais em sequência (0 = 1)
+    uint16_t gap_ms;        // entre o fim de um e o início do seguinte
+    uint64_t start_us;      // início planejado (0 = assim que o emissor livrar)
+} ir_queue_item_t;
+
+typedef struct {
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t preempted;     // quadros cortados por um de classe mais alta
+    uint32_t dropped;       // fila cheia (ou vaga cedida a uma classe mais alta)
+    uint32_t late;          // planejados que perderam o início (saíram sozinhos)
+    uint32_t stuck;         // cortados por passar do prazo no ar
+    uint32_t preempt_last_us;   // do pedido até a primeira borda do novo quadro
+    uint32_t preempt_max_us;
+    uint32_t airtime_us[IR_PRIO_COUNT];     // no ar de fato, por classe (até o fim ou o corte)
+} ir_queue_stats_t;
+
+void ir_queue_init(void);
+
+/**
+ * Coloca um quadro (e suas repetições) na fila; se a classe for mais alta
+ * que a do quadro no ar no mesmo emissor, corta o atual e transmite este
+ * imediatamente. Não espera a transmissão
+ * @return false se a fila está cheia de itens de classe igual ou mais alta
+ */
+bool ir_queue_submit(const ir_queue_item_t *item);
+
+/**
+ * Conclui quadros terminados, arma repetições e inicia os próximos da fila
+ * (chamar no laço principal, com intervalo menor que as pausas entre
+ * repetições)
+ */
+void ir_queue_poll(void);
+
+/**
+ * @return true se não há nada na fila nem no ar
+ */
+bool ir_queue_idle(void);
+
+/**
+ * Descarta a fila de uma classe para baixo (inclusive) e corta o que
+ * estiver no ar dessas classes
+ */
+void ir_queue_flush(ir_prio_t from_prio);
+
+void ir_queue_get_stats(ir_queue_stats_t *stats);
+
+#endif // IR_QUEUE_H
@@ -0,0 +1,394 @@
+/**
+ * Armazenamento chave-valor em flash
+ * Log de registros de 16 bytes em 2 setores alternados
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "power_monitor.h"
+#include "wdt_lease.h"
+#include "kv_store.h"
+
+#define KV_MAGIC            0x3153564Bu   // "KVS1"
+#define KV_KEY_EMPTY        0xFFFFu
+#define KV_KEY_TOMBSTONE    0xFFFEu       // marca remoção no índice
+#define KV_FLAG_SET         0xFFFFu
+#define KV_FLAG_ERASED      0x0000u
+
+#define KV_SLOT_SIZE        16
+#define KV_SLOTS            (FLASH_SECTOR_SIZE / KV_SLOT_SIZE)
+#define KV_SLOTS_PER_PAGE   (FLASH_PAGE_SIZE / KV_SLOT_SIZE)
+
+// Apagar um setor leva até ~400ms no pior caso
+#define KV_ERASE_LEASE_MS   1000
+#define KV_PROGRAM_LEASE_MS 100
+
+// Slot 0 de cada setor
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t reserved;
+    uint32_t crc;
+} kv_header_t;
+
+// Slots 1..KV_SLOTS-1
+typedef struct {
+    uint16_t key;
+    uint16_t flags;
+    uint32_t value;
+    uint32_t seq;
+    uint32_t crc;       // CRC dos 12 bytes anteriores
+} kv_record_t;
+
+typedef struct {
+    uint16_t key;
+    uint32_t value;
+} kv_index_entry_t;
+
+static kv_index_entry_t kv_index[KV_INDEX_SIZE];
+static uint8_t kv_active = 0;         // setor ativo (0 ou 1)
+static uint16_t kv_write_slot = 0;    // próximo slot livre
+static uint32_t kv_generation = 0;
+static uint32_t kv_seq = 0;
+static bool kv_ready = false;
+static kv_store_stats_t kv_stats;
+
+// Buffer de uma página para gravação (fora da pilha)
+static uint8_t kv_page[FLASH_PAGE_SIZE];
+
+// ============================================================================
+// ACESSO À FLASH
+// ============================================================================
+
+static uint32_t kv_sector_offset(uint8_t sector) {
+    return FLASH_KV_OFFSET + (uint32_t)sector * FLASH_SECTOR_SIZE;
+}
+
+static const void *kv_slot_ptr(uint8_t sector, uint16_t slot) {
+    return FLASH_XIP_PTR(kv_sector_offset(sector) + (uint32_t)slot * KV_SLOT_SIZE);
+}
+
+// Recusa com VSYS sem folga: o setor antigo continua valendo
+static bool kv_flash_erase(uint8_t sector) {
+    if (!power_monitor_flash_ok()) {
+        return false;
+    }
+    bool leased = wdt_lease_begin(KV_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(kv_sector_offset(sector), FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+    return true;
+}
+
+// Grava kv_page na página que contém 'slot' (bytes 0xFF não alteram a flash)
+static void kv_flash_program_page(uint8_t sector, uint16_t slot) {
+    uint32_t offset = kv_sector_offset(sector) +
+                      (uint32_t)(slot / KV_SLOTS_PER_PAGE) * FLASH_PAGE_SIZE;
+
+    bool leased = wdt_lease_begin(KV_PROGRAM_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(offset, kv_page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+}
+
+static void kv_page_put(uint16_t slot, const void *data) {
+    memcpy(&kv_page[(slot % KV_SLOTS_PER_PAGE) * KV_SLOT_SIZE], data, KV_SLOT_SIZE);
+}
+
+static bool kv_slot_is_empty(const void *slot) {
+    const uint32_t *w = (const uint32_t *)slot;
+    return (w[0] & w[1] & w[2] & w[3]) == 0xFFFFFFFFu;
+}
+
+static bool kv_header_valid(uint8_t sector, uint32_t *generation) {
+    kv_header_t hdr;
+    memcpy(&hdr, kv_slot_ptr(sector, 0), sizeof(hdr));
+    if (hdr.magic != KV_MAGIC ||
+        hdr.crc != crc32_compute(&hdr, offsetof(kv_header_t, crc))) {
+        return false;
+    }
+    *generation = hdr.generation;
+    return true;
+}
+
+static void kv_write_header(uint8_t sector, uint32_t generation) {
+    kv_header_t hdr = {
+        .magic = KV_MAGIC,
+        .generation = generation,
+        .reserved = 0xFFFFFFFFu,
+    };
+    hdr.crc = crc32_compute(&hdr, offsetof(kv_header_t, crc));
+
+    memset(kv_page, 0xFF, sizeof(kv_page));
+    kv_page_put(0, &hdr);
+    kv_flash_program_page(sector, 0);
+}
+
+// ============================================================================
+// ÍNDICE EM RAM (endereçamento aberto, sondagem linear)
+// ============================================================================
+
+static inline uint16_t kv_hash(uint16_t key) {
+    return (uint16_t)((key * 40503u) >> 4) & (KV_INDEX_SIZE - 1);
+}
+
+static kv_index_entry_t *kv_index_find(uint16_t key) {
+    uint16_t h = kv_hash(key);
+    for (uint16_t i = 0; i < KV_INDEX_SIZE; i++) {
+        kv_index_entry_t *e = &kv_index[(h + i) & (KV_INDEX_SIZE - 1)];
+        if (e->key == key) return e;
+        if (e->key == KV_KEY_EMPTY) return NULL;
+    }
+    return NULL;
+}
+
+static bool kv_index_put(uint16_t key, uint32_t value) {
+    kv_index_entry_t *e = kv_index_find(key);
+    if (e) {
+        e->value = value;
+        return true;
+    }
+
+    uint16_t h = kv_hash(key);
+    for (uint16_t i = 0; i < KV_INDEX_SIZE; i++) {
+        e = &kv_index[(h + i) & (KV_INDEX_SIZE - 1)];
+        if (e->key == KV_KEY_EMPTY || e->key == KV_KEY_TOMBSTONE) {
+            e->key = key;
+            e->value = value;
+            kv_stats.live_keys++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void kv_index_remove(uint16_t key) {
+    kv_index_entry_t *e = kv_index_find(key);
+    if (e) {
+        e->key = KV_KEY_TOMBSTONE;
+        kv_stats.live_keys--;
+    }
+}
+
+static void kv_index_clear(void) {
+    for (uint16_t i = 0; i < KV_INDEX_SIZE; i++) {
+        kv_index[i].key = KV_KEY_EMPTY;
+    }
+    kv_stats.live_keys = 0;
+}
+
+// ============================================================================
+// VARREDURA DE BOOT
+// ============================================================================
+
+static void kv_scan_sector(uint8_t sector) {
+    kv_index_clear();
+    kv_stats.bad_records = 0;
+    kv_write_slot = KV_SLOTS;
+
+    for (uint16_t slot = 1; slot < KV_SLOTS; slot++) {
+        const void *p = kv_slot_ptr(sector, slot);
+        if (kv_slot_is_empty(p)) {
+            kv_write_slot = slot;
+            break;
+        }
+
+        kv_record_t rec;
+        memcpy(&rec, p, sizeof(rec));
+        if (rec.crc != crc32_compute(&rec, offsetof(kv_record_t, crc))) {
+            // Gravação interrompida: ignora, o slot continua ocupado
+            kv_stats.bad_records++;
+            continue;
+        }
+
+        if (rec.seq >= kv_seq) kv_seq = rec.seq + 1;
+        if (rec.flags == KV_FLAG_ERASED) {
+            kv_index_remove(rec.key);
+        } else {
+            kv_index_put(rec.key, rec.value);
+        }
+    }
+}
+
+bool kv_store_init(void) {
+    uint64_t start = time_us_64();
+    uint32_t gen[2] = { 0, 0 };
+    bool valid[2] = { kv_header_valid(0, &gen[0]), kv_header_valid(1, &gen[1]) };
+
+    memset(&kv_stats, 0, sizeof(kv_stats));
+    kv_seq = 0;
+
+    if (!valid[0] && !valid[1]) {
+        printf("KV: nenhum setor valido, formatando\n");
+        if (kv_flash_erase(0)) {
+            kv_write_header(0, 1);
+            valid[0] = kv_header_valid(0, &gen[0]);
+        }
+        if (!valid[0]) {
+            printf("ERRO: KV falhou ao formatar\n");
+            return false;
+        }
+    }
+
+    if (valid[0] && valid[1]) {
+        kv_active = (int32_t)(gen[1] - gen[0]) > 0 ? 1 : 0;
+    } else {
+        kv_active = valid[1] ? 1 : 0;
+    }
+    kv_generation = gen[kv_active];
+    kv_scan_sector(kv_active);
+
+    kv_stats.scan_us = (uint32_t)(time_us_64() - start);
+    kv_ready = true;
+    return true;
+}
+
+// ============================================================================
+// LEITURA / ESCRITA
+// ============================================================================
+
+bool kv_get(uint16_t key, uint32_t *value) {
+    kv_index_entry_t *e = kv_ready ? kv_index_find(key) : NULL;
+    if (!e) return false;
+    *value = e->value;
+    return true;
+}
+
+uint32_t kv_get_or(uint16_t key, uint32_t def) {
+    uint32_t value;
+    return kv_get(key, &value) ? value : def;
+}
+
+bool kv_store_gc(void) {
+    if (!kv_ready) return false;
+
+    uint8_t dst = kv_active ^ 1;
+    uint16_t slot = 1;
+
+    if (!kv_flash_erase(dst)) {
+        return false;
+    }
+    memset(kv_page, 0xFF, sizeof(kv_page));
+
+    for (uint16_t i = 0; i < KV_INDEX_SIZE; i++) {
+        const kv_index_entry_t *e = &kv_index[i];
+        if (e->key == KV_KEY_EMPTY || e->key == KV_KEY_TOMBSTONE) continue;
+
+        kv_record_t rec = {
+            .key = e->key,
+            .flags = KV_FLAG_SET,
+            .value = e->value,
+            .seq = kv_seq++,
+        };
+        rec.crc = crc32_compute(&rec, offsetof(kv_record_t, crc));
+        kv_page_put(slot, &rec);
+
+        if ((slot + 1) % KV_SLOTS_PER_PAGE == 0) {
+            kv_flash_program_page(dst, slot);
+            memset(kv_page, 0xFF, sizeof(kv_page));
+        }
+        slot++;
+    }
+    if (slot % KV_SLOTS_PER_PAGE != 0) {
+        kv_flash_program_page(dst, slot);
+    }
+
+    // Cabeçalho por último: até aqui o setor antigo continua valendo
+    kv_write_header(dst, kv_generation + 1);
+
+    kv_active = dst;
+    kv_generation++;
+    kv_write_slot = slot;
+    kv_stats.gc_count++;
+    return true;
+}
+
+static bool kv_append(uint16_t key, uint16_t flags, uint32_t value) {
+    if (kv_write_slot >= KV_SLOTS && !kv_store_gc()) {
+        return false;
+    }
+
+    kv_record_t rec = {
+        .key = key,
+        .flags = flags,
+        .value = value,
+        .seq = kv_seq++,
+    };
+    rec.crc = crc32_compute(&rec, offsetof(kv_record_t, crc));
+
+    memset(kv_page, 0xFF, sizeof(kv_page));
+    kv_page_put(kv_write_slot, &rec);
+    kv_flash_program_page(kv_active, kv_write_slot);
+
+    // Confere a gravação lendo de volta via XIP
+    if (memcmp(kv_slot_ptr(kv_active, kv_write_slot), &rec, sizeof(rec)) != 0) {
+        printf("ERRO: KV falha ao gravar slot %u\n", kv_write_slot);
+        kv_write_slot++;
+        return false;
+    }
+    kv_write_slot++;
+    return true;
+}
+
+bool kv_set(uint16_t key, uint32_t value) {
+    if (!kv_ready || key == 0 || key >= KV_KEY_TOMBSTONE) return false;
+
+    kv_index_entry_t *e = kv_index_find(key);
+    if (e && e->value == value) {
+        return true;    // sem mudança, poupa a flash
+    }
+    if (!e && kv_stats.live_keys >= KV_INDEX_SIZE - 1) {
+        return false;
+    }
+
+    if (!kv_append(key, KV_FLAG_SET, value)) return false;
+    return kv_index_put(key, value);
+}
+
+bool kv_erase(uint16_t key) {
+    if (!kv_ready || !kv_index_find(key)) return false;
+
+    if (!kv_append(key, KV_FLAG_ERASED, 0)) return false;
+    kv_index_remove(key);
+    return true;
+}
+
+bool kv_store_next(uint16_t *pos, uint16_t *key, uint32_t *value) {
+    while (*pos < KV_INDEX_SIZE) {
+        const kv_index_entry_t *e = &kv_index[(*pos)++];
+        if (e->key != KV_KEY_EMPTY && e->key != KV_KEY_TOMBSTONE) {
+            *key = e->key;
+            *value = e->value;
+            return true;
+        }
+    }
+    return false;
+}
+
+void kv_store_get_stats(kv_store_stats_t *stats) {
+    kv_stats.generation = kv_generation;
+    kv_stats.used_slots = kv_write_slot;
+    kv_stats.total_slots = KV_SLOTS;
+    *stats = kv_stats;
+}
+
+kv_slot_status_t kv_store_check_slot(uint16_t slot) {
+    if (!kv_ready || slot == 0 || slot >= kv_write_slot) {
+        return KV_SLOT_END;
+    }
+
+    kv_record_t rec;
+    memcpy(&rec, kv_slot_ptr(kv_active, slot), sizeof(rec));
+    return rec.crc == crc32_compute(&rec, offsetof(kv_record_t, crc)) ? KV_SLOT_OK : KV_SLOT_BAD;
+}
@@ -0,0 +1,108 @@
+/**
+ * kv_store.h
+ * Configuração chave-valor em flash (log estruturado + índice em RAM)
+ *
+ * Cada escrita acrescenta um registro de 16 bytes com CRC no setor ativo;
+ * o último registro válido de cada chave vence. Quando o setor enche,
+ * as chaves vivas são copiadas para o outro setor (coleta de lixo) e o
+ * cabeçalho com a nova geração é gravado por último, o que torna a troca
+ * atômica. No boot o log é varrido uma vez e as leituras seguintes saem
+ * do índice em RAM, em O(1).
+ */
+
+#ifndef KV_STORE_H
+#define KV_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Chaves conhecidas (0x0000, 0xFFFE e 0xFFFF são reservadas)
+typedef enum {
+    KV_KEY_IR_PIN = 1,
+    KV_KEY_SDA_DISP,
+    KV_KEY_SCL_DISP,
+    KV_KEY_DISPLAY_ADDR,
+    KV_KEY_WDT_TIMEOUT_MS,
+    KV_KEY_IR_CARRIER_FREQ,
+    KV_KEY_UI_FPS,
+    KV_KEY_TRACE_REC,
+    KV_KEY_REASSERT_S,
+
+    // Checksums de referência do verificador de integridade (scrubber.c)
+    KV_KEY_SCRUB_FW_TAG = 0x100,
+    KV_KEY_SCRUB_FW_CRC,
+    KV_KEY_SCRUB_IR_CRC_BASE = 0x110,   // + ir_command_id_t
+
+    // Perfil de AC de cada emissor (ac_profile.c)
+    KV_KEY_AC_PROFILE_BASE = 0x120,     // + índice do emissor
+} kv_key_t;
+
+// Resultado da verificação de um slot do log
+typedef enum {
+    KV_SLOT_OK,
+    KV_SLOT_BAD,
+    KV_SLOT_END,        // fim do log (slot livre ou fim do setor)
+} kv_slot_status_t;
+
+// Capacidade do índice em RAM (potência de 2)
+#define KV_INDEX_SIZE 32
+
+typedef struct {
+    uint32_t generation;     // geração do setor ativo
+    uint16_t used_slots;     // registros gravados no setor ativo
+    uint16_t total_slots;    // registros por setor
+    uint16_t live_keys;      // chaves no índice
+    uint16_t bad_records;    // registros com CRC inválido no boot
+    uint32_t scan_us;        // tempo da varredura de boot
+    uint32_t gc_count;       // coletas desde o boot
+} kv_store_stats_t;
+
+/**
+ * Varre a flash e monta o índice em RAM; formata se não houver setor válido
+ * @return true se o armazenamento está utilizável
+ */
+bool kv_store_init(void);
+
+/**
+ * Lê uma chave do índice em RAM
+ * @return false se a chave não existe
+ */
+bool kv_get(uint16_t key, uint32_t *value);
+
+/**
+ * Lê uma chave ou devolve o valor padrão
+ */
+uint32_t kv_get_or(uint16_t key, uint32_t def);
+
+/**
+ * Grava uma chave (não escreve se o valor não mudou)
+ * @return false em erro de flash ou índice cheio
+ */
+bool kv_set(uint16_t key, uint32_t value);
+
+/**
+ * Remove uma chave (registro de remoção no log)
+ */
+bool kv_erase(uint16_t key);
+
+/**
+ * Força a coleta de lixo para o setor alternativo
+ */
+bool kv_store_gc(void);
+
+/**
+ * Itera sobre as chaves vivas
+ * @param pos Posição do iterador (começar em 0)
+ * @return false quando não há mais chaves
+ */
+bool kv_store_next(uint16_t *pos, uint16_t *key, uint32_t *value);
+
+void kv_store_get_stats(kv_store_stats_t *stats);
+
+/**
+ * Confere o CRC de um slot do setor ativo (varredura em segundo plano)
+ * @param slot Slot a verificar (começar em 1)
+ */
+kv_slot_status_t kv_store_check_slot(uint16_t slot);
+
+#endif // KV_STORE_H
@@ -0,0 +1,116 @@
+/**
+ * Decodificador RLE de assets do OLED
+ * Escreve direto no ram_buffer (endereçamento vertical: byte = página + x * páginas)
+ */
+
+#include "oled_asset.h"
+
+// Leitor de fluxo RLE: ctrl < 0x80 = (ctrl + 1) literais, senão repetição
+typedef struct {
+    const uint8_t *p;
+    uint8_t count;
+    uint8_t value;
+    bool run;
+} rle_reader_t;
+
+static inline uint8_t rle_next(rle_reader_t *r) {
+    if (r->count == 0) {
+        uint8_t ctrl = *r->p++;
+        r->run = (ctrl & 0x80) != 0;
+        r->count = (ctrl & 0x7F) + 1;
+        if (r->run) {
+            r->value = *r->p++;
+        }
+    }
+    r->count--;
+    return r->run ? r->value : *r->p++;
+}
+
+// Avança 'n' bytes do fluxo sem escrever (colunas recortadas)
+static void rle_skip(rle_reader_t *r, uint16_t n) {
+    while (n > 0) {
+        if (r->count == 0) {
+            rle_next(r);
+            n--;
+            continue;
+        }
+        uint8_t step = n < r->count ? (uint8_t)n : r->count;
+        if (!r->run) {
+            r->p += step;
+        }
+        r->count -= step;
+        n -= step;
+    }
+}
+
+// Combina 'd' nos bits de 'm' de um byte do buffer
+static inline void blend(uint8_t *dst, uint8_t d, uint8_t m) {
+    *dst = (*dst & ~m) | (d & m);
+}
+
+void oled_asset_draw(ssd1306_t *ssd, const oled_asset_t *asset, int16_t x, int16_t y) {
+    uint8_t *buf = &ssd->ram_buffer[1];
+    uint8_t pages = (asset->height + 7) >> 3;
+    uint8_t shift = y & 7;
+    int16_t page0 = (y - shift) / 8;
+    bool shared = asset->mask == asset->data;
+
+    // Sem máscara: opaco, exceto as linhas além da altura na última página
+    uint8_t tail = (asset->height & 7) ? (uint8_t)((1u << (asset->height & 7)) - 1) : 0xFF;
+
+    // Colunas visíveis [c0, c1)
+    int16_t c0 = x < 0 ? -x : 0;
+    int16_t c1 = asset->width;
+    if (x + c1 > ssd->width) c1 = ssd->width - x;
+
+    rle_reader_t data = { .p = asset->data };
+    rle_reader_t mask = { .p = asset->mask };
+
+    for (uint8_t p = 0; p < pages; p++) {
+        int16_t lo = page0 + p;         // página que recebe os bits de cima
+        int16_t hi = lo + 1;            // página que recebe o resto (shift > 0)
+        bool lo_ok = lo >= 0 && lo < ssd->pages;
+        bool hi_ok = shift && hi >= 0 && hi < ssd->pages;
+
+        if (c1 <= c0 || (!lo_ok && !hi_ok)) {
+            // Página inteira fora da tela: só consome o fluxo
+            rle_skip(&data, asset->width);
+            if (asset->mask && !shared) rle_skip(&mask, asset->width);
+            continue;
+        }
+
+        rle_skip(&data, c0);
+        if (asset->mask && !shared) rle_skip(&mask, c0);
+
+        uint8_t fixed = (p == pages - 1) ? tail : 0xFF;
+        uint8_t *col = buf + (x + c0) * ssd->pages;
+        for (int16_t c = c0; c < c1; c++, col += ssd->pages) {
+            uint8_t d = rle_next(&data);
+            uint8_t m = shared ? d : (asset->mask ? rle_next(&mask) : fixed);
+            if (lo_ok) blend(&col[lo], (uint8_t)(d << shift), (uint8_t)(m << shift));
+            if (hi_ok) blend(&col[hi], d >> (8 - shift), m >> (8 - shift));
+        }
+
+        rle_skip(&data, asset->width - c1);
+        if (asset->mask && !shared) rle_skip(&mask, asset->width - c1);
+    }
+}
+
+uint8_t oled_asset_draw_number(ssd1306_t *ssd, const oled_asset_t *const digits[10],
+                               uint32_t value, int16_t x, int16_t y, uint8_t gap) {
+    char text[11];
+    uint8_t n = 0;
+
+    do {
+        text[n++] = value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    int16_t cx = x;
+    while (n > 0) {
+        const oled_asset_t *d = digits[(uint8_t)text[--n]];
+        oled_asset_draw(ssd, d, cx, y);
+        cx += d->width + (n > 0 ? gap : 0);
+    }
+    return (uint8_t)(cx - x);
+}
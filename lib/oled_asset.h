@@ -0,0 +1,39 @@
+/**
+ * oled_asset.h
+ * Bitmaps RLE no formato de página do SSD1306 (ícones, dígitos grandes)
+ *
+ * Os assets são gerados em tempo de build por tools/img2oled.py a partir
+ * dos PNGs em assets/oled/. O decodificador descomprime em fluxo direto
+ * no ram_buffer, sem buffer intermediário, com recorte nas bordas da tela
+ * e transparência por máscara.
+ */
+
+#ifndef OLED_ASSET_H
+#define OLED_ASSET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ssd1306.h"
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    const uint8_t *data;    // RLE, página a página, coluna a coluna
+    const uint8_t *mask;    // RLE (bit 1 = opaco); NULL = opaco; == data = só pixels acesos
+} oled_asset_t;
+
+/**
+ * Desenha um asset com o canto superior esquerdo em (x, y); partes fora
+ * da tela são recortadas
+ */
+void oled_asset_draw(ssd1306_t *ssd, const oled_asset_t *asset, int16_t x, int16_t y);
+
+/**
+ * Desenha um número com os assets de dígitos ('digits' indexado de 0 a 9)
+ * @param gap espaço entre dígitos em pixels
+ * @return largura desenhada em pixels
+ */
+uint8_t oled_asset_draw_number(ssd1306_t *ssd, const oled_asset_t *const digits[10],
+                               uint32_t value, int16_t x, int16_t y, uint8_t gap);
+
+#endif // OLED_ASSET_H
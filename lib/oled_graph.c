@@ -0,0 +1,142 @@
+/**
+ * Sparkline com rolagem por movimentação de bytes no ram_buffer
+ */
+
+#include <string.h>
+#include "oled_graph.h"
+
+void oled_graph_init(oled_graph_t *g, uint8_t x, uint8_t width, uint8_t page, uint8_t pages,
+                     int32_t min, int32_t max, oled_graph_agg_t agg, bool autoscale) {
+    memset(g, 0, sizeof(*g));
+    g->x = x;
+    g->width = width > OLED_GRAPH_MAX_COLS ? OLED_GRAPH_MAX_COLS : width;
+    g->page = page;
+    g->pages = pages;
+    g->min = min;
+    g->max = max > min ? max : min + 1;
+    g->agg = agg;
+    g->autoscale = autoscale;
+}
+
+void oled_graph_sample(oled_graph_t *g, int32_t value) {
+    if (g->agg == OLED_GRAPH_MAX) {
+        if (g->acc_n == 0 || value > g->acc) g->acc = value;
+    } else {
+        g->acc += value;
+    }
+    g->acc_n++;
+}
+
+#define RING_SIZE(g) ((g)->width + 1)
+
+// Coluna do anel 'age' intervalos atrás (0 = mais recente)
+static int32_t ring_at(const oled_graph_t *g, uint8_t age) {
+    return g->ring[(g->head + RING_SIZE(g) - 1 - age) % RING_SIZE(g)];
+}
+
+bool oled_graph_tick(oled_graph_t *g) {
+    int32_t v;
+
+    if (g->agg == OLED_GRAPH_SUM) {
+        v = (int32_t)g->acc;
+    } else if (g->acc_n == 0) {
+        v = g->count ? ring_at(g, 0) : g->min;     // sem amostras: repete
+    } else if (g->agg == OLED_GRAPH_AVG) {
+        v = (int32_t)(g->acc / (int64_t)g->acc_n);
+    } else {
+        v = (int32_t)g->acc;
+    }
+    g->acc = 0;
+    g->acc_n = 0;
+
+    g->ring[g->head] = v;
+    g->head = (g->head + 1) % RING_SIZE(g);
+    if (g->count < RING_SIZE(g)) g->count++;
+
+    bool rescaled = false;
+    while (g->autoscale && v > g->max) {
+        g->max = g->min + (g->max - g->min) * 2;
+        rescaled = true;
+    }
+    return rescaled;
+}
+
+// Linha (0 = topo da região) de um valor na escala atual
+static uint8_t value_row(const oled_graph_t *g, int32_t v) {
+    uint8_t h = g->pages * 8;
+    if (v <= g->min) return h - 1;
+    if (v >= g->max) return 0;
+    return (uint8_t)(h - 1 - (int64_t)(v - g->min) * (h - 1) / (g->max - g->min));
+}
+
+/**
+ * Desenha uma coluna: traço vertical ligando a linha do valor anterior à
+ * do atual (sparkline contínua)
+ * @param col ponteiro para a primeira página da região nessa coluna
+ */
+static void draw_column(const oled_graph_t *g, uint8_t *col, uint8_t row, uint8_t prev_row) {
+    uint8_t lo = row < prev_row ? row : prev_row;
+    uint8_t hi = row < prev_row ? prev_row : row;
+
+    for (uint8_t p = 0; p < g->pages; p++) {
+        uint8_t top = p * 8;
+        uint8_t bits = 0;
+        if (hi >= top && lo < top + 8) {
+            uint8_t a = lo > top ? lo - top : 0;
+            uint8_t b = hi < top + 7 ? hi - top : 7;
+            bits = (uint8_t)((0xFFu << a) & (0xFFu >> (7 - b)));
+        }
+        col[p] = bits;
+    }
+}
+
+void oled_graph_scroll(const oled_graph_t *g, ssd1306_t *ssd) {
+    uint8_t stride = ssd->pages;
+    uint8_t *base = &ssd->ram_buffer[1] + g->x * stride + g->page;
+
+    if (g->pages == stride) {
+        // Região com todas as páginas: um único bloco contíguo
+        memmove(base, base + stride, (g->width - 1) * stride);
+    } else {
+        for (uint8_t c = 0; c + 1 < g->width; c++) {
+            memcpy(base + c * stride, base + (c + 1) * stride, g->pages);
+        }
+    }
+
+    uint8_t row = value_row(g, ring_at(g, 0));
+    uint8_t prev = g->count > 1 ? value_row(g, ring_at(g, 1)) : row;
+    draw_column(g, base + (g->width - 1) * stride, row, prev);
+}
+
+void oled_graph_draw(const oled_graph_t *g, ssd1306_t *ssd) {
+    uint8_t stride = ssd->pages;
+    uint8_t *base = &ssd->ram_buffer[1] + g->x * stride + g->page;
+    uint8_t shown = g->count < g->width ? g->count : g->width;
+    uint8_t empty = g->width - shown;
+
+    // Colunas ainda sem histórico ficam apagadas, alinhando o mais recente à direita
+    for (uint8_t c = 0; c < empty; c++) {
+        memset(base + c * stride, 0, g->pages);
+    }
+    // Traço da coluna mais antiga parte da anterior a ela, se ainda no anel
+    uint8_t prev = g->count > g->width ? value_row(g, ring_at(g, g->width)) : 0xFF;
+    for (uint8_t c = empty; c < g->width; c++) {
+        uint8_t row = value_row(g, ring_at(g, g->width - 1 - c));
+        draw_column(g, base + c * stride, row, prev == 0xFF ? row : prev);
+        prev = row;
+    }
+}
+
+int32_t oled_graph_last(const oled_graph_t *g) {
+    return g->count ? ring_at(g, 0) : 0;
+}
+
+int64_t oled_graph_sum(const oled_graph_t *g, uint8_t n) {
+    int64_t sum = 0;
+    if (n > g->width) n = g->width;
+    if (n > g->count) n = g->count;
+    for (uint8_t i = 0; i < n; i++) {
+        sum += ring_at(g, i);
+    }
+    return sum;
+}
@@ -0,0 +1,83 @@
+/**
+ * oled_graph.h
+ * Gráfico de histórico (sparkline) com rolagem incremental no OLED
+ *
+ * Cada coluna do gráfico resume um intervalo (ex.: 1 s) de amostras:
+ * oled_graph_sample() acumula e oled_graph_tick() fecha a coluna no anel
+ * (média, máximo ou soma). A região ocupa páginas inteiras do ram_buffer,
+ * então rolar é mover bytes: com endereçamento vertical, as páginas de uma
+ * coluna são contíguas e a coluna seguinte fica 'pages' bytes adiante.
+ * Só a coluna nova é desenhada e só o retângulo do gráfico vai ao display.
+ */
+
+#ifndef OLED_GRAPH_H
+#define OLED_GRAPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define OLED_GRAPH_MAX_COLS 128
+
+typedef enum {
+    OLED_GRAPH_AVG,         // média das amostras do intervalo
+    OLED_GRAPH_MAX,         // pico do intervalo (latência)
+    OLED_GRAPH_SUM,         // contagem no intervalo (eventos)
+} oled_graph_agg_t;
+
+typedef struct {
+    // Região: colunas [x, x + width), páginas [page, page + pages)
+    uint8_t x, width, page, pages;
+    oled_graph_agg_t agg;
+    int32_t min, max;       // faixa vertical
+    bool autoscale;         // dobra 'max' quando um valor passa dela
+
+    // Anel com uma coluna por intervalo (mais recente em head - 1); guarda
+    // uma coluna além da largura, de onde parte o traço da mais antiga
+    int32_t ring[OLED_GRAPH_MAX_COLS + 1];
+    uint8_t head, count;
+
+    // Intervalo em andamento
+    int64_t acc;
+    uint32_t acc_n;
+} oled_graph_t;
+
+/**
+ * @param x, width colunas da região (width <= OLED_GRAPH_MAX_COLS)
+ * @param page, pages páginas da região (8 linhas cada)
+ */
+void oled_graph_init(oled_graph_t *g, uint8_t x, uint8_t width, uint8_t page, uint8_t pages,
+                     int32_t min, int32_t max, oled_graph_agg_t agg, bool autoscale);
+
+/**
+ * Acumula uma amostra no intervalo em andamento
+ */
+void oled_graph_sample(oled_graph_t *g, int32_t value);
+
+/**
+ * Fecha o intervalo: uma coluna nova no anel
+ * @return true se a escala mudou (o gráfico precisa de oled_graph_draw)
+ */
+bool oled_graph_tick(oled_graph_t *g);
+
+/**
+ * Rola a região uma coluna para a esquerda e desenha só a coluna nova
+ */
+void oled_graph_scroll(const oled_graph_t *g, ssd1306_t *ssd);
+
+/**
+ * Redesenha a região inteira a partir do anel (troca de tela, escala)
+ */
+void oled_graph_draw(const oled_graph_t *g, ssd1306_t *ssd);
+
+/**
+ * @return valor da coluna mais recente (0 se vazio)
+ */
+int32_t oled_graph_last(const oled_graph_t *g);
+
+/**
+ * @return soma das 'n' colunas mais recentes
+ */
+int64_t oled_graph_sum(const oled_graph_t *g, uint8_t n);
+
+#endif // OLED_GRAPH_H
@@ -0,0 +1,150 @@
+/**
+ * Monitoração de VSYS via ADC + DMA
+ * Média por bloco e detecção de tendência na IRQ do DMA; a temperatura do
+ * chip vem intercalada no mesmo fluxo (round-robin ADC3/ADC4)
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "power_monitor.h"
+
+// Clock do ADC é 48 MHz; período de amostragem = (1 + div) ciclos
+#define PM_ADC_CLKDIV ((48000000.0f / PM_SAMPLE_RATE_HZ) - 1.0f)
+
+// Buffer em anel: alinhado ao tamanho para o wrap de escrita do DMA
+#define PM_RING_BYTES (PM_BLOCK_SAMPLES * sizeof(uint16_t))
+static uint16_t pm_samples[PM_BLOCK_SAMPLES] __attribute__((aligned(PM_RING_BYTES)));
+
+static int pm_dma = -1;
+static power_fail_handler_t pm_handler = NULL;
+static volatile power_monitor_stats_t pm_stats;
+static uint16_t pm_last_mv = 0;
+static uint8_t pm_falling = 0;
+static int32_t pm_temp_acc = 0;        // média móvel << PM_TEMP_SMOOTH_LOG2
+static bool pm_temp_valid = false;
+
+static uint8_t pm_log2(uint32_t v) {
+    uint8_t n = 0;
+    while (v > 1) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static void pm_dma_irq(void) {
+    if (pm_dma < 0 || !dma_channel_get_irq1_status(pm_dma)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(pm_dma);
+
+    // Rearma já: o anel volta ao início e o FIFO do ADC segura 4 amostras
+    // (125 us em 32 kHz)
+    dma_channel_set_trans_count(pm_dma, PM_BLOCK_SAMPLES, true);
+
+    uint32_t even = 0, odd = 0;
+    for (uint i = 0; i < PM_BLOCK_SAMPLES; i += 2) {
+        even += pm_samples[i] & 0x0FFF;
+        odd += pm_samples[i + 1] & 0x0FFF;
+    }
+    // O round-robin começa em VSYS, mas uma amostra perdida inverte a fase
+    // para sempre. VSYS/3 (> 1,3 V com a placa alimentada) fica bem acima
+    // do sensor de temperatura (~0,7 V): o maior é VSYS
+    uint32_t sum = even > odd ? even : odd;
+    uint32_t temp_sum = even > odd ? odd : even;
+
+    // VSYS = 3 * leitura, referência de 3,3 V em 12 bits
+    uint16_t mv = (uint16_t)((sum * 3u * 3300u) / (4096u * PM_BLOCK_SAMPLES / 2));
+
+    // Sensor: T = 27 - (V - 0,706) / 0,001721 (V em décimos de mV)
+    int32_t v = (int32_t)((temp_sum * 33000u) / (4096u * PM_BLOCK_SAMPLES / 2));
+    int32_t t_c10 = 270 - ((v - 7060) * 1000) / 1721;
+    if (!pm_temp_valid) {
+        pm_temp_acc = t_c10 << PM_TEMP_SMOOTH_LOG2;
+        pm_temp_valid = true;
+    }
+    pm_temp_acc += t_c10 - (pm_temp_acc >> PM_TEMP_SMOOTH_LOG2);
+    pm_stats.temp_c10 = (int16_t)(pm_temp_acc >> PM_TEMP_SMOOTH_LOG2);
+
+    pm_stats.vsys_mv = mv;
+    pm_stats.blocks++;
+    if (mv < pm_stats.min_mv) pm_stats.min_mv = mv;
+
+    if (!pm_stats.armed) {
+        // Só arma com alimentação boa (evita disparo alimentado por 3V3)
+        if (mv >= PM_ARM_MV) pm_stats.armed = true;
+        pm_falling = 0;
+    } else if (mv < PM_WARN_MV && mv < pm_last_mv) {
+        if (++pm_falling >= PM_TREND_BLOCKS) {
+            pm_stats.armed = false;
+            pm_stats.triggers++;
+            pm_falling = 0;
+            if (pm_handler) pm_handler(mv);
+        }
+    } else if (mv >= PM_WARN_MV) {
+        pm_falling = 0;
+    }
+    pm_last_mv = mv;
+}
+
+bool power_monitor_init(power_fail_handler_t handler) {
+    pm_dma = dma_claim_unused_channel(false);
+    if (pm_dma < 0) {
+        printf("ERRO: sem canal DMA para monitor de VSYS\n");
+        return false;
+    }
+    pm_handler = handler;
+    pm_stats.min_mv = 0xFFFF;
+
+    adc_init();
+    adc_gpio_init(PM_VSYS_GPIO);
+    adc_set_temp_sensor_enabled(true);
+    adc_select_input(PM_VSYS_ADC_INPUT);
+    adc_set_round_robin((1u << PM_VSYS_ADC_INPUT) | (1u << PM_TEMP_ADC_INPUT));
+    adc_fifo_setup(true,    // amostras vão para o FIFO
+                   true,    // DREQ para o DMA
+                   1,       // DREQ a cada amostra
+                   false,   // sem bit de erro
+                   false);  // 12 bits completos
+    adc_set_clkdiv(PM_ADC_CLKDIV);
+
+    dma_channel_config c = dma_channel_get_default_config(pm_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, pm_log2(PM_RING_BYTES));
+    channel_config_set_dreq(&c, DREQ_ADC);
+
+    dma_channel_configure(pm_dma, &c, pm_samples, &adc_hw->fifo, PM_BLOCK_SAMPLES, false);
+
+    dma_channel_set_irq1_enabled(pm_dma, true);
+    irq_add_shared_handler(DMA_IRQ_1, pm_dma_irq, PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+    irq_set_priority(DMA_IRQ_1, 0);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(pm_dma);
+    adc_run(true);
+    return true;
+}
+
+bool power_monitor_flash_ok(void) {
+    if (pm_dma < 0) {
+        return true;
+    }
+    bool ok = pm_stats.armed ? pm_stats.vsys_mv >= PM_ARM_MV : pm_stats.triggers == 0;
+    if (!ok) {
+        printf("ERRO: VSYS %umV sem folga para apagar a flash\n", pm_stats.vsys_mv);
+    }
+    return ok;
+}
+
+void power_monitor_get_stats(power_monitor_stats_t *stats) {
+    stats->vsys_mv = pm_stats.vsys_mv;
+    stats->min_mv = pm_stats.min_mv;
+    stats->blocks = pm_stats.blocks;
+    stats->triggers = pm_stats.triggers;
+    stats->temp_c10 = pm_stats.temp_c10;
+    stats->armed = pm_stats.armed;
+}
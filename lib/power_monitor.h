@@ -0,0 +1,64 @@
+/**
+ * power_monitor.h
+ * Monitoração contínua de VSYS (ADC3 = VSYS/3 no Pico) com alerta de queda
+ *
+ * O ADC roda livre e o DMA copia as amostras para um buffer em anel; a
+ * cada bloco completo a IRQ do DMA calcula a média e verifica a tendência.
+ * Tensão abaixo do limiar e caindo por blocos seguidos dispara o
+ * tratador de emergência, ainda dentro da IRQ.
+ *
+ * O ADC alterna (round-robin) entre VSYS e o sensor de temperatura
+ * interno (ADC4): amostras pares são VSYS, ímpares temperatura. A
+ * temperatura é a do chip, que com a placa ociosa acompanha a ambiente;
+ * a média móvel longa serve às regras (rule_engine), não a alarmes.
+ */
+
+#ifndef POWER_MONITOR_H
+#define POWER_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hw_config.h"
+
+#define PM_VSYS_GPIO        HW_PIN_VSYS
+#define PM_VSYS_ADC_INPUT   (HW_PIN_VSYS - 26)
+#define PM_TEMP_ADC_INPUT   4
+#define PM_SAMPLE_RATE_HZ   32000   // total dos dois canais
+#define PM_BLOCK_SAMPLES    32      // 1 bloco = 1 ms, 16 de cada canal (potência de 2)
+#define PM_TEMP_SMOOTH_LOG2 8       // média móvel da temperatura: ~256 blocos
+
+#define PM_ARM_MV           4400    // arma o alerta só com VSYS acima disso
+#define PM_WARN_MV          4200    // limiar de queda
+#define PM_TREND_BLOCKS     2       // blocos seguidos em queda para disparar
+
+// Tratador de emergência: roda em contexto de IRQ, sem printf
+typedef void (*power_fail_handler_t)(uint16_t vsys_mv);
+
+typedef struct {
+    uint16_t vsys_mv;       // média do último bloco
+    uint16_t min_mv;        // menor média desde o boot
+    uint32_t blocks;        // blocos processados
+    uint32_t triggers;      // disparos do tratador
+    int16_t temp_c10;       // temperatura do chip em décimos de grau (média móvel)
+    bool armed;
+} power_monitor_stats_t;
+
+/**
+ * Configura ADC + DMA e começa a amostrar
+ * @param handler Chamado uma vez por queda detectada
+ * @return false se não há canal de DMA livre
+ */
+bool power_monitor_init(power_fail_handler_t handler);
+
+void power_monitor_get_stats(power_monitor_stats_t *stats);
+
+/**
+ * VSYS com folga para apagar um setor da flash: até ~400 ms com as
+ * interrupções desligadas, sem a IRQ do monitor ver uma queda. Sem o
+ * monitor rodando (boot) ou sem alerta armado não há queda a perder
+ * @return false (e imprime o motivo) com o alerta armado e VSYS abaixo de
+ *         PM_ARM_MV, ou depois de um disparo até a alimentação voltar
+ */
+bool power_monitor_flash_ok(void);
+
+#endif // POWER_MONITOR_H
@@ -0,0 +1,140 @@
+/**
+ * Registro de emergência em queda de energia
+ * Uma página por registro em um setor mantido apagado
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "power_monitor.h"
+#include "wdt_lease.h"
+#include "powerfail_log.h"
+
+#define PF_MAGIC            0x4C465750u   // "PWFL"
+#define PF_PAGES            (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define PF_MIN_FREE_PAGES   2             // páginas livres garantidas no boot
+#define PF_ERASE_LEASE_MS   1000
+
+static uint16_t pf_next_page = PF_PAGES;
+static uint32_t pf_seq = 0;
+static bool pf_has_pending = false;
+static powerfail_record_t pf_pending;
+
+// Pedido da IRQ da queda, ainda não gravado
+static volatile bool pf_requested = false;
+static powerfail_record_t pf_request;
+
+// Buffer de página em RAM: a emergência não pode depender da pilha
+static uint8_t pf_page[FLASH_PAGE_SIZE];
+
+static const powerfail_record_t *pf_record_ptr(uint16_t page) {
+    return (const powerfail_record_t *)FLASH_XIP_PTR(FLASH_PF_OFFSET + (uint32_t)page * FLASH_PAGE_SIZE);
+}
+
+static uint32_t pf_crc(const powerfail_record_t *rec) {
+    return crc32_compute(rec, offsetof(powerfail_record_t, consumed));
+}
+
+static bool pf_page_empty(uint16_t page) {
+    const uint32_t *w = (const uint32_t *)pf_record_ptr(page);
+    for (size_t i = 0; i < sizeof(powerfail_record_t) / 4; i++) {
+        if (w[i] != 0xFFFFFFFFu) return false;
+    }
+    return true;
+}
+
+static void pf_program_page(uint16_t page) {
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(FLASH_PF_OFFSET + (uint32_t)page * FLASH_PAGE_SIZE, pf_page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+}
+
+void powerfail_log_init(void) {
+    int16_t last_valid = -1;
+    uint16_t first_free = 0;
+
+    for (uint16_t page = 0; page < PF_PAGES; page++) {
+        if (pf_page_empty(page)) {
+            continue;
+        }
+        // Página usada (mesmo que corrompida): a próxima livre vem depois
+        first_free = page + 1;
+
+        powerfail_record_t rec;
+        memcpy(&rec, pf_record_ptr(page), sizeof(rec));
+        if (rec.magic == PF_MAGIC && rec.crc == pf_crc(&rec)) {
+            last_valid = page;
+            if (rec.seq >= pf_seq) pf_seq = rec.seq + 1;
+        }
+    }
+    pf_next_page = first_free;
+
+    // Registro novo: guarda em RAM e marca como consumido na flash
+    if (last_valid >= 0) {
+        memcpy(&pf_pending, pf_record_ptr(last_valid), sizeof(pf_pending));
+        if (pf_pending.consumed == 0xFFFFFFFFu) {
+            pf_has_pending = true;
+            memset(pf_page, 0xFF, sizeof(pf_page));
+            memset(&pf_page[offsetof(powerfail_record_t, consumed)], 0, sizeof(uint32_t));
+            pf_program_page(last_valid);
+        }
+    }
+
+    // Garante páginas apagadas para a próxima emergência
+    if (PF_PAGES - pf_next_page < PF_MIN_FREE_PAGES && power_monitor_flash_ok()) {
+        bool leased = wdt_lease_begin(PF_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+        uint32_t irq = save_and_disable_interrupts();
+        flash_range_erase(FLASH_PF_OFFSET, FLASH_SECTOR_SIZE);
+        restore_interrupts(irq);
+        if (leased) {
+            wdt_lease_end();
+        }
+        pf_next_page = 0;
+    }
+}
+
+bool powerfail_log_take(powerfail_record_t *rec) {
+    if (!pf_has_pending) return false;
+    *rec = pf_pending;
+    pf_has_pending = false;
+    return true;
+}
+
+bool powerfail_log_commit(powerfail_record_t *rec) {
+    if (pf_next_page >= PF_PAGES) {
+        return false;
+    }
+
+    rec->magic = PF_MAGIC;
+    rec->seq = pf_seq++;
+    rec->consumed = 0xFFFFFFFFu;
+    rec->crc = pf_crc(rec);
+
+    memset(pf_page, 0xFF, sizeof(pf_page));
+    memcpy(pf_page, rec, sizeof(*rec));
+    pf_program_page(pf_next_page++);
+    return true;
+}
+
+void powerfail_log_request(const powerfail_record_t *rec) {
+    if (pf_requested) {
+        return;
+    }
+    pf_request = *rec;
+    pf_requested = true;
+}
+
+bool powerfail_log_service(void) {
+    if (!pf_requested) {
+        return false;
+    }
+    uint32_t irq = save_and_disable_interrupts();
+    powerfail_record_t rec = pf_request;
+    pf_requested = false;
+    restore_interrupts(irq);
+    return powerfail_log_commit(&rec);
+}
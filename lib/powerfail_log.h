@@ -0,0 +1,79 @@
+/**
+ * powerfail_log.h
+ * Registro mínimo de estado gravado na queda de energia
+ *
+ * Um setor de flash é mantido apagado com antecedência (no boot, com a
+ * alimentação boa). Na emergência só é preciso programar uma página
+ * (~1 ms com as interrupções desligadas), o que cabe no tempo de
+ * sustentação dos capacitores de VSYS.
+ *
+ * O tratador da queda roda na IRQ do DMA do monitor de VSYS e não toca a
+ * flash: powerfail_log_request só copia o registro para a RAM. A página é
+ * programada em powerfail_log_service, fora de IRQ, no laço principal e
+ * nas esperas do console (input_trace_getchar). Assim a gravação nunca
+ * interrompe outra operação na flash nem a leitura do disco USB_MSC
+ * (tud_msc_read10_cb, IRQ do USB), que copia setores direto da XIP.
+ *
+ * Os apagamentos de setor (até ~400 ms sem interrupções, a IRQ do monitor
+ * inclusive) conferem power_monitor_flash_ok antes de começar.
+ *
+ * Só o core 0 executa código (pico_multicore não é usado): nenhum outro
+ * core roda da flash durante a gravação, por isso não há
+ * multicore_lockout. Quem passar a usar o core 1 precisa tirá-lo da
+ * flash antes de qualquer gravação.
+ */
+
+#ifndef POWERFAIL_LOG_H
+#define POWERFAIL_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t uptime_ms;
+    uint16_t vsys_mv;       // tensão no momento do disparo
+    uint8_t ac_state;       // último estado do AC
+    uint8_t flags;          // PF_FLAG_*
+    uint32_t wdt_resets;    // scratch[0]
+    uint32_t last_fault;    // scratch[1]
+    uint32_t consumed;      // 0xFFFFFFFF até ser lido no boot
+    uint32_t crc;           // CRC dos campos anteriores (exceto consumed)
+} powerfail_record_t;
+
+#define PF_FLAG_IR_ABORTED  0x01   // havia transmissão IR em andamento
+
+/**
+ * Localiza o último registro e garante páginas apagadas para a próxima
+ * emergência (pode apagar o setor: chamar com a alimentação estável)
+ */
+void powerfail_log_init(void);
+
+/**
+ * Último registro ainda não consumido
+ * @return false se não há registro novo desde o último boot
+ */
+bool powerfail_log_take(powerfail_record_t *rec);
+
+/**
+ * Grava um registro na próxima página apagada (fora de IRQ)
+ * @return false se não havia página livre
+ */
+bool powerfail_log_commit(powerfail_record_t *rec);
+
+/**
+ * Guarda o registro em RAM para o próximo powerfail_log_service (seguro em
+ * IRQ: não toca a flash). Um pedido por vez; os seguintes até a gravação
+ * são ignorados
+ */
+void powerfail_log_request(const powerfail_record_t *rec);
+
+/**
+ * Grava o registro pedido, se houver (chamar no laço principal e nas
+ * esperas longas)
+ * @return true se gravou
+ */
+bool powerfail_log_service(void);
+
+#endif // POWERFAIL_LOG_H
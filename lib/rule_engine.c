@@ -0,0 +1,397 @@
+/**
+ * Regras de automação em bytecode
+ * Validação única na carga, avaliação incremental com orçamento por poll
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "hex_line.h"
+#include "input_trace.h"
+#include "power_monitor.h"
+#include "wdt_lease.h"
+#include "rule_engine.h"
+
+#define RULES_ERASE_LEASE_MS  1000
+#define CLOCK_MAGIC           0x4B4C4352u   // "RCLK": hora acertada
+#define MS_PER_DAY            (24u * 60u * 60u * 1000u)
+
+static const char *const input_names[RULE_IN_COUNT] = {
+    [RULE_IN_TEMP] = "temp", [RULE_IN_IDLE] = "idle",
+    [RULE_IN_CLOCK] = "hora", [RULE_IN_STATE] = "estado",
+};
+
+// Programa ativo (flash ou buffer do chamador) e o que a carga derivou dele
+static const rule_header_t *program = NULL;
+static const rule_entry_t *table;
+static const uint8_t *code;
+static size_t program_bytes;
+static uint8_t rule_cost[RULE_MAX_RULES];       // instruções
+static uint8_t rule_deps[RULE_MAX_RULES];       // bit n = lê a entrada n
+static uint32_t rule_evals[RULE_MAX_RULES];
+static uint32_t input_rules[RULE_IN_COUNT];     // regras que leem cada entrada
+
+static int32_t inputs[RULE_IN_COUNT];
+static uint8_t inputs_valid;                    // bit n = entrada n recebida
+static uint8_t cursor;                          // rodízio entre as pendentes
+static rule_action_t action_fn = NULL;
+static rule_engine_stats_t stats;
+
+// Hora: avança pelo relógio do boot; sobrevive a resets na RAM não inicializada
+static uint32_t __uninitialized_ram(clock_magic);
+static uint32_t __uninitialized_ram(clock_ms_of_day);
+static uint32_t clock_last_ms;
+
+static uint8_t load_buf[RULE_MAX_BYTES] __attribute__((aligned(4)));
+
+// ===== VALIDAÇÃO =====
+
+// Confere uma regra inteira: instruções conhecidas, operandos dentro do
+// código, pilha sem estouro e um resultado no fim. Depois disso a
+// avaliação não confere nada
+static bool check_rule(uint8_t r) {
+    const rule_entry_t *e = &table[r];
+    if (e->length == 0 || e->offset + e->length > program->code_len) {
+        return false;
+    }
+    const uint8_t *pc = code + e->offset;
+    const uint8_t *end = pc + e->length;
+    unsigned depth = 0, ops = 0;
+    uint8_t deps = 0;
+
+    while (pc < end) {
+        uint8_t op = *pc++;
+        switch (op) {
+            case RULE_OP_PUSH8:  pc += 1; depth++; break;
+            case RULE_OP_PUSH16: pc += 2; depth++; break;
+            case RULE_OP_PUSH32: pc += 4; depth++; break;
+            case RULE_OP_LOAD:
+                if (pc >= end || *pc >= RULE_IN_COUNT) {
+                    return false;
+                }
+                deps |= (uint8_t)(1u << *pc++);
+                depth++;
+                break;
+            case RULE_OP_EQ: case RULE_OP_NE: case RULE_OP_LT:
+            case RULE_OP_LE: case RULE_OP_GT: case RULE_OP_GE:
+            case RULE_OP_AND: case RULE_OP_OR:
+                if (depth < 2) {
+                    return false;
+                }
+                depth--;
+                break;
+            case RULE_OP_NOT:
+                if (depth < 1) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+        if (pc > end || depth > RULE_STACK_MAX || ++ops > RULE_MAX_OPS) {
+            return false;
+        }
+    }
+    if (depth != 1) {
+        return false;
+    }
+    rule_cost[r] = (uint8_t)ops;
+    rule_deps[r] = deps;
+    return true;
+}
+
+bool rule_engine_load(const uint8_t *blob, size_t size) {
+    program = NULL;
+    stats.rules = 0;
+    stats.dirty = 0;
+    stats.value = 0;
+    memset(input_rules, 0, sizeof(input_rules));
+    memset(rule_evals, 0, sizeof(rule_evals));
+
+    const rule_header_t *hdr = (const rule_header_t *)blob;
+    if (size < sizeof(rule_header_t) || hdr->magic != RULE_MAGIC ||
+        hdr->rules == 0 || hdr->rules > RULE_MAX_RULES) {
+        return false;
+    }
+    size_t body = hdr->rules * sizeof(rule_entry_t) + hdr->code_len;
+    if (sizeof(rule_header_t) + body > size || sizeof(rule_header_t) + body > RULE_MAX_BYTES ||
+        hdr->crc != crc32_compute(hdr + 1, body)) {
+        return false;
+    }
+
+    program = hdr;
+    table = (const rule_entry_t *)(hdr + 1);
+    code = (const uint8_t *)(table + hdr->rules);
+    for (uint8_t r = 0; r < hdr->rules; r++) {
+        if (!check_rule(r)) {
+            program = NULL;
+            return false;
+        }
+        for (uint8_t i = 0; i < RULE_IN_COUNT; i++) {
+            if (rule_deps[r] & (1u << i)) {
+                input_rules[i] |= 1u << r;
+            }
+        }
+    }
+    program_bytes = sizeof(rule_header_t) + body;
+    stats.rules = hdr->rules;
+    stats.dirty = (uint32_t)((1ull << hdr->rules) - 1);
+    cursor = 0;
+    return true;
+}
+
+// ===== FLASH =====
+
+static bool load_from_flash(void) {
+    return rule_engine_load(FLASH_XIP_PTR(FLASH_RULES_OFFSET), FLASH_SECTOR_SIZE);
+}
+
+// Grava (ou só apaga, com size 0) o setor; o programa ativo é descartado.
+// Com VSYS sem folga não toca em nada
+static bool write_flash(const uint8_t *data, size_t size) {
+    if (!power_monitor_flash_ok()) {
+        return false;
+    }
+    program = NULL;
+    stats.rules = 0;
+    stats.dirty = 0;
+    size = (size + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1);
+
+    bool leased = wdt_lease_begin(RULES_ERASE_LEASE_MS, WDT_LEASE_FLASH);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(FLASH_RULES_OFFSET, FLASH_SECTOR_SIZE);
+    if (size) {
+        flash_range_program(FLASH_RULES_OFFSET, data, size);
+    }
+    restore_interrupts(irq);
+    if (leased) {
+        wdt_lease_end();
+    }
+    return true;
+}
+
+void rule_engine_init(rule_action_t action) {
+    action_fn = action;
+    clock_last_ms = to_ms_since_boot(get_absolute_time());
+
+    if (clock_magic == CLOCK_MAGIC && clock_ms_of_day < MS_PER_DAY) {
+        rule_engine_set_input(RULE_IN_CLOCK, (int32_t)(clock_ms_of_day / 60000u));
+        printf("Regras: hora restaurada %02lu:%02lu\n",
+               (unsigned long)(clock_ms_of_day / 3600000u),
+               (unsigned long)(clock_ms_of_day / 60000u % 60u));
+    } else {
+        clock_magic = 0;
+    }
+
+    if (load_from_flash()) {
+        printf("Regras: %u na flash, %u bytes\n", stats.rules, (unsigned)program_bytes);
+    } else if (((const rule_header_t *)FLASH_XIP_PTR(FLASH_RULES_OFFSET))->magic == RULE_MAGIC) {
+        printf("Regras: programa invalido na flash\n");
+    }
+}
+
+bool rule_engine_load_line(void) {
+    absolute_time_t deadline = make_timeout_time_ms(RULE_LOAD_MS);
+    hex_line_t line;
+
+    hex_line_begin(&line, load_buf, sizeof(load_buf), "U ");
+    bool leased = wdt_lease_begin(RULE_LOAD_MS + 100, WDT_LEASE_CONSOLE);
+    while (!time_reached(deadline)) {
+        int ch = input_trace_getchar(1000);
+        if (ch == PICO_ERROR_TIMEOUT) {
+            continue;
+        }
+        if (!hex_line_feed(&line, ch)) {
+            break;
+        }
+    }
+    if (leased) {
+        wdt_lease_end();
+    }
+
+    if (!line.ok || !rule_engine_load(load_buf, line.length) || program_bytes != line.length) {
+        printf("Regras: linha @RU invalida (%u bytes)\n", (unsigned)line.length);
+        load_from_flash();      // continua com o programa anterior
+        return false;
+    }
+    if (!write_flash(load_buf, line.length)) {
+        load_from_flash();
+        return false;
+    }
+    if (!load_from_flash()) {
+        printf("ERRO: regras gravadas nao conferem\n");
+        return false;
+    }
+    printf("Regras: %u carregadas, %u bytes\n", stats.rules, (unsigned)program_bytes);
+    return true;
+}
+
+bool rule_engine_erase(void) {
+    return write_flash(NULL, 0);
+}
+
+// ===== AVALIAÇÃO =====
+
+void rule_engine_set_input(rule_input_t input, int32_t value) {
+    uint8_t bit = (uint8_t)(1u << input);
+    if ((inputs_valid & bit) && inputs[input] == value) {
+        return;
+    }
+    inputs[input] = value;
+    inputs_valid |= bit;
+    stats.dirty |= input_rules[input];
+}
+
+void rule_engine_set_clock(uint16_t minute_of_day, uint32_t now_ms) {
+    clock_ms_of_day = (uint32_t)(minute_of_day % 1440u) * 60000u;
+    clock_last_ms = now_ms;
+    clock_magic = CLOCK_MAGIC;
+    rule_engine_set_input(RULE_IN_CLOCK, (int32_t)(clock_ms_of_day / 60000u));
+}
+
+// Código já validado: sem conferências no caminho quente
+static bool rule_run(uint8_t r) {
+    int32_t stack[RULE_STACK_MAX];
+    unsigned sp = 0;
+    const uint8_t *pc = code + table[r].offset;
+    const uint8_t *end = pc + table[r].length;
+
+    while (pc < end) {
+        switch (*pc++) {
+            case RULE_OP_PUSH8:
+                stack[sp++] = (int8_t)pc[0];
+                pc += 1;
+                break;
+            case RULE_OP_PUSH16:
+                stack[sp++] = (int16_t)(pc[0] | (pc[1] << 8));
+                pc += 2;
+                break;
+            case RULE_OP_PUSH32:
+                stack[sp++] = (int32_t)(pc[0] | (pc[1] << 8) | (pc[2] << 16) | ((uint32_t)pc[3] << 24));
+                pc += 4;
+                break;
+            case RULE_OP_LOAD: stack[sp++] = inputs[*pc++]; break;
+            case RULE_OP_EQ:  sp--; stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+            case RULE_OP_NE:  sp--; stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+            case RULE_OP_LT:  sp--; stack[sp - 1] = stack[sp - 1] <  stack[sp]; break;
+            case RULE_OP_LE:  sp--; stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+            case RULE_OP_GT:  sp--; stack[sp - 1] = stack[sp - 1] >  stack[sp]; break;
+            case RULE_OP_GE:  sp--; stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+            case RULE_OP_AND: sp--; stack[sp - 1] = stack[sp - 1] && stack[sp]; break;
+            case RULE_OP_OR:  sp--; stack[sp - 1] = stack[sp - 1] || stack[sp]; break;
+            case RULE_OP_NOT: stack[sp - 1] = !stack[sp - 1]; break;
+        }
+    }
+    return stack[0] != 0;
+}
+
+uint8_t rule_engine_poll(uint32_t now_ms) {
+    if (clock_magic == CLOCK_MAGIC) {
+        clock_ms_of_day = (clock_ms_of_day + (now_ms - clock_last_ms)) % MS_PER_DAY;
+        rule_engine_set_input(RULE_IN_CLOCK, (int32_t)(clock_ms_of_day / 60000u));
+    }
+    clock_last_ms = now_ms;
+    if (!program || !stats.dirty) {
+        return 0;
+    }
+
+    uint32_t t0 = time_us_32();
+    uint32_t rising = 0;
+    unsigned budget = RULE_TICK_OPS;
+    for (uint8_t n = 0; n < stats.rules && stats.dirty; n++) {
+        uint8_t r = cursor;
+        uint32_t bit = 1u << r;
+        if (!(stats.dirty & bit)) {
+            cursor = (uint8_t)((cursor + 1) % stats.rules);
+            continue;
+        }
+        if (rule_cost[r] > budget) {
+            stats.deferred++;       // continua desta regra no próximo poll
+            break;
+        }
+        cursor = (uint8_t)((cursor + 1) % stats.rules);
+        stats.dirty &= ~bit;
+
+        // Entrada ainda não recebida (ex.: hora): condição falsa
+        bool v = false;
+        if ((rule_deps[r] & ~inputs_valid) == 0) {
+            budget -= rule_cost[r];
+            stats.ops += rule_cost[r];
+            v = rule_run(r);
+        }
+        stats.evaluations++;
+        rule_evals[r]++;
+        if (v && !(stats.value & bit)) {
+            rising |= bit;
+        }
+        stats.value = v ? (stats.value | bit) : (stats.value & ~bit);
+    }
+    uint32_t elapsed = time_us_32() - t0;
+    if (elapsed > stats.max_poll_us) {
+        stats.max_poll_us = elapsed;
+    }
+
+    // Ações fora da avaliação (imprimem e põem quadros na fila IR); uma
+    // ação recusada volta a valer falso e dispara de novo na próxima
+    // avaliação verdadeira
+    uint8_t fired = 0;
+    for (uint8_t r = 0; rising && r < stats.rules; r++) {
+        uint32_t bit = 1u << r;
+        if (!(rising & bit)) {
+            continue;
+        }
+        rising &= ~bit;
+        fired++;
+        if (action_fn && !action_fn(table[r].action)) {
+            stats.value &= ~bit;
+        }
+    }
+    stats.fired += fired;
+    return fired;
+}
+
+void rule_engine_get_stats(rule_engine_stats_t *out) {
+    *out = stats;
+    out->clock_set = (clock_magic == CLOCK_MAGIC);
+}
+
+void rule_engine_print(void) {
+    printf("\n=== REGRAS ===\n");
+    if (clock_magic == CLOCK_MAGIC) {
+        printf("Hora: %02lu:%02lu\n", (unsigned long)(clock_ms_of_day / 3600000u),
+               (unsigned long)(clock_ms_of_day / 60000u % 60u));
+    } else {
+        printf("Hora: nao acertada\n");
+    }
+    printf("Entradas:");
+    for (uint8_t i = 0; i < RULE_IN_COUNT; i++) {
+        if (inputs_valid & (1u << i)) {
+            printf(" %s=%ld", input_names[i], (long)inputs[i]);
+        } else {
+            printf(" %s=-", input_names[i]);
+        }
+    }
+    printf("\n");
+    if (!program) {
+        printf("Nenhum programa (tools/rulec.py gera a linha @RU)\n");
+        return;
+    }
+    printf(" #  acao custo valor aval.  entradas\n");
+    for (uint8_t r = 0; r < stats.rules; r++) {
+        printf("%2u  %4u %5u %5u %6lu ", r, table[r].action, rule_cost[r],
+               (unsigned)((stats.value >> r) & 1u), (unsigned long)rule_evals[r]);
+        for (uint8_t i = 0; i < RULE_IN_COUNT; i++) {
+            if (rule_deps[r] & (1u << i)) {
+                printf(" %s", input_names[i]);
+            }
+        }
+        printf("%s\n", (stats.dirty >> r) & 1u ? " (pendente)" : "");
+    }
+    printf("Avaliacoes %lu, instrucoes %llu, disparos %lu, polls adiados %lu, max %luus\n",
+           (unsigned long)stats.evaluations, (unsigned long long)stats.ops,
+           (unsigned long)stats.fired, (unsigned long)stats.deferred,
+           (unsigned long)stats.max_poll_us);
+}
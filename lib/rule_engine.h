@@ -0,0 +1,146 @@
+/**
+ * rule_engine.h
+ * Regras de automação locais: bytecode de pilha compilado no host
+ *
+ * Regras como "if no button for 2h and after 18:00 then off" ou
+ * "if temp above 27 then fan 2" são compiladas por tools/rulec.py para um
+ * programa compacto, que chega pelo console como linha "@RU <hex>" e
+ * fica num setor de flash. O firmware não interpreta texto.
+ *
+ * Cada regra é uma condição (código sem desvios, executado direto da
+ * flash) e uma ação (estado da aplicação). As entradas (temperatura,
+ * tempo sem uso, hora, estado) são atualizadas pelo loop principal; só as
+ * regras que leem uma entrada alterada são marcadas para reavaliar.
+ * Como o código não tem desvios, o custo de cada regra (instruções) é
+ * conhecido na carga: cada poll executa no máximo RULE_TICK_OPS
+ * instruções e o que sobrar fica para o próximo.
+ *
+ * A ação dispara na borda (condição passa de falsa a verdadeira), uma
+ * vez; uma regra com entrada inválida (ex.: hora não acertada) é falsa.
+ *
+ * Formato (little-endian):
+ *   rule_header_t
+ *   regras x rule_entry_t (offset no código, tamanho, ação)
+ *   código
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RULE_MAGIC          0x314C5552u   // "RUL1"
+#define RULE_MAX_RULES      32            // máscaras de 32 bits
+#define RULE_MAX_BYTES      1024          // programa inteiro (cabeçalho + tabela + código)
+#define RULE_STACK_MAX      8
+#define RULE_MAX_OPS        64            // instruções por regra
+#define RULE_TICK_OPS       256           // instruções por poll
+#define RULE_LOAD_MS        5000          // prazo para colar uma linha @RU
+
+// Entradas lidas pelas regras (mesmos índices em tools/rulec.py)
+typedef enum {
+    RULE_IN_TEMP = 0,       // décimos de grau
+    RULE_IN_IDLE,           // segundos desde o último botão/comando
+    RULE_IN_CLOCK,          // minuto do dia (inválida até acertar a hora)
+    RULE_IN_STATE,          // estado atual da aplicação
+    RULE_IN_COUNT
+} rule_input_t;
+
+// Instruções (operandos little-endian logo após o código)
+typedef enum {
+    RULE_OP_PUSH8 = 0x01,   // int8
+    RULE_OP_PUSH16,         // int16
+    RULE_OP_PUSH32,         // int32
+    RULE_OP_LOAD,           // uint8 entrada
+    RULE_OP_EQ = 0x10,      // a b -> a == b
+    RULE_OP_NE,
+    RULE_OP_LT,
+    RULE_OP_LE,
+    RULE_OP_GT,
+    RULE_OP_GE,
+    RULE_OP_AND = 0x20,     // a b -> a && b
+    RULE_OP_OR,
+    RULE_OP_NOT,            // a -> !a
+} rule_op_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t rules;
+    uint8_t reserved;
+    uint16_t code_len;
+    uint32_t crc;           // CRC da tabela + código
+} rule_header_t;
+
+typedef struct {
+    uint16_t offset;        // no código
+    uint8_t length;         // bytes
+    uint8_t action;         // estado da aplicação
+} rule_entry_t;
+
+// Ação de uma regra: roda no poll, fora da avaliação
+typedef bool (*rule_action_t)(uint8_t action);
+
+typedef struct {
+    uint8_t rules;
+    uint32_t dirty;         // regras esperando avaliação
+    uint32_t value;         // última condição de cada regra
+    uint32_t evaluations;
+    uint32_t fired;         // ações disparadas
+    uint32_t deferred;      // polls que esgotaram RULE_TICK_OPS
+    uint64_t ops;           // instruções executadas
+    uint32_t max_poll_us;
+    bool clock_set;
+} rule_engine_stats_t;
+
+/**
+ * Carrega o programa da flash e restaura a hora acertada antes de um
+ * reset
+ * @param action Chamada quando uma regra dispara
+ */
+void rule_engine_init(rule_action_t action);
+
+/**
+ * Valida e ativa um programa; todas as regras ficam pendentes
+ * @param blob Programa (deve permanecer válido, ex.: na flash)
+ * @return false se o programa é inválido (o anterior é descartado)
+ */
+bool rule_engine_load(const uint8_t *blob, size_t size);
+
+/**
+ * Lê uma linha "RU <hex>" (o '@' e o 'R' já foram lidos) e grava o
+ * programa na flash
+ * @return false se a linha é inválida
+ */
+bool rule_engine_load_line(void);
+
+/**
+ * Apaga o programa da flash
+ * @return false se a flash não pôde ser apagada (VSYS sem folga)
+ */
+bool rule_engine_erase(void);
+
+/**
+ * Atualiza uma entrada; marca as regras que a leem se o valor mudou
+ */
+void rule_engine_set_input(rule_input_t input, int32_t value);
+
+/**
+ * Acerta a hora. Não há RTC: a hora fica em RAM não inicializada e
+ * sobrevive a resets (perde o tempo do boot), mas some sem energia
+ * @param minute_of_day 0..1439
+ */
+void rule_engine_set_clock(uint16_t minute_of_day, uint32_t now_ms);
+
+/**
+ * Atualiza a hora, avalia as regras pendentes (até RULE_TICK_OPS
+ * instruções) e executa as ações disparadas
+ * @return Ações disparadas
+ */
+uint8_t rule_engine_poll(uint32_t now_ms);
+
+void rule_engine_get_stats(rule_engine_stats_t *stats);
+void rule_engine_print(void);
+
+#endif // RULE_ENGINE_H
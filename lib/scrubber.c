@@ -0,0 +1,306 @@
+/**
+ * Verificação de integridade da flash em segundo plano
+ * CRC32 incremental via sniffer do DMA, comparado com o kv_store
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "crc32.h"
+#include "custom_ir.h"
+#include "kv_store.h"
+#include "scrubber.h"
+#include "build_id.h"       // gerado no build (tools/build_id.py)
+
+// Limites da imagem do firmware (definidos pelo linker script do SDK)
+extern char __flash_binary_start;
+extern char __flash_binary_end;
+
+// Modo CRC32 do sniffer (DMA_SNIFF_CTRL_CALC_VALUE_CRC32)
+#define SNIFF_MODE_CRC32 0x0
+
+typedef enum {
+    SCRUB_REGION_IR,
+    SCRUB_REGION_FIRMWARE,
+    SCRUB_REGION_CONFIG,
+} scrub_kind_t;
+
+typedef struct {
+    const char *name;
+    scrub_kind_t kind;
+    const uint8_t *start;
+    uint32_t size;
+    uint16_t ref_key;       // chave da referência no kv_store
+    uint8_t ir_id;
+    scrub_status_t status;
+    bool ref_pending;       // referência nova esperando scrubber_commit
+    uint32_t ref_crc;
+} scrub_region_t;
+
+#define SCRUB_MAX_REGIONS (IR_CMD_COUNT + 2)
+
+static scrub_region_t regions[SCRUB_MAX_REGIONS];
+static uint8_t region_count = 0;
+
+static int dma_chan = -1;
+static volatile uint32_t dma_sink;     // destino fixo das transferências
+
+// Estado da varredura
+static bool pass_running = false;
+static bool rebaseline = false;        // firmware novo: referências refeitas
+static uint8_t cur_region = 0;
+static uint32_t cur_offset = 0;
+static uint32_t sw_crc = CRC32_INIT;
+static uint16_t kv_slot = 1;
+static uint16_t kv_bad = 0;
+static uint16_t kv_bad_at_boot = 0;
+static bool gc_pending = false;        // config corrompida: regravar no commit
+static absolute_time_t next_pass;
+static absolute_time_t pass_start;
+static scrubber_stats_t stats;
+
+// Identificador do build: hash das fontes e da configuração que geraram
+// a imagem, não da hora da compilação
+static uint32_t firmware_tag(void) {
+    return FIRMWARE_BUILD_ID;
+}
+
+// Lê pela janela XIP sem alocar no cache, para não expulsar o código
+static const volatile void *scrub_read_addr(const uint8_t *p) {
+#ifdef XIP_NOCACHE_NOALLOC_BASE
+    if ((uintptr_t)p >= XIP_BASE && (uintptr_t)p < XIP_BASE + PICO_FLASH_SIZE_BYTES) {
+        return (const volatile void *)((uintptr_t)p - XIP_BASE + XIP_NOCACHE_NOALLOC_BASE);
+    }
+#endif
+    return p;
+}
+
+void scrubber_init(void) {
+    region_count = 0;
+
+    for (uint8_t id = 0; id < IR_CMD_COUNT; id++) {
+        const uint16_t *timings;
+        size_t length;
+        const char *name;
+        custom_ir_get_command((ir_command_id_t)id, &timings, &length, &name);
+        regions[region_count++] = (scrub_region_t){
+            .name = name,
+            .kind = SCRUB_REGION_IR,
+            .start = (const uint8_t *)timings,
+            .size = length * sizeof(uint16_t),
+            .ref_key = KV_KEY_SCRUB_IR_CRC_BASE + id,
+            .ir_id = id,
+        };
+    }
+
+    regions[region_count++] = (scrub_region_t){
+        .name = "FIRMWARE",
+        .kind = SCRUB_REGION_FIRMWARE,
+        .start = (const uint8_t *)&__flash_binary_start,
+        .size = (uint32_t)(&__flash_binary_end - &__flash_binary_start),
+        .ref_key = KV_KEY_SCRUB_FW_CRC,
+    };
+
+    regions[region_count++] = (scrub_region_t){
+        .name = "CONFIG",
+        .kind = SCRUB_REGION_CONFIG,
+    };
+
+    // Registros ruins já conhecidos no boot (gravações interrompidas)
+    kv_store_stats_t kv;
+    kv_store_get_stats(&kv);
+    kv_bad_at_boot = kv.bad_records;
+
+    // Build diferente do que gravou as referências: refaz todas
+    uint32_t tag = firmware_tag();
+    if (kv_get_or(KV_KEY_SCRUB_FW_TAG, 0) != tag) {
+        rebaseline = true;
+        kv_set(KV_KEY_SCRUB_FW_TAG, tag);
+    }
+
+    dma_chan = dma_claim_unused_channel(false);
+    if (dma_chan >= 0) {
+        dma_channel_config c = dma_channel_get_default_config(dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_sniff_enable(&c, true);
+        dma_channel_configure(dma_chan, &c, &dma_sink, NULL, 0, false);
+        dma_sniffer_enable(dma_chan, SNIFF_MODE_CRC32, true);
+    }
+    stats.hw_crc = dma_chan >= 0;
+
+    // Primeira varredura logo após o boot
+    next_pass = get_absolute_time();
+}
+
+static void begin_region(void) {
+    cur_offset = 0;
+    sw_crc = CRC32_INIT;
+    kv_slot = 1;
+    kv_bad = 0;
+    if (dma_chan >= 0) {
+        dma_sniffer_set_data_accumulator(CRC32_INIT);
+    }
+}
+
+static void finish_region(scrub_region_t *r, uint32_t crc) {
+    if (r->kind == SCRUB_REGION_CONFIG) {
+        if (kv_bad > kv_bad_at_boot) {
+            printf("SCRUB: %u registros de config corrompidos, regravando\n",
+                   kv_bad - kv_bad_at_boot);
+            r->status = SCRUB_CORRUPT;
+            stats.errors++;
+            // O índice em RAM tem os valores bons: a coleta reescreve tudo
+            gc_pending = true;
+        } else {
+            r->status = SCRUB_OK;
+        }
+        return;
+    }
+
+    uint32_t ref;
+    if (rebaseline || !kv_get(r->ref_key, &ref)) {
+        r->ref_crc = crc;
+        r->ref_pending = true;
+        r->status = SCRUB_BASELINE;
+        return;
+    }
+
+    if (ref != crc) {
+        if (r->status != SCRUB_CORRUPT) {
+            printf("SCRUB: %s corrompido (CRC %08lX, esperado %08lX)\n",
+                   r->name, (unsigned long)crc, (unsigned long)ref);
+        }
+        r->status = SCRUB_CORRUPT;
+        stats.errors++;
+        if (r->kind == SCRUB_REGION_IR) {
+            custom_ir_set_command_enabled((ir_command_id_t)r->ir_id, false);
+        }
+        return;
+    }
+
+    // Erro transitório de leitura: volta a habilitar quando confere
+    if (r->kind == SCRUB_REGION_IR && r->status == SCRUB_CORRUPT) {
+        custom_ir_set_command_enabled((ir_command_id_t)r->ir_id, true);
+    }
+    r->status = SCRUB_OK;
+}
+
+static void next_region(void) {
+    cur_region++;
+    if (cur_region < region_count) {
+        begin_region();
+        return;
+    }
+
+    pass_running = false;
+    rebaseline = false;
+    stats.passes++;
+    stats.last_pass_ms = (uint32_t)(absolute_time_diff_us(pass_start, get_absolute_time()) / 1000);
+    next_pass = make_timeout_time_ms(SCRUB_PASS_INTERVAL_MS);
+}
+
+// Um passo sobre uma região em flash; retorna true quando terminou
+static bool step_flash_region(scrub_region_t *r, uint32_t *crc) {
+    if (dma_chan >= 0) {
+        if (dma_channel_is_busy(dma_chan)) {
+            return false;   // pedaço anterior ainda em andamento
+        }
+        if (cur_offset >= r->size) {
+            *crc = dma_sniffer_get_data_accumulator();
+            return true;
+        }
+        uint32_t chunk = r->size - cur_offset;
+        if (chunk > SCRUB_CHUNK_BYTES) chunk = SCRUB_CHUNK_BYTES;
+        dma_channel_set_read_addr(dma_chan, scrub_read_addr(r->start + cur_offset), false);
+        dma_channel_set_trans_count(dma_chan, chunk, true);
+        cur_offset += chunk;
+        return false;
+    }
+
+    if (cur_offset >= r->size) {
+        *crc = sw_crc;
+        return true;
+    }
+    uint32_t chunk = r->size - cur_offset;
+    if (chunk > SCRUB_SW_CHUNK_BYTES) chunk = SCRUB_SW_CHUNK_BYTES;
+    sw_crc = crc32_update(sw_crc, r->start + cur_offset, chunk);
+    cur_offset += chunk;
+    return false;
+}
+
+// Um passo sobre os registros do kv_store; retorna true no fim do log
+static bool step_config_region(void) {
+    for (uint8_t i = 0; i < SCRUB_KV_SLOTS_PER_STEP; i++) {
+        kv_slot_status_t st = kv_store_check_slot(kv_slot++);
+        if (st == KV_SLOT_END) return true;
+        if (st == KV_SLOT_BAD) kv_bad++;
+    }
+    return false;
+}
+
+void scrubber_poll(void) {
+    uint32_t t0 = time_us_32();
+
+    if (!pass_running) {
+        if (region_count == 0 || !time_reached(next_pass)) {
+            return;
+        }
+        pass_running = true;
+        pass_start = get_absolute_time();
+        cur_region = 0;
+        begin_region();
+    }
+
+    scrub_region_t *r = &regions[cur_region];
+    uint32_t crc = 0;
+    bool done = (r->kind == SCRUB_REGION_CONFIG) ? step_config_region()
+                                                 : step_flash_region(r, &crc);
+    if (done) {
+        finish_region(r, crc);
+        next_region();
+    }
+
+    uint32_t dt = time_us_32() - t0;
+    if (dt > stats.max_step_us) stats.max_step_us = dt;
+}
+
+void scrubber_commit(void) {
+    for (uint8_t i = 0; i < region_count; i++) {
+        if (regions[i].ref_pending) {
+            regions[i].ref_pending = false;
+            kv_set(regions[i].ref_key, regions[i].ref_crc);
+        }
+    }
+    if (gc_pending) {
+        gc_pending = false;
+        if (kv_store_gc()) {
+            kv_bad_at_boot = 0;
+        }
+    }
+}
+
+void scrubber_stop(void) {
+    if (dma_chan >= 0) {
+        dma_channel_abort(dma_chan);
+    }
+    pass_running = false;
+}
+
+void scrubber_get_stats(scrubber_stats_t *out) {
+    *out = stats;
+}
+
+void scrubber_print_status(void) {
+    static const char *status_name[] = { "?", "OK", "BASE", "CORROMPIDO" };
+
+    printf("\n=== INTEGRIDADE DA FLASH ===\n");
+    for (uint8_t i = 0; i < region_count; i++) {
+        printf("%-9s %6lu bytes  %s\n", regions[i].name,
+               (unsigned long)regions[i].size, status_name[regions[i].status]);
+    }
+    printf("Varreduras: %lu, erros: %lu, ultima: %lums, passo max: %luus (%s)\n",
+           (unsigned long)stats.passes, (unsigned long)stats.errors,
+           (unsigned long)stats.last_pass_ms, (unsigned long)stats.max_step_us,
+           stats.hw_crc ? "DMA sniffer" : "software");
+}
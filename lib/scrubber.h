@@ -0,0 +1,76 @@
+/**
+ * scrubber.h
+ * Verificação de integridade da flash em segundo plano
+ *
+ * Calcula o CRC32 da biblioteca de comandos IR, da imagem do firmware e
+ * dos registros de configuração em pedaços pequenos, um por iteração do
+ * loop principal. O CRC é feito pelo sniffer do DMA (a CPU só dispara a
+ * transferência e volta depois para buscar o resultado) e comparado com
+ * a referência gravada no kv_store. Comandos IR corrompidos são
+ * desabilitados; registros de configuração corrompidos são regravados a
+ * partir do índice em RAM.
+ */
+
+#ifndef SCRUBBER_H
+#define SCRUBBER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bytes por transferência de DMA (um pedaço por chamada de scrubber_poll)
+#define SCRUB_CHUNK_BYTES       1024
+// Bytes por chamada quando não há canal de DMA (CRC por software)
+#define SCRUB_SW_CHUNK_BYTES    32
+// Registros de configuração verificados por chamada
+#define SCRUB_KV_SLOTS_PER_STEP 4
+// Intervalo entre varreduras completas
+#define SCRUB_PASS_INTERVAL_MS  60000
+
+typedef enum {
+    SCRUB_UNKNOWN,      // ainda não verificada
+    SCRUB_OK,
+    SCRUB_BASELINE,     // referência gravada nesta varredura
+    SCRUB_CORRUPT,
+} scrub_status_t;
+
+typedef struct {
+    uint32_t passes;          // varreduras completas
+    uint32_t errors;          // regiões com CRC divergente (acumulado)
+    uint32_t last_pass_ms;    // duração da última varredura
+    uint32_t max_step_us;     // maior custo de uma chamada de scrubber_poll
+    bool hw_crc;              // usando o sniffer do DMA
+} scrubber_stats_t;
+
+/**
+ * Monta a lista de regiões e reserva o canal de DMA
+ * (chamar depois de kv_store_init)
+ */
+void scrubber_init(void);
+
+/**
+ * Avança a verificação um passo (chamar no loop principal).
+ * Não grava a flash: referências novas e a regravação da config ficam
+ * pendentes até scrubber_commit
+ */
+void scrubber_poll(void);
+
+/**
+ * Grava na flash o que a verificação deixou pendente. Chamar num ponto
+ * ocioso do loop: a gravação desliga as interrupções e a XIP
+ */
+void scrubber_commit(void);
+
+void scrubber_get_stats(scrubber_stats_t *stats);
+
+/**
+ * Cancela o pedaço em andamento (antes de gravar a flash em emergência);
+ * a varredura recomeça do início na próxima janela
+ */
+void scrubber_stop(void);
+
+/**
+ * Imprime o estado de cada região no console
+ */
+void scrubber_print_status(void);
+
+#endif // SCRUBBER_H
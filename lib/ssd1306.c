@@ -1,3 +1,4 @@
+#include <string.h>
 #include "ssd1306.h"
 #include "font.h"
 
@@ -69,7 +70,7 @@ void ssd1306_send_data(ssd1306_t *ssd) {
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
+  uint16_t index = (y >> 3) + x * SSD1306_PAGES + 1;
   uint8_t pixel = (y & 0b111);
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
@@ -85,16 +86,17 @@ void ssd1306_fill(ssd1306_t *ssd, bool value) {
 }*/
 
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+    // Todas as posições do display = o buffer inteiro, sem o byte de controle
+    memset(&ssd->ram_buffer[1], value ? 0xFF : 0x00, WIDTH * SSD1306_PAGES);
 }
 
 
 
+// Carrega uma tela inteira (formato do ram_buffer, sem o byte de controle)
+void ssd1306_load(ssd1306_t *ssd, const uint8_t *bitmap) {
+  memcpy(&ssd->ram_buffer[1], bitmap, ssd->bufsize - 1);
+}
+
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
   for (uint8_t x = left; x < left + width; ++x) {
     ssd1306_pixel(ssd, x, top, value);
@@ -169,6 +171,15 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
+  // Alinhado à página: cada coluna da fonte é um byte do buffer
+  if ((y & 7) == 0 && y < HEIGHT && x + 8 <= WIDTH)
+  {
+    uint8_t *col = &ssd->ram_buffer[x * SSD1306_PAGES + (y >> 3) + 1];
+    for (uint8_t i = 0; i < 8; ++i)
+      col[i * SSD1306_PAGES] = font[index + i];
+    return;
+  }
+
   // Desenha o caractere na tela
   for (uint8_t i = 0; i < 8; ++i)
   {
@@ -1,9 +1,18 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
 #define WIDTH 128
 #define HEIGHT 64
+#define SSD1306_PAGES (HEIGHT / 8)
+
+// Buffer em endereçamento vertical: byte (x * SSD1306_PAGES + y / 8 + 1).
+// A geometria é fixa na compilação e as contas viram constantes
+_Static_assert(HEIGHT % 8 == 0 && HEIGHT <= 64, "altura do SSD1306 em paginas de 8 linhas, ate 64");
+_Static_assert(WIDTH <= 128, "SSD1306 tem 128 colunas");
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -41,9 +50,12 @@ void ssd1306_send_data(ssd1306_t *ssd);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
+void ssd1306_load(ssd1306_t *ssd, const uint8_t *bitmap);
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill);
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+
+#endif // SSD1306_H
@@ -0,0 +1,28 @@
+/**
+ * tusb_config.h
+ * Configuração do TinyUSB para o dispositivo composto (só com USB_MSC)
+ *
+ * Sem a opção o stdio USB do SDK usa a própria configuração (só CDC).
+ * CFG_TUSB_MCU e CFG_TUSB_OS vêm do SDK.
+ */
+
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+#define CFG_TUD_ENABLED         1
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+// Console (stdio do SDK) + disco somente leitura
+#define CFG_TUD_CDC             1
+#define CFG_TUD_MSC             1
+#define CFG_TUD_HID             0
+#define CFG_TUD_MIDI            0
+#define CFG_TUD_VENDOR          0
+
+#define CFG_TUD_CDC_RX_BUFSIZE  256
+#define CFG_TUD_CDC_TX_BUFSIZE  256
+
+// Um setor por transferência (usb_msc.c serve setores de 512 bytes)
+#define CFG_TUD_MSC_EP_BUFSIZE  512
+
+#endif // TUSB_CONFIG_H
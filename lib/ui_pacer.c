@@ -0,0 +1,87 @@
+/**
+ * Cadência de renderização do display
+ * Tela suja + intervalo mínimo entre quadros (time_us_64)
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ui_pacer.h"
+
+static uint32_t frame_interval_us;
+static uint64_t next_frame_us;      // início do próximo intervalo
+static uint64_t frame_start_us;
+static bool dirty = false;
+static ui_frame_t pending;          // o que está sujo (válido com dirty)
+static ui_pacer_stats_t stats;
+
+void ui_pacer_init(uint8_t fps) {
+    if (fps == 0 || fps > UI_PACER_MAX_FPS) {
+        fps = UI_PACER_DEFAULT_FPS;
+    }
+    memset(&stats, 0, sizeof(stats));
+    stats.fps = fps;
+    frame_interval_us = 1000000u / fps;
+    next_frame_us = 0;
+    dirty = true;                   // primeiro quadro sai já
+    pending.full = true;
+}
+
+void ui_pacer_mark_dirty(void) {
+    if (dirty) {
+        stats.coalesced++;
+    }
+    dirty = true;
+    pending.full = true;
+}
+
+void ui_pacer_mark_rect(uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    if (dirty) {
+        stats.coalesced++;
+        if (!pending.full) {
+            // União dos retângulos pendentes
+            if (x0 < pending.x0) pending.x0 = x0;
+            if (x1 > pending.x1) pending.x1 = x1;
+            if (p0 < pending.p0) pending.p0 = p0;
+            if (p1 > pending.p1) pending.p1 = p1;
+        }
+        return;
+    }
+    dirty = true;
+    pending = (ui_frame_t){ .full = false, .x0 = x0, .x1 = x1, .p0 = p0, .p1 = p1 };
+}
+
+bool ui_pacer_begin_frame(ui_frame_t *frame) {
+    uint64_t now = time_us_64();
+
+    if (now < next_frame_us) {
+        return false;
+    }
+    if (!dirty) {
+        // Intervalo passou sem mudança: conta uma vez e espera o próximo
+        stats.skipped++;
+        next_frame_us = now + frame_interval_us;
+        return false;
+    }
+
+    dirty = false;
+    *frame = pending;
+    if (!pending.full) {
+        stats.partial++;
+    }
+    frame_start_us = now;
+    next_frame_us = now + frame_interval_us;
+    return true;
+}
+
+void ui_pacer_end_frame(void) {
+    uint32_t dt = (uint32_t)(time_us_64() - frame_start_us);
+
+    stats.frames++;
+    stats.frame_last_us = dt;
+    stats.frame_sum_us += dt;
+    if (dt > stats.frame_max_us) stats.frame_max_us = dt;
+}
+
+void ui_pacer_get_stats(ui_pacer_stats_t *out) {
+    *out = stats;
+}
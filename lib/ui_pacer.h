@@ -0,0 +1,72 @@
+/**
+ * ui_pacer.h
+ * Cadência de renderização do display, desacoplada das mudanças de estado
+ *
+ * Quem altera algo visível só marca a tela como suja; o laço principal
+ * pergunta a cada volta se deve desenhar. Um quadro sai no máximo a cada
+ * 1/fps segundos: mudanças dentro do intervalo são agrupadas e só o estado
+ * mais recente é desenhado. Sem mudança, nada é desenhado nem enviado.
+ *
+ * Widgets que atualizam o ram_buffer por conta própria (oled_graph) marcam
+ * só o retângulo alterado; retângulos pendentes se juntam num só, e uma
+ * marcação de tela inteira prevalece sobre eles.
+ */
+
+#ifndef UI_PACER_H
+#define UI_PACER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UI_PACER_DEFAULT_FPS 10
+#define UI_PACER_MAX_FPS     40     // flush completo em 400kHz leva ~23ms
+
+// Quadro a desenhar: tela inteira ou só o retângulo já atualizado no buffer
+typedef struct {
+    bool full;
+    uint8_t x0, x1;         // colunas
+    uint8_t p0, p1;         // páginas
+} ui_frame_t;
+
+typedef struct {
+    uint8_t fps;
+    uint32_t frames;            // quadros desenhados
+    uint32_t partial;           // quadros só de um retângulo
+    uint32_t coalesced;         // marcações agrupadas num quadro já pendente
+    uint32_t skipped;           // intervalos sem mudança (nada desenhado)
+    uint32_t frame_last_us;     // desenho + flush do último quadro
+    uint32_t frame_max_us;
+    uint64_t frame_sum_us;
+} ui_pacer_stats_t;
+
+/**
+ * @param fps Quadros por segundo máximos (1..UI_PACER_MAX_FPS)
+ */
+void ui_pacer_init(uint8_t fps);
+
+/**
+ * Marca a tela como suja (estado visível mudou)
+ */
+void ui_pacer_mark_dirty(void);
+
+/**
+ * Marca só um retângulo (colunas [x0, x1], páginas [p0, p1]) já
+ * atualizado no ram_buffer
+ */
+void ui_pacer_mark_rect(uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1);
+
+/**
+ * @param frame recebe o que desenhar/enviar
+ * @return true se há mudança pendente e o intervalo do quadro venceu;
+ *         nesse caso desenhar e chamar ui_pacer_end_frame()
+ */
+bool ui_pacer_begin_frame(ui_frame_t *frame);
+
+/**
+ * Fecha o quadro aberto por ui_pacer_begin_frame() e mede a duração
+ */
+void ui_pacer_end_frame(void);
+
+void ui_pacer_get_stats(ui_pacer_stats_t *stats);
+
+#endif // UI_PACER_H
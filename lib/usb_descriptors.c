@@ -0,0 +1,116 @@
+/**
+ * Descritores USB do dispositivo composto CDC + MSC (só com USB_MSC)
+ * O CDC fica na interface 0, onde o stdio USB do SDK o procura
+ */
+
+#include <string.h>
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+// VID/PID de desenvolvimento do TinyUSB: trocar por um par próprio em produção
+#define USB_VID         0xCAFE
+#define USB_PID         0x4011
+#define USB_BCD         0x0200
+
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_MSC,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_NOTIF 0x81
+#define EPNUM_CDC_OUT   0x02
+#define EPNUM_CDC_IN    0x82
+#define EPNUM_MSC_OUT   0x03
+#define EPNUM_MSC_IN    0x83
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN)
+
+enum {
+    STR_LANGID = 0,
+    STR_MANUFACTURER,
+    STR_PRODUCT,
+    STR_SERIAL,
+    STR_CDC,
+    STR_MSC,
+};
+
+// ===== DISPOSITIVO E CONFIGURAÇÃO =====
+
+// IAD: o host agrupa as duas interfaces do CDC
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = USB_BCD,
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STR_MANUFACTURER,
+    .iProduct = STR_PRODUCT,
+    .iSerialNumber = STR_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 250),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, STR_CDC, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, STR_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return desc_configuration;
+}
+
+// ===== STRINGS =====
+
+static const char *const strings[] = {
+    [STR_MANUFACTURER] = "BitDogLab",
+    [STR_PRODUCT] = "IR Watchdog",
+    [STR_SERIAL] = NULL,            // ID único da flash
+    [STR_CDC] = "IR Watchdog Console",
+    [STR_MSC] = "IR Watchdog Logs",
+};
+
+// UTF-16 com cabeçalho (tamanho, tipo)
+static uint16_t desc_str[1 + 32];
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    const char *str;
+    size_t len;
+
+    if (index == STR_LANGID) {
+        desc_str[1] = 0x0409;       // inglês (EUA)
+        len = 1;
+    } else {
+        if (index >= sizeof(strings) / sizeof(strings[0])) {
+            return NULL;
+        }
+        if (index == STR_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        } else {
+            str = strings[index];
+        }
+        len = strlen(str);
+        if (len > 32) {
+            len = 32;
+        }
+        for (size_t i = 0; i < len; i++) {
+            desc_str[1 + i] = (uint8_t)str[i];
+        }
+    }
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return desc_str;
+}
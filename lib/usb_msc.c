@@ -0,0 +1,244 @@
+/**
+ * Disco USB somente leitura (TinyUSB MSC)
+ * Volume FAT12 virtual: cada setor é gerado na leitura ou lido da flash
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "flash_layout.h"
+#include "usb_msc.h"
+
+// Layout: boot | FAT | raiz | dados (cluster = setor, cluster 2 = MSC_DATA_LBA)
+#define MSC_SECTOR          512
+#define MSC_SECTORS         128             // 64 KiB
+#define MSC_FAT_LBA         1
+#define MSC_ROOT_LBA        2
+#define MSC_DATA_LBA        3
+#define MSC_ROOT_ENTRIES    (MSC_SECTOR / 32)
+#define MSC_ATTR_READ_ONLY  0x01
+#define MSC_ATTR_VOLUME     0x08
+
+typedef struct {
+    char name[11];                  // 8.3 sem o ponto, completado com espaços
+    uint32_t flash_offset;          // 0 = gerado (STATUS.TXT)
+    uint32_t size;                  // múltiplo de MSC_SECTOR
+} msc_file_t;
+
+static const msc_file_t files[] = {
+    { "STATUS  TXT", 0,                    USB_MSC_STATUS_BYTES },
+    { "PWRFAIL BIN", FLASH_PF_OFFSET,      FLASH_SECTOR_SIZE },
+    { "TRACE   BIN", FLASH_TRACE_OFFSET,   FLASH_SECTOR_SIZE },
+    { "PROFILESBIN", FLASH_PROFILE_OFFSET, FLASH_SECTOR_SIZE },
+    { "RULES   BIN", FLASH_RULES_OFFSET,   FLASH_SECTOR_SIZE },
+    { "CONFIG  BIN", FLASH_KV_OFFSET,      FLASH_KV_SECTORS * FLASH_SECTOR_SIZE },
+};
+#define MSC_FILE_COUNT (sizeof(files) / sizeof(files[0]))
+
+_Static_assert(USB_MSC_STATUS_BYTES % MSC_SECTOR == 0, "STATUS.TXT em setores inteiros");
+_Static_assert(MSC_DATA_LBA + (USB_MSC_STATUS_BYTES + 4 * FLASH_SECTOR_SIZE +
+               FLASH_KV_SECTORS * FLASH_SECTOR_SIZE) / MSC_SECTOR <= MSC_SECTORS,
+               "arquivos nao cabem no volume");
+_Static_assert(MSC_SECTORS * 3 / 2 <= MSC_SECTOR, "FAT12 precisa caber em um setor");
+
+static usb_msc_status_t status_fn = NULL;
+static char status_buf[USB_MSC_STATUS_BYTES];
+static uint8_t sector_buf[MSC_SECTOR];
+
+void usb_msc_init(usb_msc_status_t status) {
+    status_fn = status;
+}
+
+// ===== VOLUME VIRTUAL =====
+
+// Primeiro cluster de cada arquivo: os arquivos ficam em sequência
+static uint16_t first_cluster(size_t index) {
+    uint16_t cluster = 2;
+    for (size_t i = 0; i < index; i++) {
+        cluster += (uint16_t)(files[i].size / MSC_SECTOR);
+    }
+    return cluster;
+}
+
+static void boot_sector(uint8_t *s) {
+    static const uint8_t bpb[] = {
+        0xEB, 0x3C, 0x90,                       // salto (sem código de boot)
+        'M', 'S', 'D', 'O', 'S', '5', '.', '0',
+        MSC_SECTOR & 0xFF, MSC_SECTOR >> 8,     // bytes por setor
+        1,                                      // setores por cluster
+        1, 0,                                   // setores reservados (este)
+        1,                                      // uma FAT
+        MSC_ROOT_ENTRIES, 0,
+        MSC_SECTORS & 0xFF, MSC_SECTORS >> 8,
+        0xF8,                                   // disco fixo
+        1, 0,                                   // setores por FAT
+        1, 0, 1, 0,                             // geometria (ignorada)
+        0, 0, 0, 0,                             // setores ocultos
+        0, 0, 0, 0,                             // total em 32 bits (não usado)
+        0x80, 0, 0x29,                          // drive, reservado, assinatura
+        0x31, 0x52, 0x49, 0x57,                 // número de série
+        'I', 'R', ' ', 'W', 'A', 'T', 'C', 'H', 'D', 'O', 'G',
+        'F', 'A', 'T', '1', '2', ' ', ' ', ' ',
+    };
+    memcpy(s, bpb, sizeof(bpb));
+    s[510] = 0x55;
+    s[511] = 0xAA;
+}
+
+static void fat_set(uint8_t *fat, uint16_t cluster, uint16_t value) {
+    uint32_t at = cluster + cluster / 2u;
+    if (cluster & 1) {
+        fat[at] = (uint8_t)((fat[at] & 0x0F) | (value << 4));
+        fat[at + 1] = (uint8_t)(value >> 4);
+    } else {
+        fat[at] = (uint8_t)value;
+        fat[at + 1] = (uint8_t)((fat[at + 1] & 0xF0) | ((value >> 8) & 0x0F));
+    }
+}
+
+// Cada arquivo é uma cadeia contínua terminada em 0xFFF
+static void fat_sector(uint8_t *s) {
+    fat_set(s, 0, 0xFF8);
+    fat_set(s, 1, 0xFFF);
+    for (size_t i = 0; i < MSC_FILE_COUNT; i++) {
+        uint16_t first = first_cluster(i);
+        uint16_t count = (uint16_t)(files[i].size / MSC_SECTOR);
+        for (uint16_t c = 0; c < count; c++) {
+            fat_set(s, first + c, c + 1 == count ? 0xFFF : first + c + 1);
+        }
+    }
+}
+
+// Sem RTC: datas zeradas (o sistema operacional mostra 1980)
+static void root_sector(uint8_t *s) {
+    memcpy(s, "IR WATCHDOG", 11);
+    s[11] = MSC_ATTR_VOLUME;
+    for (size_t i = 0; i < MSC_FILE_COUNT; i++) {
+        uint8_t *e = s + 32 * (i + 1);
+        uint16_t first = first_cluster(i);
+        memcpy(e, files[i].name, 11);
+        e[11] = MSC_ATTR_READ_ONLY;
+        e[26] = (uint8_t)first;
+        e[27] = (uint8_t)(first >> 8);
+        e[28] = (uint8_t)files[i].size;
+        e[29] = (uint8_t)(files[i].size >> 8);
+        e[30] = (uint8_t)(files[i].size >> 16);
+        e[31] = (uint8_t)(files[i].size >> 24);
+    }
+}
+
+// Texto da aplicação completado com espaços até o tamanho do diretório
+static void refresh_status(void) {
+    size_t n = status_fn ? status_fn(status_buf, sizeof(status_buf)) : 0;
+    if (n > sizeof(status_buf)) {
+        n = sizeof(status_buf);
+    }
+    memset(status_buf + n, ' ', sizeof(status_buf) - n);
+    status_buf[sizeof(status_buf) - 1] = '\n';
+}
+
+// Conteúdo de um setor: ponteiro XIP para os arquivos em flash, ou o
+// setor gerado em sector_buf
+static const uint8_t *sector_data(uint32_t lba) {
+    if (lba >= MSC_DATA_LBA) {
+        uint16_t cluster = (uint16_t)(lba - MSC_DATA_LBA + 2);
+        for (size_t i = 0; i < MSC_FILE_COUNT; i++) {
+            uint16_t first = first_cluster(i);
+            if (cluster < first || cluster >= first + files[i].size / MSC_SECTOR) {
+                continue;
+            }
+            uint32_t offset = (uint32_t)(cluster - first) * MSC_SECTOR;
+            if (files[i].flash_offset) {
+                return FLASH_XIP_PTR(files[i].flash_offset + offset);
+            }
+            if (offset == 0) {
+                refresh_status();       // um retrato por leitura do arquivo
+            }
+            return (const uint8_t *)status_buf + offset;
+        }
+    }
+
+    memset(sector_buf, 0, sizeof(sector_buf));
+    if (lba == 0) {
+        boot_sector(sector_buf);
+    } else if (lba == MSC_FAT_LBA) {
+        fat_sector(sector_buf);
+    } else if (lba == MSC_ROOT_LBA) {
+        root_sector(sector_buf);
+    }
+    return sector_buf;
+}
+
+// ===== CALLBACKS DO TINYUSB =====
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+    (void)lun;
+    memcpy(vendor_id, "BITDOG  ", 8);
+    memcpy(product_id, "IR WATCHDOG LOGS", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    (void)lun;
+    return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size) {
+    (void)lun;
+    *block_count = MSC_SECTORS;
+    *block_size = MSC_SECTOR;
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject) {
+    (void)lun;
+    (void)power_condition;
+    (void)start;
+    (void)load_eject;
+    return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+    (void)lun;
+    return false;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    (void)lun;
+    uint8_t *out = buffer;
+    uint32_t done = 0;
+
+    while (done < bufsize) {
+        if (lba >= MSC_SECTORS) {
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x21, 0x00);
+            return -1;
+        }
+        uint32_t n = MSC_SECTOR - offset;
+        if (n > bufsize - done) {
+            n = bufsize - done;
+        }
+        memcpy(out + done, sector_data(lba) + offset, n);
+        done += n;
+        offset = 0;
+        lba++;
+    }
+    return (int32_t)done;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    (void)lba;
+    (void)offset;
+    (void)buffer;
+    (void)bufsize;
+    tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00);    // protegido contra escrita
+    return -1;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer, uint16_t bufsize) {
+    (void)buffer;
+    (void)bufsize;
+    if (scsi_cmd[0] == SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL) {
+        return 0;
+    }
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);   // comando inválido
+    return -1;
+}
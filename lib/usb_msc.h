@@ -0,0 +1,50 @@
+/**
+ * usb_msc.h
+ * Disco USB somente leitura com logs, trace e perfis da flash (opcional)
+ *
+ * Com a opção USB_MSC do CMake a placa vira um dispositivo composto: o
+ * console de sempre (CDC, stdio do SDK) e um volume FAT12 de 64 KiB que
+ * qualquer gerenciador de arquivos copia na velocidade do USB, sem
+ * script. O volume não existe em RAM nem na flash: setor de boot, FAT e
+ * diretório são gerados a cada leitura a partir da tabela de arquivos, e
+ * os arquivos .BIN são os setores de dados servidos direto da flash
+ * (XIP), sem cópia intermediária:
+ *
+ *   STATUS.TXT    telemetria gerada na leitura (callback da aplicação)
+ *   PWRFAIL.BIN   registros de queda de energia (powerfail_log)
+ *   TRACE.BIN     trace de entradas (input_trace; mesmo conteúdo da @TR)
+ *   PROFILES.BIN  perfis de modelo de AC (ac_profile)
+ *   RULES.BIN     regras de automação (rule_engine)
+ *   CONFIG.BIN    os dois setores do kv_store
+ *
+ * O TinyUSB roda na tarefa de fundo do stdio USB (IRQ de baixa
+ * prioridade). As gravações de flash do laço principal desligam as
+ * interrupções, então um setor nunca é lido pela metade (a gravação na
+ * queda de energia é a exceção: ver powerfail_log.h); um arquivo copiado
+ * durante uma gravação pode misturar versões. O sistema operacional guarda em cache
+ * o que já leu: para um STATUS.TXT novo, ejetar e reconectar.
+ */
+
+#ifndef USB_MSC_H
+#define USB_MSC_H
+
+#include <stddef.h>
+
+#ifndef USB_MSC
+#define USB_MSC 0
+#endif
+
+#define USB_MSC_STATUS_BYTES    1024    // tamanho fixo de STATUS.TXT (completado com espaços)
+
+/**
+ * Gera o texto de STATUS.TXT (roda na IRQ do USB: só leitura de estado)
+ * @return Bytes escritos em buf
+ */
+typedef size_t (*usb_msc_status_t)(char *buf, size_t max);
+
+/**
+ * Registra o gerador de STATUS.TXT; até lá o arquivo sai em branco
+ */
+void usb_msc_init(usb_msc_status_t status);
+
+#endif // USB_MSC_H
@@ -0,0 +1,123 @@
+/**
+ * Supervisão do watchdog com leases
+ * Recarrega o contador do WDT com o prazo declarado pela operação
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/watchdog.h"
+#include "wdt_lease.h"
+
+// Scratch register com a tag do lease ativo (0 e 1 são do diagnóstico
+// de reset; 4..7 são usados pelo SDK em watchdog_reboot)
+#define WDT_LEASE_SCRATCH  2
+
+// Contador do WDT tem 24 bits
+#define WDT_LOAD_MAX       0x00FFFFFFu
+
+static uint8_t lease_depth = 0;
+static absolute_time_t lease_deadline[WDT_LEASE_MAX_DEPTH];
+static wdt_lease_tag_t lease_tag[WDT_LEASE_MAX_DEPTH];
+
+// Tag deixada pelo boot anterior: capturada antes do primeiro lease deste
+// boot (operações de flash no boot abrem leases antes do diagnóstico)
+static bool boot_tag_latched = false;
+static wdt_lease_tag_t boot_tag;
+
+// Converte ms em ticks do contador (no RP2040 o contador decrementa
+// duas vezes por tick - errata RP2040-E1 - igual ao watchdog_enable)
+static uint32_t wdt_ticks_from_us(uint64_t us) {
+#if PICO_RP2040
+    us *= 2;
+#endif
+    return us > WDT_LOAD_MAX ? WDT_LOAD_MAX : (uint32_t)us;
+}
+
+// Recarrega o contador para expirar em 'deadline'
+static void wdt_reload_until(absolute_time_t deadline) {
+    int64_t remaining_us = absolute_time_diff_us(get_absolute_time(), deadline);
+    if (remaining_us < 1) remaining_us = 1;
+    watchdog_hw->load = wdt_ticks_from_us((uint64_t)remaining_us);
+}
+
+static void latch_boot_tag(void) {
+    if (!boot_tag_latched) {
+        boot_tag = (wdt_lease_tag_t)watchdog_hw->scratch[WDT_LEASE_SCRATCH];
+        boot_tag_latched = true;
+    }
+}
+
+void wdt_lease_init(uint32_t timeout_ms) {
+    latch_boot_tag();
+    lease_depth = 0;
+    watchdog_hw->scratch[WDT_LEASE_SCRATCH] = WDT_LEASE_NONE;
+    watchdog_enable(timeout_ms, true);
+}
+
+void wdt_lease_feed(void) {
+    if (lease_depth > 0) {
+        return;
+    }
+    watchdog_update();
+}
+
+bool wdt_lease_begin(uint32_t max_ms, wdt_lease_tag_t tag) {
+    if (lease_depth >= WDT_LEASE_MAX_DEPTH) {
+        printf("WDT: pilha de leases cheia (tag %s)\n", wdt_lease_tag_name(tag));
+        return false;
+    }
+    latch_boot_tag();
+
+    absolute_time_t deadline = make_timeout_time_ms(max_ms);
+
+    // Lease interno nunca encurta o prazo do lease externo
+    if (lease_depth > 0 &&
+        absolute_time_diff_us(deadline, lease_deadline[lease_depth - 1]) > 0) {
+        deadline = lease_deadline[lease_depth - 1];
+    }
+
+    lease_deadline[lease_depth] = deadline;
+    lease_tag[lease_depth] = tag;
+    lease_depth++;
+
+    watchdog_hw->scratch[WDT_LEASE_SCRATCH] = tag;
+    wdt_reload_until(deadline);
+    return true;
+}
+
+void wdt_lease_end(void) {
+    if (lease_depth == 0) {
+        return;
+    }
+    lease_depth--;
+
+    if (lease_depth > 0) {
+        // Volta ao prazo do lease externo, que continua valendo
+        watchdog_hw->scratch[WDT_LEASE_SCRATCH] = lease_tag[lease_depth - 1];
+        wdt_reload_until(lease_deadline[lease_depth - 1]);
+    } else {
+        // Sem lease: watchdog_update() recarrega o timeout base
+        watchdog_hw->scratch[WDT_LEASE_SCRATCH] = WDT_LEASE_NONE;
+        watchdog_update();
+    }
+}
+
+bool wdt_lease_active(void) {
+    return lease_depth > 0;
+}
+
+wdt_lease_tag_t wdt_lease_last_overrun(void) {
+    latch_boot_tag();
+    return boot_tag;
+}
+
+const char *wdt_lease_tag_name(wdt_lease_tag_t tag) {
+    switch (tag) {
+        case WDT_LEASE_NONE:    return "NENHUM";
+        case WDT_LEASE_IR_TX:   return "IR TX";
+        case WDT_LEASE_DISPLAY: return "DISPLAY";
+        case WDT_LEASE_FLASH:   return "FLASH";
+        case WDT_LEASE_CONSOLE: return "CONSOLE";
+        default:                return "?";
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * wdt_lease.h
+ * Supervisão do watchdog com "leases" para operações longas
+ *
+ * O timeout global do watchdog fica curto (cadência do loop principal).
+ * Uma operação que sabidamente demora mais (envio IR, flush do display,
+ * apagamento de flash) declara antes quanto tempo pode levar; o watchdog
+ * é recarregado só para aquela janela e volta ao timeout normal no fim.
+ * Se a operação estourar o lease, o reset acontece do mesmo jeito.
+ */
+
+#ifndef WDT_LEASE_H
+#define WDT_LEASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Identifica a operação dona do lease (gravado em scratch[2])
+typedef enum {
+    WDT_LEASE_NONE = 0,
+    WDT_LEASE_IR_TX,      // transmissão IR (conversão + DMA)
+    WDT_LEASE_DISPLAY,    // flush/re-init do OLED via I2C
+    WDT_LEASE_FLASH,      // apagamento/gravação de setor de flash
+    WDT_LEASE_CONSOLE,    // leitura de linha pelo console
+} wdt_lease_tag_t;
+
+// Profundidade máxima de leases aninhados
+#define WDT_LEASE_MAX_DEPTH 4
+
+/**
+ * Habilita o watchdog com o timeout base do loop principal
+ * @param timeout_ms Timeout normal (sem lease ativo)
+ */
+void wdt_lease_init(uint32_t timeout_ms);
+
+/**
+ * Alimenta o watchdog no ponto estratégico do loop.
+ * Não faz nada enquanto houver lease ativo: um lease esquecido
+ * aberto acaba estourando e resetando o sistema.
+ */
+void wdt_lease_feed(void);
+
+/**
+ * Abre um lease: a operação seguinte pode levar até max_ms
+ * @param max_ms Tempo máximo da operação
+ * @param tag Operação dona do lease (diagnóstico pós-reset)
+ * @return false se a pilha de leases estiver cheia (nada foi aberto:
+ *         não chamar wdt_lease_end para este lease)
+ */
+bool wdt_lease_begin(uint32_t max_ms, wdt_lease_tag_t tag);
+
+/**
+ * Fecha o lease mais interno e restaura o prazo anterior
+ */
+void wdt_lease_end(void);
+
+/**
+ * @return true se existe algum lease aberto
+ */
+bool wdt_lease_active(void);
+
+/**
+ * Tag do lease que estava ativo quando o watchdog resetou, capturada
+ * antes do primeiro lease deste boot (vale só se o reset foi do watchdog)
+ */
+wdt_lease_tag_t wdt_lease_last_overrun(void);
+
+/**
+ * Nome curto da tag para console/display
+ */
+const char *wdt_lease_tag_name(wdt_lease_tag_t tag);
+
+#endif // WDT_LEASE_H
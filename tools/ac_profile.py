@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Gera a linha "@AP <hex>" de um perfil de modelo de AC (lib/ac_profile.h).
+
+O perfil é descrito em JSON; colar a linha no console da placa (ou
+redirecionar para a porta serial) grava o perfil na flash. Depois, o
+comando 'l' do console escolhe o perfil de cada emissor.
+
+Exemplo (protocolo de distância de pulso, 6 bytes, checksum por soma):
+  {
+    "name": "SALA2",
+    "carrier_hz": 38000,
+    "repeat": 2, "gap_ms": 40,
+    "timing": {"header": [4400, 4400], "bit_mark": 550,
+               "one_space": 1600, "zero_space": 550},
+    "lsb_first": true,
+    "frame": "B24D00000000",
+    "modes": {"auto": 2, "cool": 0, "heat": 3, "fan": 4},
+    "fans": [5, 4, 2, 1],
+    "temp": {"min": 17, "max": 30, "default": 24, "offset": 17},
+    "fields": {"power": [2, 7, 1], "mode": [2, 4, 3],
+               "temp": [3, 0, 4], "fan": [2, 0, 3]},
+    "checksum": {"type": "sum", "byte": 5, "from": 0}
+  }
+
+"modes" mapeia cada modo suportado para o código do campo; "fans" lista os
+códigos dos níveis (automático, 1, 2, 3), e o nível fica suportado se o
+código não for null. Campos são [byte, bit menos significativo, largura];
+um campo ausente não é gravado no quadro.
+
+Uso: ac_profile.py perfil.json [> /dev/ttyACM0]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x31504341
+NAME_LEN = 12
+MAX_FRAME = 16
+MAX_REPEAT = 4
+MAX_GAP_MS = 200
+MODES = ["auto", "cool", "heat", "dry", "fan"]
+FAN_COUNT = 4
+CHECKSUMS = {"none": 0, "sum": 1, "xor": 2, "nibbles": 3}
+PROTO_PULSE_DISTANCE = 1
+
+# Mesmo layout de ac_profile_def_t (little-endian, sem padding), sem o CRC
+DEF_FORMAT = "<I12s4B2b2BI7H4B16s16B5B4BB"
+
+
+def fail(msg):
+    sys.exit(f"ac_profile: {msg}")
+
+
+def crc32_msb(data):
+    """CRC-32 de lib/crc32.c (0x04C11DB7, MSB primeiro, sem XOR final)."""
+    crc = 0xFFFFFFFF
+    for b in data:
+        crc ^= b << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def field(spec, frame_len, name):
+    if spec is None:
+        return [0, 0, 0, 0]
+    byte, shift, width = spec
+    if byte >= frame_len or width < 1 or shift + width > 8:
+        fail(f"campo {name} fora do quadro: {spec}")
+    return [byte, shift, width, 0]
+
+
+def build(p):
+    name = p["name"].encode("ascii")
+    if len(name) > NAME_LEN:
+        fail(f"nome com mais de {NAME_LEN} caracteres")
+
+    frame = bytes.fromhex(p["frame"])
+    if not 1 <= len(frame) <= MAX_FRAME:
+        fail(f"quadro deve ter de 1 a {MAX_FRAME} bytes")
+
+    mode_codes = [0] * len(MODES)
+    mode_mask = 0
+    for mode, code in p["modes"].items():
+        if mode not in MODES:
+            fail(f"modo desconhecido: {mode}")
+        mode_mask |= 1 << MODES.index(mode)
+        mode_codes[MODES.index(mode)] = code
+
+    fans = p.get("fans", [0])
+    if len(fans) > FAN_COUNT:
+        fail(f"no maximo {FAN_COUNT} niveis de ventilacao")
+    fan_codes = [0] * FAN_COUNT
+    fan_mask = 0
+    for i, code in enumerate(fans):
+        if code is not None:
+            fan_mask |= 1 << i
+            fan_codes[i] = code
+
+    if not 0 <= p.get("repeat", 1) <= MAX_REPEAT:
+        fail(f"repeat deve ir de 0 a {MAX_REPEAT}")
+    if not 0 <= p.get("gap_ms", 0) <= MAX_GAP_MS:
+        fail(f"gap_ms deve ir de 0 a {MAX_GAP_MS}")
+
+    timing = p["timing"]
+    header = timing.get("header", [0, 0])
+    temp = p["temp"]
+    checksum = p.get("checksum", {"type": "none"})
+    if checksum["type"] not in CHECKSUMS:
+        fail(f"checksum desconhecido: {checksum['type']}")
+    if checksum["type"] != "none" and checksum["byte"] >= len(frame):
+        fail("byte do checksum fora do quadro")
+
+    fields = p["fields"]
+    packed_fields = []
+    for name_f in ("power", "mode", "temp", "fan"):
+        packed_fields += field(fields.get(name_f), len(frame), name_f)
+
+    body = struct.pack(
+        DEF_FORMAT,
+        MAGIC, name, PROTO_PULSE_DISTANCE, mode_mask, fan_mask, p.get("repeat", 1),
+        temp["min"], temp["max"], temp.get("default", temp["min"]), int(p.get("lsb_first", False)),
+        p.get("carrier_hz", 0), p.get("gap_ms", 0),
+        header[0], header[1], timing["bit_mark"], timing["one_space"], timing["zero_space"],
+        timing.get("trail_mark", 0),
+        len(frame), CHECKSUMS[checksum["type"]], checksum.get("byte", 0), checksum.get("from", 0),
+        frame.ljust(MAX_FRAME, b"\0"),
+        *packed_fields, *mode_codes, *fan_codes, temp.get("offset", 0),
+    )
+    return body + struct.pack("<I", crc32_msb(body))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Perfil de AC em JSON -> linha @AP")
+    ap.add_argument("profile", help="arquivo JSON do perfil")
+    args = ap.parse_args()
+
+    with open(args.profile, encoding="utf-8") as f:
+        try:
+            profile = json.load(f)
+        except json.JSONDecodeError as e:
+            fail(f"{args.profile}: {e}")
+    try:
+        record = build(profile)
+    except KeyError as e:
+        fail(f"{args.profile}: falta a chave {e}")
+    print("@AP " + record.hex().upper())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""
+Gera build_id.h com um identificador que muda junto com a imagem.
+
+O identificador é o CRC32 do conteúdo de todos os arquivos que entram no
+firmware (fontes, cabeçalhos, assets, CMakeLists) mais a configuração do
+build (--config: compilador, tipo de build, opções). O scrubber usa o
+valor para saber que a imagem na flash é nova e refazer as referências.
+
+Roda a cada build; o cabeçalho só é regravado quando o valor muda, para
+não recompilar nada à toa.
+
+Uso: build_id.py --out <diretório> [--config <texto>] arquivo [arquivo ...]
+"""
+
+import argparse
+import os
+import zlib
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("--out", required=True)
+    ap.add_argument("--config", default="")
+    ap.add_argument("files", nargs="+")
+    args = ap.parse_args()
+
+    crc = zlib.crc32(args.config.encode())
+    # Ordem fixa: o mesmo conjunto de arquivos dá o mesmo valor
+    for path in sorted(args.files):
+        crc = zlib.crc32(os.path.basename(path).encode(), crc)
+        with open(path, "rb") as f:
+            crc = zlib.crc32(f.read(), crc)
+
+    text = "\n".join([
+        "// Gerado por tools/build_id.py - não editar",
+        "#ifndef BUILD_ID_H",
+        "#define BUILD_ID_H",
+        "",
+        f"#define FIRMWARE_BUILD_ID 0x{crc:08X}u",
+        "",
+        "#endif",
+        "",
+    ])
+    os.makedirs(args.out, exist_ok=True)
+    out = os.path.join(args.out, "build_id.h")
+    try:
+        with open(out, encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(out, "w", encoding="utf-8") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Visualizador do espelho do OLED (lib/fb_mirror.c) no terminal.
+
+Lê as linhas "@FB <K|D> <seq> <crc> <hex>" da porta serial USB (ou de um
+arquivo/stdin), reconstrói o framebuffer 128x64 aplicando os XOR por
+página e redesenha a tela com meios-blocos Unicode. As demais linhas do
+console são ignoradas (ou repetidas abaixo da tela com --log).
+
+Um CRC diferente do esperado (linha perdida ou truncada) deixa a tela
+marcada como dessincronizada até o próximo quadro-chave. O espelho é
+ligado no firmware pelo comando 'm' do console.
+
+Uso: fb_viewer.py /dev/ttyACM0      (ou "-" para stdin)
+     fb_viewer.py --pbm tela.pbm captura.txt   (grava o último quadro)
+"""
+
+import argparse
+import os
+import sys
+
+WIDTH = 128
+PAGES = 8
+FB_BYTES = WIDTH * PAGES
+
+
+def crc32_msb(data):
+    """CRC-32 de lib/crc32.c (0x04C11DB7, MSB primeiro, sem XOR final)."""
+    crc = 0xFFFFFFFF
+    for b in data:
+        crc ^= b << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def rle_page(payload, pos):
+    """Decodifica os 128 bytes de uma página a partir de payload[pos]."""
+    out = bytearray()
+    while len(out) < WIDTH:
+        ctrl = payload[pos]
+        if ctrl & 0x80:
+            out.extend([payload[pos + 1]] * ((ctrl & 0x7F) + 1))
+            pos += 2
+        else:
+            out.extend(payload[pos + 1:pos + 2 + ctrl])
+            pos += 2 + ctrl
+    if len(out) != WIDTH:
+        raise ValueError("pagina com tamanho invalido")
+    return out, pos
+
+
+class Mirror:
+    def __init__(self):
+        self.fb = bytearray(FB_BYTES)
+        self.synced = False
+        self.frames = 0
+        self.errors = 0
+        self.last_bytes = 0
+
+    def apply(self, line):
+        parts = line.split()
+        if len(parts) != 5 or parts[0] != "@FB":
+            return False
+        kind, crc_hex, payload_hex = parts[1], parts[3], parts[4]
+        try:
+            payload = bytes.fromhex(payload_hex)
+            if kind == "K":
+                fb = bytearray(FB_BYTES)
+            elif self.synced:
+                fb = bytearray(self.fb)
+            else:
+                return False        # delta sem base: espera uma chave
+            pos = 0
+            while pos < len(payload):
+                page = payload[pos]
+                if page >= PAGES:
+                    raise ValueError("pagina fora da faixa")
+                delta, pos = rle_page(payload, pos + 1)
+                for x in range(WIDTH):
+                    fb[page + x * PAGES] ^= delta[x]
+        except (ValueError, IndexError):
+            self.synced = False
+            self.errors += 1
+            return True
+
+        if crc32_msb(fb) != int(crc_hex, 16):
+            self.synced = False
+            self.errors += 1
+            return True
+        self.fb = fb
+        self.synced = True
+        self.frames += 1
+        self.last_bytes = len(payload)
+        return True
+
+    def pixel(self, x, y):
+        return bool(self.fb[(y >> 3) + x * PAGES] & (1 << (y & 7)))
+
+    def render(self):
+        rows = []
+        for y in range(0, 64, 2):
+            row = []
+            for x in range(WIDTH):
+                top, bottom = self.pixel(x, y), self.pixel(x, y + 1)
+                row.append("█" if top and bottom else "▀" if top
+                           else "▄" if bottom else " ")
+            rows.append("".join(row))
+        state = "ok" if self.synced else "DESSINCRONIZADO (aguardando quadro-chave)"
+        rows.append(f"quadros {self.frames}  erros {self.errors}  "
+                    f"ultimo {self.last_bytes} bytes  {state}")
+        return rows
+
+    def write_pbm(self, path):
+        with open(path, "w") as f:
+            f.write(f"P1\n{WIDTH} 64\n")
+            for y in range(64):
+                f.write(" ".join("1" if self.pixel(x, y) else "0" for x in range(WIDTH)))
+                f.write("\n")
+
+
+def open_input(path):
+    if path == "-":
+        return sys.stdin.buffer
+    if os.path.exists(path) and not os.path.isfile(path):
+        # Porta serial: modo cru (CDC USB ignora baud rate)
+        import termios
+        import tty
+        fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+        tty.setraw(fd, termios.TCSANOW)
+        return os.fdopen(fd, "rb", buffering=0)
+    return open(path, "rb")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("source", help="porta serial, arquivo de captura ou '-'")
+    ap.add_argument("--pbm", help="grava o último quadro reconstruído (sem tela)")
+    ap.add_argument("--log", action="store_true", help="mostra as demais linhas do console")
+    args = ap.parse_args()
+
+    mirror = Mirror()
+    live = args.pbm is None and sys.stdout.isatty()
+    log = []
+    buf = b""
+    src = open_input(args.source)
+
+    if live:
+        sys.stdout.write("\x1b[2J")
+    try:
+        while True:
+            chunk = src.read(4096) if src is not sys.stdin.buffer else src.readline()
+            if not chunk:
+                break
+            buf += chunk
+            while b"\n" in buf:
+                raw, buf = buf.split(b"\n", 1)
+                line = raw.decode("latin-1").strip()
+                if mirror.apply(line):
+                    if live:
+                        out = mirror.render()
+                        if args.log:
+                            out += log[-8:]
+                        sys.stdout.write("\x1b[H" + "\n".join(o + "\x1b[K" for o in out) + "\n")
+                        sys.stdout.flush()
+                elif line and args.log:
+                    log.append(line)
+    except KeyboardInterrupt:
+        pass
+
+    if args.pbm:
+        mirror.write_pbm(args.pbm)
+    if not live:
+        print(f"{mirror.frames} quadros, {mirror.errors} erros, "
+              f"{'sincronizado' if mirror.synced else 'dessincronizado'}")
+
+
+if __name__ == "__main__":
+    main()
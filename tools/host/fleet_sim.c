@@ -0,0 +1,404 @@
+/**
+ * Simulador de frota: N controladores rodando o firmware no host
+ *
+ * Cada instância é um processo filho com o firmware inteiro (os módulos
+ * guardam estado em variáveis estáticas) sobre o HAL de host_hal.c. O
+ * console de cada uma é um pty: o gateway abre o caminho impresso (ou o
+ * link em -l DIR) como se fosse a porta USB de uma placa.
+ *
+ * Watchdog expirado encerra o filho, que é reiniciado com os scratch,
+ * a flash e as estatísticas preservados. O relatório periódico mostra,
+ * por instância, comandos atendidos, vazão e latência (da chegada do
+ * primeiro byte até o firmware voltar a esperar entrada).
+ *
+ * Com -r, a linha @TR de um trace gravado numa placa (input_trace) vai
+ * para a flash de todas as instâncias marcada para reproduzir no boot:
+ * a frota inteira repete a mesma sequência de botões e comandos.
+ *
+ * Com -t, o sensor de temperatura das instâncias lê o valor dado (regras
+ * "temp above ..." do rule_engine); o padrão é 25 graus.
+ *
+ * Uso: fleet_sim [-n N] [-d segundos] [-i segundos] [-l dir] [-s dir] [-r arquivo] [-t graus]
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "lib/flash_layout.h"
+#include "lib/input_trace.h"
+#include "host_hal.h"
+
+#define SIM_MAX_UNITS       512
+#define SIM_POLL_MS         100
+#define SIM_TEMP_C10        250
+
+typedef struct {
+    int master_fd;
+    char pty[64];
+    char link[256];
+    uint8_t *flash;
+    uint64_t last_commands;     // para a vazão do intervalo
+} sim_unit_t;
+
+static host_unit_t *shared;
+static sim_unit_t units[SIM_MAX_UNITS];
+static int unit_count = 4;
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// ===== PTY =====
+static bool open_pty(sim_unit_t *u) {
+    u->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (u->master_fd < 0 || grantpt(u->master_fd) < 0 || unlockpt(u->master_fd) < 0) {
+        perror("posix_openpt");
+        return false;
+    }
+    snprintf(u->pty, sizeof(u->pty), "%s", ptsname(u->master_fd));
+
+    // Modo cru no lado do gateway: bytes passam sem eco nem edição de linha
+    int slave = open(u->pty, O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        perror(u->pty);
+        return false;
+    }
+    struct termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    close(slave);
+    return true;
+}
+
+// ===== FLASH =====
+// Área de dados nova = apagada; a imagem do firmware não é lida dali
+static uint8_t *map_flash(const char *state_dir, int index) {
+    int fd = -1;
+    bool fresh = true;
+    int flags = MAP_SHARED | MAP_ANONYMOUS;
+
+    if (state_dir) {
+        char path[512];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/unit%03d.flash", state_dir, index);
+        fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            perror(path);
+            return NULL;
+        }
+        fresh = st.st_size != PICO_FLASH_SIZE_BYTES;
+        if (fresh && ftruncate(fd, PICO_FLASH_SIZE_BYTES) < 0) {
+            perror(path);
+            close(fd);
+            return NULL;
+        }
+        flags = MAP_SHARED;
+    }
+
+    uint8_t *flash = mmap(NULL, PICO_FLASH_SIZE_BYTES, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (fd >= 0) close(fd);
+    if (flash == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    if (fresh) {
+        memset(flash + FLASH_DATA_OFFSET, 0xFF, PICO_FLASH_SIZE_BYTES - FLASH_DATA_OFFSET);
+    }
+    return flash;
+}
+
+// ===== TRACE DE ENTRADAS =====
+static uint8_t trace_sector[FLASH_SECTOR_SIZE];
+
+static int hex_nibble(int ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    return -1;
+}
+
+// Usa a última linha "@TR <hex>" do arquivo (log do console serve)
+static bool load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char *line = NULL, *last = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, f) > 0) {
+        char *at = strstr(line, "@TR ");
+        if (at) {
+            free(last);
+            last = strdup(at + 4);
+        }
+    }
+    free(line);
+    fclose(f);
+    if (!last) {
+        fprintf(stderr, "%s: nenhuma linha @TR\n", path);
+        return false;
+    }
+
+    size_t n = 0;
+    int hi = -1;
+    for (const char *c = last; *c && *c != '\r' && *c != '\n' && n < sizeof(trace_sector); c++) {
+        int v = hex_nibble(*c);
+        if (v < 0) break;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            trace_sector[n++] = (uint8_t)(hi << 4 | v);
+            hi = -1;
+        }
+    }
+    free(last);
+
+    // O firmware confere o CRC; aqui só o formato e o tamanho
+    input_trace_header_t *hdr = (input_trace_header_t *)trace_sector;
+    if (n < sizeof(*hdr) || hdr->magic != INPUT_TRACE_MAGIC ||
+        n != sizeof(*hdr) + hdr->length) {
+        fprintf(stderr, "%s: linha @TR invalida (%zu bytes)\n", path, n);
+        return false;
+    }
+    hdr->flags |= INPUT_TRACE_FLAG_BOOT;
+    memset(trace_sector + n, 0xFF, sizeof(trace_sector) - n);
+    printf("trace: %u eventos, %lu ms\n", hdr->events, (unsigned long)hdr->duration_ms);
+    return true;
+}
+
+// ===== INSTÂNCIAS =====
+static void start_unit(int i) {
+    host_unit_t *hu = &shared[i];
+    hu->wdt.ctrl = 0;
+    hu->wdt.load = 0;
+    hu->stats.boots++;
+    hu->stats.boot_ms = 0;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        // Ctrl-C é do pai: ele encerra os filhos e imprime o relatório
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, SIG_DFL);
+        for (int j = 0; j < unit_count; j++) {
+            if (j != i) close(units[j].master_fd);
+        }
+        fclose(stdin);
+        host_hal_run(hu, units[i].flash, units[i].master_fd);
+    }
+    hu->pid = pid;
+}
+
+static int unit_by_pid(pid_t pid) {
+    for (int i = 0; i < unit_count; i++) {
+        if (shared[i].pid == pid) return i;
+    }
+    return -1;
+}
+
+// Reinicia quem saiu: watchdog conta como reset, o resto como falha
+static void reap_units(void) {
+    int status;
+    pid_t pid;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        int i = unit_by_pid(pid);
+        if (i < 0) continue;
+        host_unit_t *hu = &shared[i];
+        if (WIFEXITED(status) && WEXITSTATUS(status) == HOST_EXIT_WDT) {
+            hu->stats.wdt_resets++;
+        } else {
+            hu->stats.crashes++;
+            hu->wdt.reason = 0;     // volta como power-on
+            fprintf(stderr, "unidade %d: processo terminou (status 0x%x), reiniciando\n",
+                    i, status);
+        }
+        hu->pid = 0;
+        if (!stop) start_unit(i);
+    }
+}
+
+// ===== RELATÓRIO =====
+static uint32_t percentile_us(const host_unit_stats_t *st, double p) {
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < HOST_LAT_BUCKETS; b++) total += st->lat_hist[b];
+    if (total == 0) return 0;
+
+    uint64_t want = (uint64_t)(p * (double)total + 0.5);
+    if (want == 0) want = 1;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < HOST_LAT_BUCKETS; b++) {
+        seen += st->lat_hist[b];
+        if (seen >= want) {
+            // Limite da faixa, sem passar do máximo medido
+            uint32_t us = host_lat_bucket_max(b);
+            return us < st->lat_max_us ? us : st->lat_max_us;
+        }
+    }
+    return st->lat_max_us;
+}
+
+static void report(double elapsed, double interval, bool final) {
+    host_unit_stats_t sum;
+    uint64_t sum_delta = 0;
+    memset(&sum, 0, sizeof(sum));
+
+    printf("\n--- %s %.1f s ---\n", final ? "final" : "t =", elapsed);
+    printf("unid pty            cmds    cmd/s  med(ms)  p99(ms)  max(ms)  boot(ms)   rx      tx  wdt falhas\n");
+    for (int i = 0; i < unit_count; i++) {
+        host_unit_stats_t st = shared[i].stats;
+        uint64_t delta = st.commands - units[i].last_commands;
+        units[i].last_commands = st.commands;
+        double rate = final ? st.commands / elapsed : delta / interval;
+
+        printf("%4d %-12s %6llu %8.1f %8.1f %8.1f %8.1f %9lu %6llu %7llu %4lu %6lu\n",
+               i, units[i].pty, (unsigned long long)st.commands, rate,
+               percentile_us(&st, 0.50) / 1000.0, percentile_us(&st, 0.99) / 1000.0,
+               st.lat_max_us / 1000.0, (unsigned long)st.boot_ms,
+               (unsigned long long)st.bytes_in, (unsigned long long)st.bytes_out,
+               (unsigned long)st.wdt_resets, (unsigned long)st.crashes);
+
+        sum.commands += st.commands;
+        sum.bytes_in += st.bytes_in;
+        sum.bytes_out += st.bytes_out;
+        sum.wdt_resets += st.wdt_resets;
+        sum.crashes += st.crashes;
+        if (st.lat_max_us > sum.lat_max_us) sum.lat_max_us = st.lat_max_us;
+        for (uint32_t b = 0; b < HOST_LAT_BUCKETS; b++) sum.lat_hist[b] += st.lat_hist[b];
+        sum_delta += delta;
+    }
+    printf("frota%-12s %6llu %8.1f %8.1f %8.1f %8.1f %9s %6llu %7llu %4lu %6lu\n", "",
+           (unsigned long long)sum.commands, final ? sum.commands / elapsed : sum_delta / interval,
+           percentile_us(&sum, 0.50) / 1000.0, percentile_us(&sum, 0.99) / 1000.0,
+           sum.lat_max_us / 1000.0, "",
+           (unsigned long long)sum.bytes_in, (unsigned long long)sum.bytes_out,
+           (unsigned long)sum.wdt_resets, (unsigned long)sum.crashes);
+    fflush(stdout);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-n N] [-d segundos] [-i segundos] [-l dir] [-s dir] [-r arquivo] [-t graus]\n"
+            "  -n  instancias (padrao 4, max %d)\n"
+            "  -d  duracao; 0 = ate Ctrl-C (padrao)\n"
+            "  -i  intervalo do relatorio (padrao 5 s)\n"
+            "  -l  cria links dir/unitNNN para os ptys\n"
+            "  -s  flash persistente em dir/unitNNN.flash\n"
+            "  -r  reproduz no boot a ultima linha @TR do arquivo\n"
+            "  -t  temperatura do chip das instancias (padrao 25)\n",
+            prog, SIM_MAX_UNITS);
+}
+
+int main(int argc, char **argv) {
+    double duration = 0, interval = 5;
+    const char *link_dir = NULL, *state_dir = NULL, *trace_path = NULL;
+    double temp = SIM_TEMP_C10 / 10.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:i:l:s:r:t:h")) != -1) {
+        switch (opt) {
+            case 'n': unit_count = atoi(optarg); break;
+            case 'd': duration = atof(optarg); break;
+            case 'i': interval = atof(optarg); break;
+            case 'l': link_dir = optarg; break;
+            case 's': state_dir = optarg; break;
+            case 'r': trace_path = optarg; break;
+            case 't': temp = atof(optarg); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (unit_count < 1 || unit_count > SIM_MAX_UNITS || interval <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (trace_path && !load_trace(trace_path)) {
+        return 1;
+    }
+
+    shared = mmap(NULL, sizeof(host_unit_t) * unit_count, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    memset(shared, 0, sizeof(host_unit_t) * unit_count);
+
+    for (int i = 0; i < unit_count; i++) {
+        sim_unit_t *u = &units[i];
+        shared[i].temp_c10 = (int16_t)(temp * 10.0);
+        if (!open_pty(u) || !(u->flash = map_flash(state_dir, i))) {
+            return 1;
+        }
+        if (trace_path) {
+            memcpy(u->flash + FLASH_TRACE_OFFSET, trace_sector, sizeof(trace_sector));
+        }
+        if (link_dir) {
+            snprintf(u->link, sizeof(u->link), "%s/unit%03d", link_dir, i);
+            unlink(u->link);
+            if (symlink(u->pty, u->link) < 0) {
+                perror(u->link);
+                u->link[0] = '\0';
+            }
+        }
+        printf("unidade %3d: %s%s%s\n", i, u->pty, u->link[0] ? " <- " : "", u->link);
+    }
+    fflush(stdout);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+    for (int i = 0; i < unit_count; i++) {
+        start_unit(i);
+    }
+
+    double t0 = now_s();
+    double next_report = t0 + interval;
+    while (!stop) {
+        usleep(SIM_POLL_MS * 1000);
+        reap_units();
+        double t = now_s();
+        if (duration > 0 && t - t0 >= duration) {
+            break;
+        }
+        if (t >= next_report) {
+            report(t - t0, interval, false);
+            next_report += interval;
+        }
+    }
+    stop = 1;
+
+    for (int i = 0; i < unit_count; i++) {
+        if (shared[i].pid > 0) kill(shared[i].pid, SIGTERM);
+    }
+    while (wait(NULL) > 0) {
+    }
+    report(now_s() - t0, interval, true);
+
+    for (int i = 0; i < unit_count; i++) {
+        if (units[i].link[0]) unlink(units[i].link);
+    }
+    return 0;
+}
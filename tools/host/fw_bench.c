@@ -0,0 +1,467 @@
+/**
+ * Benchmark dos caminhos quentes do firmware no host
+ *
+ * Roda sobre o HAL do host (como uma instância do fleet_sim, com o console
+ * em /dev/null) e mede, por operação:
+ *   - conversão de quadros: RAW -> níveis PWM, fonte comprimida -> PWM,
+ *     intervalos de marca do planejador
+ *   - protocolos: codec de quadros RAW, compilação de perfil de AC, CRC32
+ *   - parsing do console: linha @AP
+ *   - fila de comandos da frota: estado desejado -> plano de quadros
+ *   - regras de automação: reavaliação das 32 regras de um programa
+ *   - SSD1306: preencher, primitivas (pixel, linha, retângulo), texto,
+ *     gráfico de tendência
+ *
+ * Cada caso é calibrado para rodadas de -m ms / 7 de CPU, e o resultado é
+ * a melhor de 7 rodadas intercaladas entre os casos (tempo de CPU da
+ * thread: preempção por outros processos não entra na medida).
+ *
+ * Os resultados saem em unidades de um laço de calibração (inteiros,
+ * desvios e leituras de tabela, como os casos) medido junto com eles: a
+ * mesma referência vale em máquinas mais rápidas ou mais lentas. O ns/op
+ * da máquina vai no JSON (calib_ns) e na tabela da comparação. O JSON
+ * (ordem fixa, um caso por linha) vai para a saída padrão ou para -o. Com
+ * -b, compara com uma referência gravada: piora acima de -t % em algum
+ * caso encerra com 1.
+ *
+ * Uso: fw_bench [-m ms] [-o saida.json] [-b referencia.json] [-t %]
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lib/ac_profile.h"
+#include "lib/crc32.h"
+#include "lib/custom_ir.h"
+#include "lib/fleet.h"
+#include "lib/flash_layout.h"
+#include "lib/hex_line.h"
+#include "lib/ir_codec.h"
+#include "lib/kv_store.h"
+#include "lib/oled_graph.h"
+#include "lib/rule_engine.h"
+#include "lib/ssd1306.h"
+#include "host_hal.h"
+
+#define BENCH_ROUNDS        7
+#define BENCH_IR_PIN        16
+#define BENCH_VERSION       2       // 1: ns/op absolutos (não comparável)
+#define CALIB_STEPS         64
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} bench_case_t;
+
+static uint32_t min_ms = 500;
+static const char *out_path = NULL;
+static const char *baseline_path = NULL;
+static double tolerance_pct = 30.0;
+static FILE *json_out;              // saída padrão original (o printf vai ao console)
+static volatile uint32_t sink;      // impede o compilador de descartar o trabalho
+
+// Perfil de exemplo de tools/ac_profile.py (docstring), como chega no console
+static const char ap_line[] =
+    "P 4143503153414C41320000000000000001170F02111E180170940000280030113011260240"
+    "062602000006010500B24D00000000000000000000000000000207010002040300030004000200"
+    "030002000300040504020111B3216AB4\n";
+
+// Estados da aplicação (os mesmos de Teste_protocolo.c)
+static const ac_setting_t states[] = {
+    { .power = false },
+    { .power = true, .mode = AC_MODE_COOL },
+    { .power = true, .mode = AC_MODE_COOL, .temp_c = 20 },
+    { .power = true, .mode = AC_MODE_COOL, .temp_c = 22 },
+    { .power = true, .mode = AC_MODE_FAN, .fan = 1 },
+    { .power = true, .mode = AC_MODE_FAN, .fan = 2 },
+};
+
+static const uint16_t *frame;
+static size_t frame_len;
+static uint8_t blob[1024];
+static size_t blob_len;
+static ir_codec_decoder_t decoder;
+static ssd1306_t ssd;
+static oled_graph_t graph;
+static uint8_t crc_block[FLASH_SECTOR_SIZE];
+static uint8_t rule_blob[RULE_MAX_BYTES] __attribute__((aligned(4)));
+static int32_t rule_temp_c10 = 250;
+static uint8_t calib_table[256];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// ===== CALIBRAÇÃO =====
+
+// Unidade dos resultados: mistura fixa de aritmética, desvios dependentes
+// de dado e leituras de tabela em L1
+static void __attribute__((noinline)) bench_calib(void) {
+    static uint32_t x = 2463534242u;
+    uint32_t acc = 0;
+    for (int i = 0; i < CALIB_STEPS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        acc += calib_table[x & 0xFF];
+        if (x & 0x100) {
+            acc ^= acc >> 3;
+        }
+    }
+    sink += acc;
+}
+
+// ===== CASOS =====
+
+static void bench_ir_dma_blocks(void) {
+    sink += custom_ir_prepare_blocks(0, frame, frame_len, NULL);
+}
+
+static void bench_ir_dma_blocks_stream(void) {
+    sink += custom_ir_prepare_blocks(0, NULL, 0, &decoder.source);
+}
+
+static void bench_ir_mark_intervals(void) {
+    ir_interval_t iv[128];
+    sink += (uint32_t)custom_ir_mark_intervals(0, frame, frame_len, iv, 128);
+}
+
+static void bench_ir_codec_encode(void) {
+    uint8_t out[1024];
+    sink += (uint32_t)ir_codec_encode(frame, frame_len, out, sizeof(out), NULL);
+}
+
+static void bench_ir_codec_decode(void) {
+    uint16_t out[512];
+    sink += (uint32_t)ir_codec_decode(blob, blob_len, out, 512);
+}
+
+static void bench_ac_profile_compile(void) {
+    sink += ac_profile_select(0, 1, false);
+}
+
+static void bench_crc32_4k(void) {
+    sink += crc32_compute(crc_block, sizeof(crc_block));
+}
+
+static void bench_console_ap_line(void) {
+    uint8_t buf[sizeof(ac_profile_def_t)];
+    hex_line_t line;
+    hex_line_begin(&line, buf, sizeof(buf), "P ");
+    for (const char *p = ap_line; hex_line_feed(&line, *p); p++) {
+    }
+    sink += (uint32_t)line.length + line.ok;
+}
+
+static void fleet_batch_ok(fleet_frame_t *frames, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        frames[i].ok = true;
+        frames[i].airtime_us = 150000;
+    }
+}
+
+static void bench_fleet_plan(void) {
+    static uint32_t now_ms;
+    now_ms += 1000;
+    fleet_set_all((uint8_t)(now_ms / 1000 % 2), now_ms);
+    fleet_set_zone('B', 2 + (uint8_t)(now_ms / 1000 % 4), now_ms);
+    sink += fleet_flush_batch(fleet_batch_ok, now_ms);
+}
+
+static void bench_ssd1306_fill(void) {
+    ssd1306_fill(&ssd, sink & 1);
+}
+
+static void bench_ssd1306_primitives(void) {
+    ssd1306_fill(&ssd, false);
+    ssd1306_rect(&ssd, 0, 0, 128, 64, true, false);
+    ssd1306_rect(&ssd, 8, 8, 40, 20, true, true);
+    ssd1306_line(&ssd, 0, 0, 127, 63, true);
+    ssd1306_line(&ssd, 0, 63, 127, 0, true);
+    for (uint8_t y = 32; y < 64; y += 4) {
+        ssd1306_hline(&ssd, 60, 120, y, true);
+    }
+    for (uint8_t x = 60; x < 128; x += 8) {
+        ssd1306_vline(&ssd, x, 2, 30, true);
+    }
+    for (uint8_t i = 0; i < 64; i++) {
+        ssd1306_pixel(&ssd, (uint8_t)(i * 2), i, true);
+    }
+}
+
+static void bench_ssd1306_text(void) {
+    ssd1306_fill(&ssd, false);
+    for (uint8_t row = 0; row < 8; row++) {
+        ssd1306_draw_string(&ssd, "TEMP 22C  FAN 2 ", 0, (uint8_t)(row * 8));
+    }
+}
+
+static void bench_oled_graph(void) {
+    oled_graph_draw(&graph, &ssd);
+}
+
+// Todas as regras leem a temperatura: cada troca reavalia as 32
+static void bench_rule_poll(void) {
+    rule_temp_c10 = rule_temp_c10 == 250 ? 290 : 250;
+    rule_engine_set_input(RULE_IN_TEMP, rule_temp_c10);
+    sink += rule_engine_poll(0);
+}
+
+static const bench_case_t cases[] = {
+    { "ir_dma_blocks",       bench_ir_dma_blocks },
+    { "ir_dma_blocks_stream", bench_ir_dma_blocks_stream },
+    { "ir_mark_intervals",   bench_ir_mark_intervals },
+    { "ir_codec_encode",     bench_ir_codec_encode },
+    { "ir_codec_decode",     bench_ir_codec_decode },
+    { "ac_profile_compile",  bench_ac_profile_compile },
+    { "crc32_4k",            bench_crc32_4k },
+    { "console_ap_line",     bench_console_ap_line },
+    { "fleet_plan",          bench_fleet_plan },
+    { "ssd1306_fill",        bench_ssd1306_fill },
+    { "ssd1306_primitives",  bench_ssd1306_primitives },
+    { "ssd1306_text",        bench_ssd1306_text },
+    { "oled_graph_draw",     bench_oled_graph },
+    { "rule_poll",           bench_rule_poll },
+};
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+// ===== PREPARAÇÃO =====
+
+// 32 x "if temp above 25.N and not state is fan2" (como o rulec.py gera)
+static bool build_rules(void) {
+    rule_header_t *hdr = (rule_header_t *)rule_blob;
+    rule_entry_t *table = (rule_entry_t *)(hdr + 1);
+    uint8_t *code = (uint8_t *)(table + RULE_MAX_RULES);
+    uint16_t len = 0;
+
+    for (uint8_t r = 0; r < RULE_MAX_RULES; r++) {
+        uint16_t limit = (uint16_t)(250 + r);
+        const uint8_t rule[] = {
+            RULE_OP_LOAD, RULE_IN_TEMP, RULE_OP_PUSH16, (uint8_t)limit, (uint8_t)(limit >> 8),
+            RULE_OP_GT, RULE_OP_LOAD, RULE_IN_STATE, RULE_OP_PUSH8, 5, RULE_OP_NE, RULE_OP_AND,
+        };
+        table[r] = (rule_entry_t){ .offset = len, .length = sizeof(rule), .action = 0 };
+        memcpy(code + len, rule, sizeof(rule));
+        len += sizeof(rule);
+    }
+    hdr->magic = RULE_MAGIC;
+    hdr->rules = RULE_MAX_RULES;
+    hdr->reserved = 0;
+    hdr->code_len = len;
+    hdr->crc = crc32_compute(table, RULE_MAX_RULES * sizeof(rule_entry_t) + len);
+    if (!rule_engine_load(rule_blob, sizeof(rule_blob))) {
+        return false;
+    }
+    rule_engine_set_input(RULE_IN_STATE, 0);
+    return true;
+}
+
+static bool setup(void) {
+    if (!custom_ir_init(BENCH_IR_PIN) || !kv_store_init()) {
+        return false;
+    }
+    custom_ir_get_command(IR_CMD_OFF, &frame, &frame_len, NULL);
+    blob_len = ir_codec_encode(frame, frame_len, blob, sizeof(blob), NULL);
+    if (!blob_len || !ir_codec_decoder_init(&decoder, blob, blob_len)) {
+        return false;
+    }
+
+    // Perfil P1 gravado direto na flash, decodificado da linha @AP
+    uint8_t page[FLASH_PAGE_SIZE];
+    hex_line_t line;
+    memset(page, 0xFF, sizeof(page));
+    hex_line_begin(&line, page, sizeof(ac_profile_def_t), "P ");
+    for (const char *p = ap_line; hex_line_feed(&line, *p); p++) {
+    }
+    memcpy(host_flash + FLASH_PROFILE_OFFSET, page, sizeof(page));
+    ac_profile_init(states, sizeof(states) / sizeof(states[0]));
+    if (!ac_profile_get(1)) {
+        return false;
+    }
+
+    fleet_init();
+    for (uint8_t i = 0; i < FLEET_MAX_UNITS; i++) {
+        fleet_add_unit(i % 4, i % 2, i < 4 ? 'A' : 'B');
+    }
+
+    ssd1306_init(&ssd, WIDTH, HEIGHT, false, 0x3C, i2c1);
+    oled_graph_init(&graph, 0, 128, 2, 6, 0, 100, OLED_GRAPH_MAX, true);
+    for (int32_t i = 0; i < 200; i++) {
+        oled_graph_sample(&graph, (i * 37) % 100);
+        oled_graph_tick(&graph);
+    }
+
+    for (size_t i = 0; i < sizeof(crc_block); i++) {
+        crc_block[i] = (uint8_t)(i * 131);
+    }
+    for (size_t i = 0; i < sizeof(calib_table); i++) {
+        calib_table[i] = (uint8_t)(i * 167 + 13);
+    }
+    return build_rules();
+}
+
+// ===== MEDIÇÃO =====
+
+static uint64_t run_round(void (*run)(void), uint32_t iters) {
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iters; i++) {
+        run();
+    }
+    return now_ns() - start;
+}
+
+// Iterações para uma rodada de round_ns
+static uint32_t calibrate(void (*run)(void), uint64_t round_ns) {
+    uint32_t iters = 1;
+    while (run_round(run, iters) < round_ns / 4 && iters < (1u << 30)) {
+        iters *= 2;
+    }
+    return iters * 4;
+}
+
+// ns por operação: melhor de BENCH_ROUNDS rodadas. As rodadas se
+// intercalam entre os casos (e o laço de calibração, no índice
+// CASE_COUNT), para uma perturbação longa da máquina não atingir todas as
+// rodadas de um mesmo caso
+static void measure_all(double *ns_op) {
+    uint64_t round_ns = (uint64_t)min_ms * 1000000u / BENCH_ROUNDS;
+    uint32_t iters[CASE_COUNT + 1];
+
+    for (size_t i = 0; i <= CASE_COUNT; i++) {
+        iters[i] = calibrate(i < CASE_COUNT ? cases[i].run : bench_calib, round_ns);
+        ns_op[i] = -1.0;
+    }
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i <= CASE_COUNT; i++) {
+            double ns = (double)run_round(i < CASE_COUNT ? cases[i].run : bench_calib, iters[i]) / iters[i];
+            if (ns_op[i] < 0 || ns < ns_op[i]) {
+                ns_op[i] = ns;
+            }
+        }
+    }
+}
+
+// ===== REFERÊNCIA =====
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char *text = malloc((size_t)size + 1);
+    size_t n = fread(text, 1, (size_t)size, fp);
+    text[n] = '\0';
+    fclose(fp);
+    return text;
+}
+
+// Valor do caso no JSON da referência ("nome": valor); < 0 se ausente
+static double baseline_value(const char *json, const char *name) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"%s\":", name);
+    const char *p = strstr(json, key);
+    return p ? strtod(p + strlen(key), NULL) : -1.0;
+}
+
+// Compara em unidades de calibração; o ns/op é só informativo
+static int compare(const double *results, double calib_ns) {
+    char *json = read_file(baseline_path);
+    if (!json) {
+        return 1;
+    }
+    if (baseline_value(json, "version") != BENCH_VERSION) {
+        fprintf(stderr, "%s: referencia sem calibracao (versao antiga); gere de novo com -o\n",
+                baseline_path);
+        free(json);
+        return 1;
+    }
+    int regressions = 0;
+    fprintf(stderr, "calibracao: %.2f ns (referencia %.2f ns)\n", calib_ns,
+            baseline_value(json, "calib_ns"));
+    fprintf(stderr, "%-20s %10s %10s %10s %8s\n", "caso", "ref", "atual", "ns/op", "delta");
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        double base = baseline_value(json, cases[i].name);
+        if (base <= 0) {
+            fprintf(stderr, "%-20s %10s %10.3f %10.1f %8s  novo\n", cases[i].name, "-",
+                    results[i], results[i] * calib_ns, "");
+            continue;
+        }
+        double delta = (results[i] / base - 1.0) * 100.0;
+        bool worse = delta > tolerance_pct;
+        regressions += worse;
+        fprintf(stderr, "%-20s %10.3f %10.3f %10.1f %+7.1f%%%s\n", cases[i].name, base,
+                results[i], results[i] * calib_ns, delta, worse ? "  PIOROU" : "");
+    }
+    free(json);
+    if (regressions) {
+        fprintf(stderr, "%d caso(s) acima da tolerancia de %.0f%%\n", regressions, tolerance_pct);
+    }
+    return regressions ? 1 : 0;
+}
+
+// Entrada do "firmware" sob o HAL do host
+int firmware_main(void) {
+    double ns_op[CASE_COUNT + 1];
+    double results[CASE_COUNT];
+
+    if (!setup()) {
+        fprintf(stderr, "fw_bench: falha na preparacao\n");
+        exit(1);
+    }
+    measure_all(ns_op);
+    double calib_ns = ns_op[CASE_COUNT];
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        results[i] = ns_op[i] / calib_ns;
+    }
+
+    fprintf(json_out, "{\n  \"version\": %d,\n  \"unit\": \"calib/op\",\n"
+            "  \"calib_ns\": %.2f,\n  \"results\": {\n", BENCH_VERSION, calib_ns);
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        fprintf(json_out, "    \"%s\": %.3f%s\n", cases[i].name, results[i],
+                i + 1 < CASE_COUNT ? "," : "");
+    }
+    fprintf(json_out, "  }\n}\n");
+    fflush(json_out);
+
+    exit(baseline_path ? compare(results, calib_ns) : 0);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:o:b:t:h")) != -1) {
+        switch (opt) {
+            case 'm': min_ms = (uint32_t)atoi(optarg); break;
+            case 'o': out_path = optarg; break;
+            case 'b': baseline_path = optarg; break;
+            case 't': tolerance_pct = atof(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-m ms] [-o saida.json] [-b referencia.json] [-t %%]\n",
+                        argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // O stdout do processo vira o console do firmware (descartado)
+    json_out = out_path ? fopen(out_path, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!json_out) {
+        perror(out_path);
+        return 1;
+    }
+    int console = open("/dev/null", O_RDWR);
+    static host_unit_t unit;
+    uint8_t *flash = malloc(PICO_FLASH_SIZE_BYTES);
+    memset(flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+    host_hal_run(&unit, flash, console);
+}
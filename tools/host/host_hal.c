@@ -0,0 +1,908 @@
+/**
+ * HAL do host para o simulador de frota
+ * Tempo real (CLOCK_MONOTONIC), console no pty, watchdog, alarmes,
+ * PWM + DMA no ritmo do wrap (com blocos de controle encadeados) e flash
+ * NOR em memória compartilhada
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "lib/crc32.h"
+#include "host_hal.h"
+
+int firmware_main(void);
+
+// Máximo de uma espera sem nada agendado (reconexão do host, watchdog)
+#define HOST_IDLE_SLICE_US     10000
+// Prazo de uma escrita no console com o host sem ler (como o stdio USB)
+#define HOST_STDOUT_TIMEOUT_MS 100
+
+static host_unit_t *unit;
+static int console_fd = -1;
+static uint64_t boot_ns;
+
+uint8_t *host_flash;
+watchdog_hw_t *watchdog_hw;
+
+static pwm_hw_t pwm_regs;
+pwm_hw_t *const pwm_hw = &pwm_regs;
+
+struct i2c_inst {
+    uint baudrate;
+};
+static struct i2c_inst i2c_regs[2];
+i2c_inst_t *const i2c0 = &i2c_regs[0];
+i2c_inst_t *const i2c1 = &i2c_regs[1];
+
+// ===== TEMPO =====
+static uint64_t raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec - boot_ns;
+}
+
+static void service(void);
+
+uint64_t time_us_64(void) {
+    service();
+    return raw_ns() / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+// ===== WATCHDOG =====
+static bool wdt_enabled = false;
+static uint32_t wdt_load_ticks;
+static uint64_t wdt_deadline_us;
+
+static void __attribute__((noreturn)) watchdog_fire(void) {
+    fflush(stdout);
+    watchdog_hw->reason = 1;        // WATCHDOG_REASON_TIMER
+    _exit(HOST_EXIT_WDT);
+}
+
+// Uma escrita em LOAD recarrega o contador (2 ticks por us no RP2040)
+static void service_watchdog(uint64_t now_us) {
+    if (!wdt_enabled) {
+        return;
+    }
+    if (watchdog_hw->load) {
+        wdt_deadline_us = now_us + watchdog_hw->load / 2;
+        watchdog_hw->load = 0;
+    }
+    if (now_us >= wdt_deadline_us) {
+        watchdog_fire();
+    }
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {
+    (void)pause_on_debug;
+    wdt_load_ticks = delay_ms * 1000u * 2u;
+    wdt_enabled = true;
+    watchdog_hw->load = wdt_load_ticks;
+    service_watchdog(raw_ns() / 1000);
+}
+
+void watchdog_update(void) {
+    watchdog_hw->load = wdt_load_ticks;
+    service_watchdog(raw_ns() / 1000);
+}
+
+bool watchdog_caused_reboot(void) {
+    return watchdog_hw->reason != 0;
+}
+
+uint32_t watchdog_get_time_remaining_ms(void) {
+    uint64_t now = raw_ns() / 1000;
+    service_watchdog(now);
+    return wdt_enabled ? (uint32_t)((wdt_deadline_us - now) / 1000) : 0;
+}
+
+// ===== IRQ =====
+static bool irq_on = true;
+static bool in_irq = false;
+
+#define HOST_IRQ_LINES       32
+#define HOST_IRQ_HANDLERS    4
+
+static irq_handler_t irq_handlers[HOST_IRQ_LINES][HOST_IRQ_HANDLERS];
+static bool irq_line_enabled[HOST_IRQ_LINES];
+
+uint32_t save_and_disable_interrupts(void) {
+    uint32_t status = irq_on;
+    irq_on = false;
+    return status;
+}
+
+void restore_interrupts(uint32_t status) {
+    irq_on = status != 0;
+    if (irq_on) {
+        service();      // pendências disparam ao reabilitar
+    }
+}
+
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask) {
+    *addr |= mask;
+}
+
+void hw_clear_bits(volatile uint32_t *addr, uint32_t mask) {
+    *addr &= ~mask;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    memset(irq_handlers[num], 0, sizeof(irq_handlers[num]));
+    irq_handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    for (int i = 0; i < HOST_IRQ_HANDLERS; i++) {
+        if (!irq_handlers[num][i]) {
+            irq_handlers[num][i] = handler;
+            return;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    irq_line_enabled[num] = enabled;
+}
+
+void irq_set_priority(uint num, uint8_t priority) {
+    (void)num;
+    (void)priority;
+}
+
+static void raise_irq(uint num) {
+    if (!irq_line_enabled[num]) {
+        return;
+    }
+    for (int i = 0; i < HOST_IRQ_HANDLERS && irq_handlers[num][i]; i++) {
+        irq_handlers[num][i]();
+    }
+}
+
+// ===== ALARMES =====
+#define HOST_ALARMS 4
+
+static struct {
+    bool claimed;
+    bool armed;
+    uint64_t target_us;
+    hardware_alarm_callback_t callback;
+} alarms[HOST_ALARMS];
+
+int hardware_alarm_claim_unused(bool required) {
+    for (int i = 0; i < HOST_ALARMS; i++) {
+        if (!alarms[i].claimed) {
+            alarms[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host: sem alarme livre\n");
+        abort();
+    }
+    return -1;
+}
+
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback) {
+    alarms[alarm_num].callback = callback;
+    alarms[alarm_num].armed = false;
+}
+
+// true = alvo já passou (alarme não armado), como no SDK
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    if (t <= raw_ns() / 1000) {
+        alarms[alarm_num].armed = false;
+        return true;
+    }
+    alarms[alarm_num].target_us = t;
+    alarms[alarm_num].armed = true;
+    return false;
+}
+
+void hardware_alarm_cancel(uint alarm_num) {
+    alarms[alarm_num].armed = false;
+}
+
+// ===== PWM =====
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = { .csr = 0, .div = 1u << 4, .top = 0xFFFF };
+    return c;
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, float div) {
+    c->div = (uint32_t)(div * 16.0f);
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    pwm_slice_hw_t *s = &pwm_regs.slice[slice_num];
+    s->csr = c->csr;
+    s->div = c->div;
+    s->top = c->top;
+    s->ctr = 0;
+    s->cc = 0;
+    pwm_set_enabled(slice_num, start);
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    volatile uint32_t *cc = &pwm_regs.slice[slice_num].cc;
+    *cc = chan ? ((*cc & 0xFFFFu) | ((uint32_t)level << 16)) : ((*cc & 0xFFFF0000u) | level);
+}
+
+void pwm_set_counter(uint slice_num, uint16_t c) {
+    pwm_regs.slice[slice_num].ctr = c;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    pwm_regs.slice[slice_num].top = wrap;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    if (enabled) {
+        hw_set_bits(&pwm_regs.en, 1u << slice_num);
+    } else {
+        hw_clear_bits(&pwm_regs.en, 1u << slice_num);
+    }
+}
+
+// Período do wrap em ns: (TOP+1) ciclos de 8 ns, vezes o divisor 8.4
+static uint64_t pwm_period_ns(uint slice_num) {
+    const pwm_slice_hw_t *s = &pwm_regs.slice[slice_num];
+    return (uint64_t)(s->top + 1) * s->div / 2;
+}
+
+// ===== DMA =====
+static dma_channel_hw_t dma_regs[NUM_DMA_CHANNELS];
+
+static struct {
+    bool claimed;
+    bool busy;
+    bool intr;              // INTR bruto (fim de bloco)
+    bool inte0;
+    bool inte1;
+    uint32_t reload;        // TRANS_COUNT escrito: volta ao contador a cada disparo
+    uint64_t paced_ns;      // último DREQ atendido (0 = slice parado)
+    dma_channel_config cfg;
+} dma[NUM_DMA_CHANNELS];
+
+static bool sniff_on = false;
+static uint sniff_channel;
+static uint32_t sniff_acc;
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!dma[i].claimed) {
+            dma[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host: sem canal DMA livre\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    dma[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {
+        .size = DMA_SIZE_32,
+        .dreq = DREQ_FORCE,
+        .chain_to = (uint8_t)channel,
+        .read_incr = true,
+        .write_incr = false,
+        .sniff = false,
+        .irq_quiet = false,
+        .ring_write = false,
+        .ring_bits = 0,
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = (uint8_t)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_incr = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_incr = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = (uint8_t)dreq;
+}
+
+void channel_config_set_sniff_enable(dma_channel_config *c, bool sniff) {
+    c->sniff = sniff;
+}
+
+void channel_config_set_irq_quiet(dma_channel_config *c, bool quiet) {
+    c->irq_quiet = quiet;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->chain_to = (uint8_t)chain_to;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_bits = (uint8_t)size_bits;
+}
+
+static void dma_trigger(uint ch);
+
+// Avança o endereço; com anel, só os bits baixos giram
+static uintptr_t dma_advance(uintptr_t addr, uint32_t size, uint8_t ring_bits) {
+    if (ring_bits == 0) {
+        return addr + size;
+    }
+    uintptr_t mask = ((uintptr_t)1 << ring_bits) - 1;
+    return (addr & ~mask) | ((addr + size) & mask);
+}
+
+// Escrita do DMA nos registradores de um canal (blocos de controle): a
+// contagem do alias 3 vira a recarga e o endereço de leitura dispara. O
+// disparo com zero ("null trigger") não inicia o canal e, com IRQ_QUIET,
+// gera a IRQ de fim da cadeia
+static bool dma_reg_write(uintptr_t addr, const void *v, uint32_t size) {
+    uintptr_t base = (uintptr_t)dma_regs;
+    if (addr < base || addr >= base + sizeof(dma_regs)) {
+        return false;
+    }
+    uint ch = (uint)((addr - base) / sizeof(dma_channel_hw_t));
+    dma_channel_hw_t *hw = &dma_regs[ch];
+    memcpy((void *)addr, v, size);
+
+    if (addr == (uintptr_t)&hw->al3_transfer_count) {
+        dma[ch].reload = hw->al3_transfer_count;
+    } else if (addr + size == (uintptr_t)&hw->al3_read_addr_trig + sizeof(hw->al3_read_addr_trig)) {
+        hw->read_addr = hw->al3_read_addr_trig;
+        if (hw->read_addr != 0) {
+            dma_trigger(ch);
+        } else if (dma[ch].cfg.irq_quiet) {
+            dma[ch].intr = true;
+            if (dma[ch].cfg.dreq >= DREQ_PWM_WRAP0 && dma[ch].cfg.dreq < DREQ_PWM_WRAP0 + 8) {
+                unit->stats.ir_frames++;
+            }
+        }
+    }
+    return true;
+}
+
+// Executa n transferências do canal (cópia real, com o sniffer); no fim
+// do bloco dispara o canal encadeado
+static void dma_transfer(uint ch, uint32_t n) {
+    dma_channel_hw_t *hw = &dma_regs[ch];
+    const dma_channel_config *cfg = &dma[ch].cfg;
+    uint32_t size = 1u << cfg->size;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = 0;
+        memcpy(&v, (const void *)hw->read_addr, size);
+        if (sniff_on && sniff_channel == ch && cfg->sniff) {
+            sniff_acc = crc32_update(sniff_acc, &v, size);
+        }
+        if (!dma_reg_write(hw->write_addr, &v, size)) {
+            memcpy((void *)hw->write_addr, &v, size);
+        }
+        if (cfg->read_incr) {
+            hw->read_addr = dma_advance(hw->read_addr, size, cfg->ring_write ? 0 : cfg->ring_bits);
+        }
+        if (cfg->write_incr) {
+            hw->write_addr = dma_advance(hw->write_addr, size, cfg->ring_write ? cfg->ring_bits : 0);
+        }
+    }
+    hw->transfer_count -= n;
+    if (hw->transfer_count == 0) {
+        dma[ch].busy = false;
+        if (!cfg->irq_quiet) {
+            dma[ch].intr = true;
+        }
+        if (cfg->chain_to != ch) {
+            // Recarregado pela cadeia: segue no mesmo ritmo do wrap
+            uint64_t phase = dma[ch].paced_ns;
+            dma_trigger(cfg->chain_to);
+            if (dma[ch].busy) {
+                dma[ch].paced_ns = phase;
+            }
+        }
+    }
+}
+
+static void dma_trigger(uint ch) {
+    dma_regs[ch].transfer_count = dma[ch].reload;
+    if (dma_regs[ch].transfer_count == 0) {
+        return;
+    }
+    dma[ch].busy = true;
+    dma[ch].paced_ns = 0;
+    // Sem DREQ o bloco inteiro sai de uma vez
+    if (dma[ch].cfg.dreq == DREQ_FORCE) {
+        dma_transfer(ch, dma_regs[ch].transfer_count);
+    }
+}
+
+// Avança os canais ritmados pelo wrap do PWM até 'now'
+static void service_dma(uint64_t now) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        uint dreq = dma[ch].cfg.dreq;
+        if (!dma[ch].busy || dreq < DREQ_PWM_WRAP0 || dreq >= DREQ_PWM_WRAP0 + 8) {
+            continue;
+        }
+        uint slice = dreq - DREQ_PWM_WRAP0;
+        if (!(pwm_regs.en & (1u << slice))) {
+            dma[ch].paced_ns = 0;
+            continue;
+        }
+        uint64_t period = pwm_period_ns(slice);
+        if (dma[ch].paced_ns == 0) {
+            dma[ch].paced_ns = now;     // slice acabou de ligar
+            continue;
+        }
+        // Bloco a bloco: a cadeia pode recarregar o canal no meio do intervalo
+        while (dma[ch].busy) {
+            uint64_t n = (now - dma[ch].paced_ns) / period;
+            if (n > dma_regs[ch].transfer_count) {
+                n = dma_regs[ch].transfer_count;
+            }
+            if (n == 0) {
+                break;
+            }
+            dma[ch].paced_ns += n * period;
+            dma_transfer(ch, (uint32_t)n);
+        }
+    }
+}
+
+static bool dma_irq_pending(bool line1) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (dma[ch].intr && (line1 ? dma[ch].inte1 : dma[ch].inte0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma[channel].cfg = *config;
+    dma_regs[channel].write_addr = (uintptr_t)write_addr;
+    dma_regs[channel].read_addr = (uintptr_t)read_addr;
+    dma_regs[channel].transfer_count = transfer_count;
+    dma[channel].reload = transfer_count;
+    if (trigger) dma_trigger(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma_regs[channel].read_addr = (uintptr_t)read_addr;
+    if (trigger) dma_trigger(channel);
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+    dma_regs[channel].write_addr = (uintptr_t)write_addr;
+    if (trigger) dma_trigger(channel);
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    dma_regs[channel].transfer_count = trans_count;
+    dma[channel].reload = trans_count;
+    if (trigger) dma_trigger(channel);
+}
+
+void dma_channel_start(uint channel) {
+    dma_trigger(channel);
+}
+
+void dma_channel_abort(uint channel) {
+    dma[channel].busy = false;
+    dma_regs[channel].transfer_count = 0;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    service();
+    return dma[channel].busy;
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel) {
+    while (dma_channel_is_busy(channel)) {
+        tight_loop_contents();
+    }
+}
+
+// Leitura dos registradores do canal: o DMA anda enquanto o firmware consulta
+dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+    service();
+    return &dma_regs[channel];
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    dma[channel].inte0 = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return dma[channel].intr && dma[channel].inte0;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    dma[channel].intr = false;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+    dma[channel].inte1 = enabled;
+}
+
+bool dma_channel_get_irq1_status(uint channel) {
+    return dma[channel].intr && dma[channel].inte1;
+}
+
+void dma_channel_acknowledge_irq1(uint channel) {
+    dma[channel].intr = false;
+}
+
+// Só o modo CRC32 (MSB primeiro), o único usado pelo firmware
+void dma_sniffer_enable(uint channel, uint mode, bool force_channel_enable) {
+    (void)mode;
+    sniff_channel = channel;
+    sniff_on = true;
+    if (force_channel_enable) {
+        dma[channel].cfg.sniff = true;
+    }
+}
+
+void dma_sniffer_disable(void) {
+    sniff_on = false;
+}
+
+void dma_sniffer_set_data_accumulator(uint32_t seed) {
+    sniff_acc = seed;
+}
+
+uint32_t dma_sniffer_get_data_accumulator(void) {
+    return sniff_acc;
+}
+
+// ===== PONTO DE SERVIÇO =====
+// Faz o papel das IRQs: roda nas leituras de tempo e nas esperas
+static void service(void) {
+    uint64_t now = raw_ns();
+    service_watchdog(now / 1000);
+    if (!irq_on || in_irq) {
+        return;
+    }
+    in_irq = true;
+
+    service_dma(now);
+    if (dma_irq_pending(false)) raise_irq(DMA_IRQ_0);
+    if (dma_irq_pending(true)) raise_irq(DMA_IRQ_1);
+
+    for (uint i = 0; i < HOST_ALARMS; i++) {
+        if (alarms[i].armed && alarms[i].target_us <= now / 1000) {
+            alarms[i].armed = false;
+            if (alarms[i].callback) alarms[i].callback(i);
+        }
+    }
+    in_irq = false;
+}
+
+// Próximo instante (us) em que algum periférico precisa de serviço
+static uint64_t next_event_us(uint64_t limit) {
+    uint64_t next = limit;
+    for (uint i = 0; i < HOST_ALARMS; i++) {
+        if (alarms[i].armed && alarms[i].target_us < next) next = alarms[i].target_us;
+    }
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        uint dreq = dma[ch].cfg.dreq;
+        if (!dma[ch].busy || dreq < DREQ_PWM_WRAP0 || dreq >= DREQ_PWM_WRAP0 + 8) {
+            continue;
+        }
+        uint slice = dreq - DREQ_PWM_WRAP0;
+        if (!(pwm_regs.en & (1u << slice)) || dma[ch].paced_ns == 0) {
+            continue;
+        }
+        uint64_t end = (dma[ch].paced_ns + dma_regs[ch].transfer_count * pwm_period_ns(slice)) / 1000;
+        if (end < next) next = end;
+    }
+    if (wdt_enabled && wdt_deadline_us < next) next = wdt_deadline_us;
+    return next;
+}
+
+// ===== CONSOLE =====
+// Comando = rajada de entrada até o firmware voltar a esperar sem nada
+// para ler; a latência conta da chegada do primeiro byte
+static uint8_t rx_buf[256];
+static size_t rx_len = 0;
+static size_t rx_pos = 0;
+static bool cmd_active = false;
+static uint64_t cmd_t0_us;
+static bool console_seen = false;
+
+static bool host_connected(void) {
+    struct pollfd p = { .fd = console_fd, .events = 0 };
+    return poll(&p, 1, 0) >= 0 && !(p.revents & POLLHUP);
+}
+
+static bool rx_fill(void) {
+    if (rx_pos < rx_len) {
+        return true;
+    }
+    ssize_t n = read(console_fd, rx_buf, sizeof(rx_buf));
+    if (n <= 0) {
+        return false;       // EAGAIN, ou EIO sem host no pty
+    }
+    rx_pos = 0;
+    rx_len = (size_t)n;
+    unit->stats.bytes_in += (uint64_t)n;
+    if (!cmd_active) {
+        cmd_active = true;
+        cmd_t0_us = raw_ns() / 1000;
+    }
+    return true;
+}
+
+static void cmd_done(void) {
+    uint32_t lat = (uint32_t)(raw_ns() / 1000 - cmd_t0_us);
+    host_unit_stats_t *st = &unit->stats;
+    cmd_active = false;
+    st->commands++;
+    st->lat_sum_us += lat;
+    if (lat > st->lat_max_us) st->lat_max_us = lat;
+    st->lat_hist[host_lat_bucket(lat)]++;
+}
+
+// Dorme até 'limit' (ou o próximo evento), acordando com entrada no pty
+static bool wait_step(uint64_t limit_us, bool wake_on_input) {
+    uint64_t now = raw_ns() / 1000;
+    uint64_t until = next_event_us(limit_us);
+    if (until > now + HOST_IDLE_SLICE_US) until = now + HOST_IDLE_SLICE_US;
+    uint64_t dt = until > now ? until - now : 0;
+    struct timespec ts = { .tv_sec = (time_t)(dt / 1000000), .tv_nsec = (long)(dt % 1000000) * 1000 };
+    bool input = false;
+
+    if (rx_pos >= rx_len) {
+        struct pollfd p = { .fd = console_fd, .events = POLLIN };
+        if (ppoll(&p, 1, &ts, NULL) > 0) {
+            if (p.revents & POLLIN) {
+                input = rx_fill();
+            } else {
+                nanosleep(&ts, NULL);   // sem host no pty: POLLHUP fica ativo
+            }
+        }
+    } else {
+        nanosleep(&ts, NULL);
+    }
+    service();
+    return input && wake_on_input;
+}
+
+static void host_wait_until(uint64_t deadline_us, bool wake_on_input) {
+    fflush(stdout);
+    while (raw_ns() / 1000 < deadline_us) {
+        if (wait_step(deadline_us, wake_on_input)) {
+            return;
+        }
+    }
+    service();
+}
+
+void stdio_init_all(void) {
+}
+
+bool stdio_usb_connected(void) {
+    return host_connected();
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (!console_seen) {
+        console_seen = true;
+        unit->stats.boot_ms = (uint32_t)(raw_ns() / 1000000);
+    }
+    fflush(stdout);
+    service();
+    if (!rx_fill() && timeout_us > 0) {
+        host_wait_until(raw_ns() / 1000 + timeout_us, true);
+    }
+    if (rx_fill()) {
+        return rx_buf[rx_pos++];
+    }
+    if (cmd_active) {
+        cmd_done();
+    }
+    return PICO_ERROR_TIMEOUT;
+}
+
+// Saída do firmware: descarta sem host conectado, como o stdio USB
+static ssize_t console_write(void *cookie, const char *buf, size_t size) {
+    (void)cookie;
+    size_t done = 0;
+
+    if (!host_connected()) {
+        unit->stats.dropped_out += size;
+        return (ssize_t)size;
+    }
+    while (done < size) {
+        ssize_t n = write(console_fd, buf + done, size - done);
+        if (n > 0) {
+            done += (size_t)n;
+            continue;
+        }
+        struct pollfd p = { .fd = console_fd, .events = POLLOUT };
+        if (n < 0 && errno == EAGAIN && poll(&p, 1, HOST_STDOUT_TIMEOUT_MS) > 0 &&
+            (p.revents & POLLOUT)) {
+            continue;
+        }
+        unit->stats.dropped_out += size - done;
+        break;
+    }
+    unit->stats.bytes_out += done;
+    return (ssize_t)size;
+}
+
+// ===== ESPERAS =====
+void sleep_us(uint64_t us) {
+    host_wait_until(raw_ns() / 1000 + us, false);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void busy_wait_us_32(uint32_t us) {
+    host_wait_until(raw_ns() / 1000 + us, false);
+}
+
+void busy_wait_until(absolute_time_t t) {
+    host_wait_until(t, false);
+}
+
+// Laços de espera ativa (ex.: fim do DMA de IR): dorme até o próximo evento
+void tight_loop_contents(void) {
+    wait_step(raw_ns() / 1000 + 1000, false);
+}
+
+// ===== GPIO =====
+#define HOST_GPIOS 30
+
+static bool gpio_out[HOST_GPIOS];
+static bool gpio_level[HOST_GPIOS];
+
+void gpio_init(uint gpio) {
+    gpio_out[gpio] = false;
+    gpio_level[gpio] = false;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    gpio_out[gpio] = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    gpio_level[gpio] = value;
+}
+
+// Entradas com pull-up e nada ligado: botões soltos
+bool gpio_get(uint gpio) {
+    return gpio_out[gpio] ? gpio_level[gpio] : true;
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+// ===== I2C =====
+// O display sempre responde; a escrita leva o tempo do barramento
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    return i2c_set_baudrate(i2c, baudrate);
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len,
+                         bool nostop, uint timeout_us) {
+    (void)addr;
+    (void)src;
+    (void)nostop;
+    (void)timeout_us;
+    // 9 bits por byte, mais o byte de endereço
+    busy_wait_us_32((uint32_t)((uint64_t)(len + 1) * 9 * 1000000 / i2c->baudrate));
+    return (int)len;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    return i2c_write_timeout_us(i2c, addr, src, len, nostop, 0);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len,
+                        bool nostop, uint timeout_us) {
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+    (void)timeout_us;
+    memset(dst, 0, len);
+    return (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    return i2c_read_timeout_us(i2c, addr, dst, len, nostop, 0);
+}
+
+// ===== FLASH =====
+// NOR: apagar leva a 0xFF, programar só derruba bits
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    memset(host_flash + flash_offs, 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+}
+
+// ===== HISTOGRAMA =====
+uint32_t host_lat_bucket(uint32_t us) {
+    if (us < (2u << HOST_LAT_SUB_BITS)) {
+        return us;
+    }
+    uint32_t octave = 31u - (uint32_t)__builtin_clz(us);
+    uint32_t sub = (us >> (octave - HOST_LAT_SUB_BITS)) & ((1u << HOST_LAT_SUB_BITS) - 1);
+    uint32_t idx = ((octave - HOST_LAT_SUB_BITS + 1) << HOST_LAT_SUB_BITS) + sub;
+    return idx < HOST_LAT_BUCKETS ? idx : HOST_LAT_BUCKETS - 1;
+}
+
+uint32_t host_lat_bucket_max(uint32_t bucket) {
+    if (bucket < (2u << HOST_LAT_SUB_BITS)) {
+        return bucket;
+    }
+    uint32_t octave = (bucket >> HOST_LAT_SUB_BITS) + HOST_LAT_SUB_BITS - 1;
+    uint32_t sub = bucket & ((1u << HOST_LAT_SUB_BITS) - 1);
+    uint32_t shift = octave - HOST_LAT_SUB_BITS;
+    return (((1u << HOST_LAT_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+int16_t host_temp_c10(void) {
+    return unit->temp_c10;
+}
+
+// ===== ENTRADA DO PROCESSO DA INSTÂNCIA =====
+void host_hal_run(host_unit_t *u, uint8_t *flash, int fd) {
+    unit = u;
+    host_flash = flash;
+    console_fd = fd;
+    watchdog_hw = &u->wdt;
+    boot_ns = 0;
+    boot_ns = raw_ns();
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    cookie_io_functions_t io = { .write = console_write };
+    stdout = fopencookie(NULL, "w", io);
+    setvbuf(stdout, NULL, _IOFBF, 4096);
+
+    firmware_main();
+    fflush(stdout);
+    _exit(0);
+}
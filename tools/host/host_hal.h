@@ -0,0 +1,74 @@
+/**
+ * host_hal.h
+ * Ligação entre o HAL do host (host_hal.c) e o simulador de frota
+ *
+ * Cada controlador simulado é um processo filho rodando o firmware
+ * inteiro; o estado que sobrevive a um reset (registradores do watchdog,
+ * flash e estatísticas) fica em memória compartilhada com o pai.
+ */
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "host_sdk.h"
+
+// Código de saída do filho quando o watchdog expira (o pai reinicia)
+#define HOST_EXIT_WDT          86
+
+// Histograma de latência: 8 faixas por oitava de microssegundos
+#define HOST_LAT_SUB_BITS      3
+#define HOST_LAT_BUCKETS       (24 << HOST_LAT_SUB_BITS)
+
+typedef struct {
+    volatile uint32_t boots;            // processos iniciados
+    volatile uint32_t wdt_resets;       // saídas por watchdog
+    volatile uint32_t crashes;          // saídas por sinal ou código inesperado
+    volatile uint32_t boot_ms;          // do início até a primeira leitura do console
+    volatile uint64_t commands;         // rajadas de entrada atendidas
+    volatile uint64_t bytes_in;
+    volatile uint64_t bytes_out;
+    volatile uint64_t dropped_out;      // saída descartada sem host conectado
+    volatile uint64_t ir_frames;        // transferências de DMA de IR concluídas
+    volatile uint64_t lat_sum_us;
+    volatile uint32_t lat_max_us;
+    volatile uint32_t lat_hist[HOST_LAT_BUCKETS];
+} host_unit_stats_t;
+
+typedef struct {
+    volatile pid_t pid;
+    watchdog_hw_t wdt;                  // scratch e reason sobrevivem ao reset
+    volatile int16_t temp_c10;          // temperatura do chip simulada (décimos de grau)
+    host_unit_stats_t stats;
+} host_unit_t;
+
+/**
+ * Faixa do histograma para uma latência
+ * @param us Latência em microssegundos
+ * @return Índice em lat_hist
+ */
+uint32_t host_lat_bucket(uint32_t us);
+
+/**
+ * Maior latência representada por uma faixa
+ * @param bucket Índice em lat_hist
+ * @return Limite superior da faixa em microssegundos
+ */
+uint32_t host_lat_bucket_max(uint32_t bucket);
+
+/**
+ * Temperatura do chip da instância atual (host_power.c)
+ * @return Décimos de grau
+ */
+int16_t host_temp_c10(void);
+
+/**
+ * Roda o firmware no processo atual (não retorna)
+ * @param unit Estado compartilhado da instância
+ * @param flash Área de PICO_FLASH_SIZE_BYTES da instância
+ * @param console_fd Lado mestre do pty (console USB do firmware)
+ */
+void host_hal_run(host_unit_t *unit, uint8_t *flash, int console_fd) __attribute__((noreturn));
+
+#endif // HOST_HAL_H
@@ -0,0 +1,34 @@
+/**
+ * Monitor de VSYS virtual do simulador de frota
+ * Alimentação estável: um bloco por ms, sem quedas (o tratador nunca roda);
+ * temperatura fixa por instância (fleet_sim -t)
+ */
+
+#include "pico/stdlib.h"
+#include "lib/power_monitor.h"
+#include "host_hal.h"
+
+#define HOST_VSYS_MV 5000
+
+static uint64_t pm_start_us;
+static bool pm_running = false;
+
+bool power_monitor_init(power_fail_handler_t handler) {
+    (void)handler;
+    pm_start_us = time_us_64();
+    pm_running = true;
+    return true;
+}
+
+bool power_monitor_flash_ok(void) {
+    return true;
+}
+
+void power_monitor_get_stats(power_monitor_stats_t *stats) {
+    stats->vsys_mv = pm_running ? HOST_VSYS_MV : 0;
+    stats->min_mv = stats->vsys_mv;
+    stats->blocks = pm_running ? (uint32_t)((time_us_64() - pm_start_us) / 1000) : 0;
+    stats->triggers = 0;
+    stats->temp_c10 = host_temp_c10();
+    stats->armed = pm_running;
+}
@@ -0,0 +1,242 @@
+/**
+ * host_sdk.h
+ * Subconjunto do Pico SDK usado pelo firmware, implementado no host
+ * (host_hal.c) para o simulador de frota
+ *
+ * Os cabeçalhos em include/pico e include/hardware só incluem este
+ * arquivo. Registradores (watchdog, PWM, canais de DMA) são estruturas
+ * em memória; os "periféricos" avançam nos pontos de serviço do HAL
+ * (leituras de tempo, esperas e console), que fazem o papel das IRQs.
+ */
+
+#ifndef HOST_SDK_H
+#define HOST_SDK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_RP2040 1
+#define PICO_ERROR_TIMEOUT (-1)
+#define PICO_ERROR_GENERIC (-2)
+#define PICO_FLASH_SIZE_BYTES (2u * 1024u * 1024u)
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+// Cada boot é um processo novo: a RAM "não inicializada" começa zerada
+#define __uninitialized_ram(group) group
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define __compiler_memory_barrier() __asm__ volatile ("" ::: "memory")
+static inline void __dmb(void) { __compiler_memory_barrier(); }
+
+// ===== TEMPO =====
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t)ms * 1000; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us_32(uint32_t us);
+void busy_wait_until(absolute_time_t t);
+void tight_loop_contents(void);
+
+// ===== CONSOLE (pty da instância) =====
+void stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+bool stdio_usb_connected(void);
+
+// ===== GPIO =====
+#define GPIO_OUT 1
+#define GPIO_IN  0
+enum gpio_function { GPIO_FUNC_I2C = 3, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5 };
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+
+// ===== I2C (display virtual: toda escrita recebe ACK) =====
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t *const i2c0;
+extern i2c_inst_t *const i2c1;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len,
+                         bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len,
+                        bool nostop, uint timeout_us);
+
+// ===== WATCHDOG =====
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t load;
+    volatile uint32_t reason;
+    volatile uint32_t scratch[8];
+    volatile uint32_t tick;
+} watchdog_hw_t;
+extern watchdog_hw_t *watchdog_hw;
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update(void);
+bool watchdog_caused_reboot(void);
+uint32_t watchdog_get_time_remaining_ms(void);
+
+// ===== SYNC / IRQ =====
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask);
+void hw_clear_bits(volatile uint32_t *addr, uint32_t mask);
+
+typedef void (*irq_handler_t)(void);
+enum irq_num { TIMER_IRQ_0 = 0, DMA_IRQ_0 = 11, DMA_IRQ_1 = 12, ADC_IRQ_FIFO = 22 };
+#define PICO_HIGHEST_IRQ_PRIORITY 0
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+#define PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY 0xff
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_enabled(uint num, bool enabled);
+void irq_set_priority(uint num, uint8_t priority);
+
+// ===== ALARMES DO TIMER =====
+typedef void (*hardware_alarm_callback_t)(uint alarm_num);
+
+int hardware_alarm_claim_unused(bool required);
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback);
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t);
+void hardware_alarm_cancel(uint alarm_num);
+
+// ===== PWM (125 MHz, só o necessário para o ritmo do DMA) =====
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t div;      // 8.4 ponto fixo
+    volatile uint32_t ctr;
+    volatile uint32_t cc;
+    volatile uint32_t top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[8];
+    volatile uint32_t en;
+    volatile uint32_t intr;
+    volatile uint32_t inte;
+    volatile uint32_t intf;
+    volatile uint32_t ints;
+} pwm_hw_t;
+extern pwm_hw_t *const pwm_hw;
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7u; }
+static inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1u; }
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_clkdiv(pwm_config *c, float div);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_counter(uint slice_num, uint16_t c);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+// ===== DMA =====
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+#define DREQ_PWM_WRAP0 24
+#define DREQ_ADC       36
+#define DREQ_FORCE     63
+#define NUM_DMA_CHANNELS 12
+
+typedef struct {
+    uint8_t size;
+    uint8_t dreq;
+    uint8_t chain_to;
+    bool read_incr;
+    bool write_incr;
+    bool sniff;
+    bool irq_quiet;
+    bool ring_write;
+    uint8_t ring_bits;          // 0 = sem anel
+} dma_channel_config;
+
+// Endereços com a largura do host (o firmware compara ponteiros com
+// read_addr). Do alias 3 só a contagem e o endereço de leitura com disparo,
+// alinhados como um bloco de controle {uint32_t, ponteiro}
+typedef struct {
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+    volatile uint32_t al3_transfer_count __attribute__((aligned(2 * sizeof(void *))));
+    volatile uintptr_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_sniff_enable(dma_channel_config *c, bool sniff);
+void channel_config_set_irq_quiet(dma_channel_config *c, bool quiet);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+dma_channel_hw_t *dma_channel_hw_addr(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+void dma_sniffer_enable(uint channel, uint mode, bool force_channel_enable);
+void dma_sniffer_disable(void);
+void dma_sniffer_set_data_accumulator(uint32_t seed);
+uint32_t dma_sniffer_get_data_accumulator(void);
+
+// ===== FLASH (arquivo da instância, sobrevive a resets) =====
+#define FLASH_PAGE_SIZE   256u
+#define FLASH_SECTOR_SIZE 4096u
+
+extern uint8_t *host_flash;
+#define XIP_BASE ((uintptr_t)host_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+// Imagem "gravada": o .text do próprio simulador (definido no link)
+extern char __flash_binary_start, __flash_binary_end;
+
+#endif // HOST_SDK_H
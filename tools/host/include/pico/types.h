@@ -0,0 +1,5 @@
+// Pico SDK no host: tudo vem de host_sdk.h
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+#include "host_sdk.h"
+#endif
@@ -0,0 +1,248 @@
+/**
+ * Benchmark do codec de quadros RAW (lib/ir_codec) sobre o corpus de capturas
+ *
+ * Para cada quadro: timings, bytes RAW (uint16_t) vs. comprimidos, taxa,
+ * níveis, erro máximo de quantização e verificação de ida e volta. No
+ * fim, a vazão do decodificador em streaming (o mesmo caminho que o
+ * transmissor usa, um timing por chamada) e do codificador.
+ *
+ * Corpus: arquivos C com tabelas "nome[] = { ... };" (o padrão são as
+ * tabelas gravadas em lib/custom_ir.c) ou texto com um quadro por linha,
+ * "nome: t0, t1, t2, ...".
+ *
+ * Uso: ir_codec_bench [-t ms] [arquivo ...]
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lib/ir_codec.h"
+
+#define BENCH_MAX_FRAMES    256
+#define BENCH_MAX_TIMINGS   2048
+
+typedef struct {
+    char name[48];
+    uint16_t timings[BENCH_MAX_TIMINGS];
+    size_t count;
+    uint8_t *blob;
+    size_t size;
+} bench_frame_t;
+
+static bench_frame_t frames[BENCH_MAX_FRAMES];
+static int frame_count = 0;
+static volatile uint32_t sink;      // impede o compilador de descartar o laço
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// ===== CORPUS =====
+
+static bench_frame_t *new_frame(const char *start, size_t len) {
+    if (frame_count == BENCH_MAX_FRAMES) {
+        fprintf(stderr, "ir_codec_bench: mais de %d quadros, resto ignorado\n", BENCH_MAX_FRAMES);
+        return NULL;
+    }
+    bench_frame_t *f = &frames[frame_count++];
+    if (len >= sizeof(f->name)) {
+        len = sizeof(f->name) - 1;
+    }
+    memcpy(f->name, start, len);
+    f->name[len] = '\0';
+    f->count = 0;
+    return f;
+}
+
+// Acrescenta os números de 'text' ao quadro
+static void add_numbers(bench_frame_t *f, const char *text) {
+    while (*text) {
+        if (isdigit((unsigned char)*text)) {
+            long v = strtol(text, (char **)&text, 10);
+            if (f->count < BENCH_MAX_TIMINGS && v > 0 && v <= UINT16_MAX) {
+                f->timings[f->count++] = (uint16_t)v;
+            }
+        } else {
+            text++;
+        }
+    }
+}
+
+// Nome antes de '[' (tabela C) ou de ':' (linha de texto)
+static const char *name_before(const char *line, const char *end, size_t *len) {
+    const char *p = end;
+    while (p > line && isspace((unsigned char)p[-1])) p--;
+    const char *stop = p;
+    while (p > line && (isalnum((unsigned char)p[-1]) || p[-1] == '_')) p--;
+    *len = (size_t)(stop - p);
+    return *len ? p : NULL;
+}
+
+static bool load_corpus(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+
+    char line[1024];
+    bench_frame_t *open = NULL;    // tabela C ainda sem '}'
+    while (fgets(line, sizeof(line), fp)) {
+        char *comment = strstr(line, "//");
+        if (comment) *comment = '\0';
+
+        if (open) {
+            char *close = strchr(line, '}');
+            if (close) *close = '\0';
+            add_numbers(open, line);
+            if (close) open = NULL;
+            continue;
+        }
+
+        char *bracket = strstr(line, "[] = {");
+        char *colon = strchr(line, ':');
+        size_t len;
+        const char *name;
+        if (bracket && (name = name_before(line, bracket, &len))) {
+            open = new_frame(name, len);
+            if (!open) break;
+            char *body = bracket + 6;
+            char *close = strchr(body, '}');
+            if (close) *close = '\0';
+            add_numbers(open, body);
+            if (close) open = NULL;
+        } else if (colon && (name = name_before(line, colon, &len)) && name == line) {
+            bench_frame_t *f = new_frame(name, len);
+            if (!f) break;
+            add_numbers(f, colon + 1);
+        }
+    }
+    fclose(fp);
+
+    // Descarta o que não parece quadro (ex.: tabelas de outros tipos)
+    int kept = 0;
+    for (int i = 0; i < frame_count; i++) {
+        if (frames[i].count >= 4) {
+            if (kept != i) frames[kept] = frames[i];
+            kept++;
+        }
+    }
+    frame_count = kept;
+    return true;
+}
+
+// ===== BENCHMARK =====
+
+// Repete 'run' até passar 'ms'; devolve timings por segundo
+static double throughput(void (*run)(bench_frame_t *), uint32_t ms) {
+    uint64_t timings = 0;
+    double start = now_s(), elapsed;
+    do {
+        for (int i = 0; i < frame_count; i++) {
+            if (frames[i].blob) {
+                run(&frames[i]);
+                timings += frames[i].count;
+            }
+        }
+        elapsed = now_s() - start;
+    } while (elapsed * 1000.0 < ms);
+    return (double)timings / elapsed;
+}
+
+static void run_stream(bench_frame_t *f) {
+    ir_codec_decoder_t dec;
+    ir_codec_decoder_init(&dec, f->blob, f->size);
+    ir_timing_source_t *src = &dec.source;
+    src->rewind(src);
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < src->length; i++) {
+        sum += src->next(src);
+    }
+    sink += sum;
+}
+
+static void run_encode(bench_frame_t *f) {
+    static uint8_t out[4096];
+    sink += (uint32_t)ir_codec_encode(f->timings, f->count, out, sizeof(out), NULL);
+}
+
+int main(int argc, char **argv) {
+    uint32_t ms = 500;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:h")) != -1) {
+        switch (opt) {
+            case 't': ms = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-t ms] [arquivo ...]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind == argc) {
+        if (!load_corpus(IR_CODEC_BENCH_CORPUS)) return 1;
+    }
+    for (int i = optind; i < argc; i++) {
+        if (!load_corpus(argv[i])) return 1;
+    }
+    if (frame_count == 0) {
+        fprintf(stderr, "ir_codec_bench: nenhum quadro no corpus\n");
+        return 1;
+    }
+
+    printf("%-16s %6s %6s %6s %6s %4s %6s %8s %s\n",
+           "quadro", "tim", "raw", "cod", "taxa", "sim", "niveis", "erro", "ida/volta");
+    size_t raw_total = 0, coded_total = 0, skipped = 0;
+    int failures = 0;
+    for (int i = 0; i < frame_count; i++) {
+        bench_frame_t *f = &frames[i];
+        ir_codec_info_t info;
+        size_t max = ir_codec_max_size(f->count);
+        uint8_t *blob = malloc(max);
+        size_t raw = f->count * sizeof(uint16_t);
+        f->size = ir_codec_encode(f->timings, f->count, blob, max, &info);
+        if (f->size == 0) {
+            free(blob);
+            printf("%-16s %6zu %6zu %6s  niveis demais para o codec (fica RAW)\n",
+                   f->name, f->count, raw, "-");
+            skipped++;
+            continue;
+        }
+        f->blob = blob;
+
+        // Ida e volta: cada timing dentro do erro de quantização relatado
+        uint16_t decoded[BENCH_MAX_TIMINGS];
+        size_t n = ir_codec_decode(f->blob, f->size, decoded, BENCH_MAX_TIMINGS);
+        bool ok = (n == f->count);
+        for (size_t k = 0; ok && k < n; k++) {
+            int diff = abs((int)decoded[k] - (int)f->timings[k]);
+            ok = (diff <= info.max_error_us);
+        }
+        failures += !ok;
+
+        printf("%-16s %6zu %6zu %6zu %5.1fx %4u %3u/%-2u %4uus/%u%% %s\n",
+               f->name, f->count, raw, f->size, (double)raw / (double)f->size,
+               info.symbols, info.mark_levels, info.space_levels,
+               info.max_error_us, info.max_error_pct, ok ? "ok" : "FALHOU");
+        raw_total += raw;
+        coded_total += f->size;
+    }
+
+    if (coded_total) {
+        printf("%-16s %6s %6zu %6zu %5.1fx\n", "total", "", raw_total, coded_total,
+               (double)raw_total / (double)coded_total);
+        double dec_rate = throughput(run_stream, ms);
+        double enc_rate = throughput(run_encode, ms);
+        printf("decodificacao (streaming): %.1f Mtimings/s\n", dec_rate / 1e6);
+        printf("codificacao:               %.1f Mtimings/s\n", enc_rate / 1e6);
+    }
+    if (skipped) {
+        printf("%zu quadro(s) sem compressao\n", skipped);
+    }
+    return failures ? 1 : 0;
+}
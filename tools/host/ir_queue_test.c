@@ -0,0 +1,250 @@
+/**
+ * Teste da fila IR nos dois backends. No de bordas (um alarme para todos
+ * os emissores), quadros de emergência não podem se perder quando outro
+ * emissor está no ar; nos dois, o quadro sai inteiro e uma rajada do
+ * usuário na fila é cortada pela emergência
+ *
+ *   cmake --build build-host && ctest --test-dir build-host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "lib/custom_ir.h"
+#include "lib/ir_queue.h"
+#include "host_hal.h"
+
+#define TEST_IR_PIN     16      // slice 0
+#define TEST_IR_PIN_2   18      // slice 1
+#define TEST_WAIT_MS    1000
+
+// Quadros sintéticos: 20 ms (fundo/usuário) e 4 ms (emergência)
+static uint16_t long_frame[20];
+static uint16_t off_frame[8];
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "FALHOU %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static ir_queue_item_t item(uint8_t emitter, ir_prio_t prio, const uint16_t *signal, size_t length) {
+    return (ir_queue_item_t){ .emitter = emitter, .prio = prio, .signal = signal, .length = length };
+}
+
+// Roda o poll até a fila esvaziar
+static bool drain(void) {
+    absolute_time_t deadline = make_timeout_time_ms(TEST_WAIT_MS);
+    while (!ir_queue_idle()) {
+        if (time_reached(deadline)) {
+            return false;
+        }
+        ir_queue_poll();
+    }
+    return true;
+}
+
+#if IR_BACKEND_EDGE
+// Emergência num emissor livre enquanto outro transmite um quadro de fundo
+static void test_emergency_cuts_other_emitter(void) {
+    ir_queue_init();
+    ir_queue_item_t bg = item(1, IR_PRIO_BACKGROUND, long_frame, 20);
+    ir_queue_item_t off = item(0, IR_PRIO_EMERGENCY, off_frame, 8);
+
+    CHECK(ir_queue_submit(&bg));
+    CHECK(custom_ir_busy(1));
+    uint64_t t_req = time_us_64();
+    CHECK(ir_queue_submit(&off));
+    CHECK(custom_ir_busy(0));           // saiu na hora, sem esperar os 20 ms
+    CHECK(!custom_ir_busy(1));
+    CHECK(drain());
+    CHECK(custom_ir_started_at(0) >= t_req);
+
+    ir_queue_stats_t st;
+    ir_queue_get_stats(&st);
+    CHECK(st.preempted == 1);
+    CHECK(st.sent == 1);
+    CHECK(st.dropped == 0);
+    // Tempo no ar medido: o quadro cortado conta só o que saiu
+    CHECK(st.airtime_us[IR_PRIO_BACKGROUND] < 20000);
+    CHECK(st.airtime_us[IR_PRIO_EMERGENCY] > 3900 && st.airtime_us[IR_PRIO_EMERGENCY] < 4500);
+}
+
+// emergency_off() com os dois emissores ocupados: um quadro do usuário no
+// ar no emissor 0 e outro esperando o emissor 1
+static void test_emergency_off_two_busy_emitters(void) {
+    ir_queue_init();
+    ir_queue_item_t user0 = item(0, IR_PRIO_USER, long_frame, 20);
+    ir_queue_item_t user1 = item(1, IR_PRIO_USER, long_frame, 20);
+    ir_queue_item_t off0 = item(0, IR_PRIO_EMERGENCY, off_frame, 8);
+    ir_queue_item_t off1 = item(1, IR_PRIO_EMERGENCY, off_frame, 8);
+
+    CHECK(ir_queue_submit(&user0));
+    CHECK(ir_queue_submit(&user1));     // backend de bordas: espera o emissor 0
+    CHECK(custom_ir_busy(0));
+    CHECK(!custom_ir_busy(1));
+
+    ir_tx_stats_t tx0;
+    custom_ir_get_tx_stats(&tx0);
+    uint64_t t_req = time_us_64();
+    CHECK(ir_queue_submit(&off0));      // corta o quadro do usuário
+    CHECK(ir_queue_submit(&off1));      // emissor 0 no ar: fica na fila
+    ir_queue_flush(IR_PRIO_USER);       // como em emergency_off()
+    CHECK(drain());
+
+    ir_tx_stats_t tx1;
+    custom_ir_get_tx_stats(&tx1);
+    CHECK(tx1.started - tx0.started == 2);      // os dois OFF, nada mais
+    CHECK(custom_ir_started_at(0) >= t_req);
+    CHECK(custom_ir_started_at(1) > custom_ir_started_at(0));
+
+    ir_queue_stats_t st;
+    ir_queue_get_stats(&st);
+    CHECK(st.preempted == 1);
+    CHECK(st.sent == 2);
+    CHECK(st.dropped == 1);             // só o user1 descartado pelo flush
+}
+#endif
+
+// Rajada do usuário (3 repetições) pela fila: o pedido volta na hora, a
+// repetição espera a pausa e a emergência corta a que está no ar e
+// descarta a que falta
+static void test_user_burst_preempted_by_emergency(void) {
+    ir_queue_init();
+    ir_queue_item_t burst = item(0, IR_PRIO_USER, long_frame, 20);
+    burst.repeat = 3;
+    burst.gap_ms = 10;
+    ir_queue_item_t off = item(0, IR_PRIO_EMERGENCY, off_frame, 8);
+
+    uint64_t t_sub = time_us_64();
+    CHECK(ir_queue_submit(&burst));
+    CHECK(time_us_64() - t_sub < 1000);     // não espera os 3 x 20 ms
+    CHECK(custom_ir_busy(0));
+
+    // Primeira repetição termina; a segunda só começa depois da pausa
+    ir_queue_stats_t st;
+    absolute_time_t deadline = make_timeout_time_ms(TEST_WAIT_MS);
+    do {
+        ir_queue_poll();
+        ir_queue_get_stats(&st);
+    } while (st.sent < 1 && !time_reached(deadline));
+    uint64_t first_end = custom_ir_finished_at(0);
+    while (custom_ir_started_at(0) < first_end && !time_reached(deadline)) {
+        ir_queue_poll();
+    }
+    CHECK(custom_ir_started_at(0) >= first_end + 10000);
+    CHECK(!ir_queue_idle());
+
+    uint64_t t_req = time_us_64();
+    CHECK(ir_queue_submit(&off));
+    CHECK(drain());
+    CHECK(custom_ir_started_at(0) >= t_req);
+
+    ir_queue_get_stats(&st);
+    CHECK(st.preempted == 1);
+    CHECK(st.sent == 2);                    // primeira repetição + OFF
+    CHECK(st.dropped == 0);
+    CHECK(st.airtime_us[IR_PRIO_USER] > 19000 && st.airtime_us[IR_PRIO_USER] < 40000);
+    CHECK(st.airtime_us[IR_PRIO_EMERGENCY] > 3900 && st.airtime_us[IR_PRIO_EMERGENCY] < 4500);
+}
+
+// Quadro da biblioteca (227 timings, ~116 ms, ~4300 ciclos de portadora)
+// sai inteiro nos dois backends; a segunda vez vem da cache
+static void test_full_library_frame(void) {
+    const uint16_t *timings;
+    size_t length;
+    CHECK(custom_ir_get_command(IR_CMD_OFF, &timings, &length, NULL));
+    uint32_t full_us = ir_signal_duration_us(timings, length);
+
+    for (int pass = 0; pass < 2; pass++) {
+        ir_queue_init();
+        ir_queue_item_t off = item(0, IR_PRIO_USER, timings, length);
+        off.key = IR_CMD_CACHE_KEY(IR_CMD_OFF);
+        CHECK(ir_queue_submit(&off));
+        CHECK(drain());
+
+        // Quantizado em ciclos: perde menos de um ciclo (26 us) por timing
+        ir_queue_stats_t st;
+        ir_queue_get_stats(&st);
+        CHECK(st.sent == 1);
+        CHECK(st.airtime_us[IR_PRIO_USER] > full_us - length * 26);
+        CHECK(st.airtime_us[IR_PRIO_USER] < full_us + 1000);
+    }
+
+    ir_interval_t marks[IR_MAX_FRAME_TIMINGS / 2 + 1];
+    CHECK(custom_ir_mark_intervals(0, timings, length, marks, IR_MAX_FRAME_TIMINGS / 2 + 1) ==
+          (length + 1) / 2);
+#if !IR_BACKEND_EDGE
+    ir_wave_cache_stats_t cache;
+    custom_ir_cache_get_stats(&cache);
+    CHECK(cache.hits >= 1);
+
+    // Maior que os blocos do emissor: recusado, não cortado
+    static uint16_t too_long[IR_MAX_FRAME_TIMINGS + 1];
+    for (size_t i = 0; i < IR_MAX_FRAME_TIMINGS + 1; i++) too_long[i] = 500;
+    CHECK(!custom_ir_arm(0, 0, too_long, IR_MAX_FRAME_TIMINGS + 1, get_absolute_time()));
+    CHECK(!custom_ir_busy(0));
+#endif
+}
+
+#if !IR_BACKEND_EDGE
+// Todos os comandos nos dois emissores, com portadoras diferentes (entradas
+// separadas): a segunda rodada sai inteira da cache, sem remoções
+static void test_cache_holds_every_state(void) {
+    custom_ir_cache_flush();
+    CHECK(custom_ir_set_emitter_carrier(1, 40000));
+    ir_wave_cache_stats_t before, after;
+    custom_ir_cache_get_stats(&before);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint8_t e = 0; e < 2; e++) {
+            for (int id = 0; id < IR_CMD_COUNT; id++) {
+                CHECK(send_ir_command_on(e, (ir_command_id_t)id));
+            }
+        }
+    }
+    custom_ir_cache_get_stats(&after);
+    CHECK(after.entries == 2 * IR_CMD_COUNT);
+    CHECK(after.misses - before.misses == 2 * IR_CMD_COUNT);
+    CHECK(after.hits - before.hits == 2 * IR_CMD_COUNT);
+    CHECK(after.evictions == before.evictions);
+    CHECK(custom_ir_set_emitter_carrier(1, IR_CARRIER_FREQ));
+}
+#endif
+
+// Entrada do "firmware" sob o HAL do host
+int firmware_main(void) {
+    for (size_t i = 0; i < 20; i++) long_frame[i] = 1000;
+    for (size_t i = 0; i < 8; i++) off_frame[i] = 500;
+
+    if (!custom_ir_init(TEST_IR_PIN) || custom_ir_add_emitter(TEST_IR_PIN_2) != 1) {
+        fprintf(stderr, "ir_queue_test: falha ao iniciar o IR\n");
+        exit(1);
+    }
+#if IR_BACKEND_EDGE
+    test_emergency_cuts_other_emitter();
+    test_emergency_off_two_busy_emitters();
+#endif
+    test_user_burst_preempted_by_emergency();
+    test_full_library_frame();
+#if !IR_BACKEND_EDGE
+    test_cache_holds_every_state();
+#endif
+
+    fprintf(stderr, "ir_queue_test: %s\n", failures ? "FALHOU" : "ok");
+    exit(failures ? 1 : 0);
+}
+
+int main(void) {
+    // O stdout do processo vira o console do firmware (descartado)
+    int console = open("/dev/null", O_RDWR);
+    static host_unit_t unit;
+    uint8_t *flash = malloc(PICO_FLASH_SIZE_BYTES);
+    memset(flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+    host_hal_run(&unit, flash, console);
+}
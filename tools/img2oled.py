@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+"""
+Converte imagens PNG em bitmaps RLE no formato de página do SSD1306.
+
+Cada PNG vira um oled_asset_t (lib/oled_asset.h). Pixel claro (luminância
+>= 128) acende, escuro apaga; alfa < 128 é transparente (não altera o que
+já está no buffer). Cada byte é uma coluna de uma página (8 linhas, bit 0 =
+linha de cima), como no ram_buffer; a sequência percorre página a página e,
+dentro da página, coluna a coluna, para que traços horizontais virem
+repetições longas.
+
+RLE (dados e máscara codificados separadamente):
+  ctrl 0x00-0x7F: (ctrl + 1) bytes literais em seguida
+  ctrl 0x80-0xFF: próximo byte repetido (ctrl & 0x7F) + 1 vezes
+
+O nome do asset vem do arquivo: assets/oled/digit_2.png -> asset_digit_2.
+Sem dependências externas: o leitor de PNG usa só zlib (sem entrelaçamento).
+
+Uso: img2oled.py --out <diretório> imagem.png [imagem.png ...]
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def fail(msg):
+    sys.exit(f"img2oled: {msg}")
+
+
+# ============================================================================
+# LEITOR DE PNG
+# ============================================================================
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, width, height, bpp, stride):
+    out = bytearray(height * stride)
+    prev = bytearray(stride)
+    pos = 0
+    for y in range(height):
+        ftype = raw[pos]
+        line = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                line[i] = (line[i] + paeth(a, b, c)) & 0xFF
+            elif ftype != 0:
+                fail(f"filtro PNG {ftype} invalido")
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+    return out
+
+
+def read_png(path):
+    """Retorna (largura, altura, pixels) com pixels[y][x] = (aceso, opaco)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(PNG_SIGNATURE):
+        fail(f"{path}: nao e PNG")
+
+    pos = len(PNG_SIGNATURE)
+    idat = b""
+    palette = []
+    trns = b""
+    while pos < len(data):
+        length, ctype = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif ctype == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif ctype == b"tRNS":
+            trns = body
+        elif ctype == b"IDAT":
+            idat += body
+        elif ctype == b"IEND":
+            break
+
+    if color not in CHANNELS:
+        fail(f"{path}: tipo de cor {color} nao suportado")
+    if interlace:
+        fail(f"{path}: PNG entrelacado nao suportado")
+    if depth != 8 and color not in (0, 3):
+        fail(f"{path}: profundidade {depth} so e suportada em cinza/paleta")
+
+    bits = CHANNELS[color] * depth
+    stride = (width * bits + 7) // 8
+    rows = unfilter(zlib.decompress(idat), width, height, max(1, bits // 8), stride)
+
+    pixels = []
+    for y in range(height):
+        row = rows[y * stride:(y + 1) * stride]
+        out = []
+        for x in range(width):
+            if depth == 8:
+                px = row[x * CHANNELS[color]:(x + 1) * CHANNELS[color]]
+            else:
+                shift = 8 - depth - (x * depth) % 8
+                px = [(row[x * depth // 8] >> shift) & ((1 << depth) - 1)]
+
+            alpha = 255
+            if color == 3:
+                idx = px[0]
+                r, g, b = palette[idx]
+                if idx < len(trns):
+                    alpha = trns[idx]
+            elif color == 0:
+                r = g = b = px[0] * 255 // ((1 << depth) - 1)
+            elif color == 4:
+                r = g = b = px[0]
+                alpha = px[1]
+            else:
+                r, g, b = px[0], px[1], px[2]
+                if color == 6:
+                    alpha = px[3]
+
+            lum = (r * 299 + g * 587 + b * 114) // 1000
+            out.append((lum >= 128, alpha >= 128))
+        pixels.append(out)
+    return width, height, pixels
+
+
+# ============================================================================
+# FORMATO DE PÁGINA + RLE
+# ============================================================================
+
+def to_pages(width, height, pixels):
+    """Bytes de dados e de máscara, página a página."""
+    pages = (height + 7) // 8
+    data = bytearray()
+    mask = bytearray()
+    for p in range(pages):
+        for x in range(width):
+            d = m = 0
+            for bit in range(8):
+                y = p * 8 + bit
+                if y >= height:
+                    continue
+                on, opaque = pixels[y][x]
+                if opaque:
+                    m |= 1 << bit
+                    if on:
+                        d |= 1 << bit
+            data.append(d)
+            mask.append(m)
+    return data, mask
+
+
+def rle_encode(buf):
+    out = bytearray()
+    i = 0
+    literal = bytearray()
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+            del literal[:128]
+
+    while i < len(buf):
+        run = 1
+        while i + run < len(buf) and buf[i + run] == buf[i] and run < 128:
+            run += 1
+        if run >= 3:
+            flush_literal()
+            out.append(0x80 | (run - 1))
+            out.append(buf[i])
+            i += run
+        else:
+            literal.extend(buf[i:i + run])
+            i += run
+    flush_literal()
+    return out
+
+
+def rle_decode(buf, size):
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        ctrl = buf[i]
+        if ctrl & 0x80:
+            out.extend([buf[i + 1]] * ((ctrl & 0x7F) + 1))
+            i += 2
+        else:
+            out.extend(buf[i + 1:i + 2 + ctrl])
+            i += 1 + ctrl + 1
+    return out
+
+
+def c_bytes(buf, indent="    "):
+    lines = []
+    for i in range(0, len(buf), 16):
+        lines.append(indent + ", ".join(f"0x{b:02X}" for b in buf[i:i + 16]) + ",")
+    return lines
+
+
+def asset_name(path):
+    base = os.path.splitext(os.path.basename(path))[0].lower()
+    name = re.sub(r"[^a-z0-9_]", "_", base)
+    return f"asset_{name}"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("--out", required=True)
+    ap.add_argument("images", nargs="+")
+    args = ap.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    header = [
+        "// Gerado por tools/img2oled.py - não editar",
+        "#ifndef ASSETS_H",
+        "#define ASSETS_H",
+        "",
+        '#include "lib/oled_asset.h"',
+        "",
+    ]
+    source = [
+        "// Gerado por tools/img2oled.py - não editar",
+        '#include "assets.h"',
+        "",
+    ]
+    raw_total = packed_total = 0
+
+    for path in sorted(args.images):
+        width, height, pixels = read_png(path)
+        if width > 128 or height > 64:
+            fail(f"{path}: {width}x{height} maior que o display")
+        data, mask = to_pages(width, height, pixels)
+        # Sem pixels transparentes a máscara é implícita (só as linhas válidas)
+        _, full = to_pages(width, height, [[(False, True)] * width] * height)
+        transparent = mask != full
+
+        rle_data = rle_encode(data)
+        # Ícone só com pixels acesos opacos: a máscara é o próprio dado
+        shared = transparent and mask == data
+        rle_mask = rle_encode(mask) if transparent and not shared else b""
+        assert rle_decode(rle_data, len(data)) == data
+        if rle_mask:
+            assert rle_decode(rle_mask, len(mask)) == mask
+
+        name = asset_name(path)
+        raw_total += len(data) * (2 if transparent else 1)
+        packed_total += len(rle_data) + len(rle_mask)
+
+        header.append(f"extern const oled_asset_t {name};")
+        source.append(f"// {os.path.basename(path)}: {width}x{height}, "
+                      f"{len(data)} -> {len(rle_data)} bytes"
+                      + (", mascara = dados" if shared else "")
+                      + (f", mascara {len(mask)} -> {len(rle_mask)}" if rle_mask else ""))
+        source.append(f"static const uint8_t {name}_data[] = {{")
+        source += c_bytes(rle_data)
+        source.append("};")
+        if rle_mask:
+            source.append(f"static const uint8_t {name}_mask[] = {{")
+            source += c_bytes(rle_mask)
+            source.append("};")
+        source.append(f"const oled_asset_t {name} = {{")
+        source.append(f"    .width = {width},")
+        source.append(f"    .height = {height},")
+        source.append(f"    .data = {name}_data,")
+        if shared:
+            mask_ref = f"{name}_data"
+        else:
+            mask_ref = f"{name}_mask" if rle_mask else "NULL"
+        source.append(f"    .mask = {mask_ref},")
+        source.append("};")
+        source.append("")
+
+    header += ["", "#endif // ASSETS_H", ""]
+    source.append(f"// Total: {raw_total} bytes sem compressao -> {packed_total} bytes")
+    source.append("")
+
+    with open(os.path.join(args.out, "assets.h"), "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(header))
+    with open(os.path.join(args.out, "assets.c"), "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(source))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+Renderiza as camadas estáticas das telas do OLED em tempo de build.
+
+Cada tela vira um bitmap de 1024 bytes no mesmo formato do ram_buffer do
+ssd1306 (endereçamento vertical: byte = (y >> 3) + (x << 3), bit = y & 7).
+Em tempo de execução a tela é carregada com um memcpy direto da flash e só
+os campos variáveis são desenhados por cima.
+
+As primitivas abaixo reproduzem ssd1306_rect/line/draw_string pixel a pixel,
+usando a mesma fonte (lib/font.h).
+
+Uso: render_screens.py --font lib/font.h --out <diretório>
+"""
+
+import argparse
+import os
+import re
+import sys
+
+WIDTH = 128
+HEIGHT = 64
+SCREEN_BYTES = WIDTH * HEIGHT // 8
+
+
+class Canvas:
+    def __init__(self):
+        self.buf = bytearray(SCREEN_BYTES)
+
+    def pixel(self, x, y, value=True):
+        x &= 0xFF
+        y &= 0xFF
+        index = (y >> 3) + (x << 3)
+        if index >= SCREEN_BYTES:
+            return
+        if value:
+            self.buf[index] |= 1 << (y & 7)
+        else:
+            self.buf[index] &= ~(1 << (y & 7)) & 0xFF
+
+    # ssd1306_rect(top, left, width, height, value, fill)
+    def rect(self, top, left, width, height, value=True, fill=False):
+        for x in range(left, left + width):
+            self.pixel(x, top, value)
+            self.pixel(x, top + height - 1, value)
+        for y in range(top, top + height):
+            self.pixel(left, y, value)
+            self.pixel(left + width - 1, y, value)
+        if fill:
+            for x in range(left + 1, left + width - 1):
+                for y in range(top + 1, top + height - 1):
+                    self.pixel(x, y, value)
+
+    # ssd1306_line (Bresenham)
+    def line(self, x0, y0, x1, y1, value=True):
+        dx = abs(x1 - x0)
+        dy = abs(y1 - y0)
+        sx = 1 if x0 < x1 else -1
+        sy = 1 if y0 < y1 else -1
+        err = dx - dy
+        while True:
+            self.pixel(x0, y0, value)
+            if x0 == x1 and y0 == y1:
+                break
+            e2 = err * 2
+            if e2 > -dy:
+                err -= dy
+                x0 += sx
+            if e2 < dx:
+                err += dx
+                y0 += sy
+
+    def char(self, font, c, x, y):
+        code = ord(c)
+        index = (code - 32) * 8 if 32 <= code <= 126 else 0
+        for i in range(8):
+            bits = font[index + i]
+            for j in range(8):
+                self.pixel(x + i, y + j, bool(bits & (1 << j)))
+
+    # ssd1306_draw_string (inclusive a quebra de linha)
+    def string(self, font, text, x, y):
+        for c in text:
+            self.char(font, c, x, y)
+            x += 8
+            if x + 8 >= WIDTH:
+                x = 0
+                y += 8
+            if y + 8 >= HEIGHT:
+                break
+
+
+DIVIDERS = (25, 37)
+
+
+def frame_base(canvas, dividers=DIVIDERS):
+    """draw_frame_base(ssd, true): moldura e as divisórias."""
+    canvas.rect(3, 3, 122, 60, True, False)
+    for y in dividers:
+        canvas.line(3, y, 123, y)
+
+
+# Camadas estáticas: (nome, divisórias, [(texto, x, y), ...]). Os campos
+# variáveis de cada tela ficam no firmware (Teste_protocolo.c).
+SCREENS = [
+    ("boot", DIVIDERS, [
+        ("IR + WDT SYSTEM", 6, 6),
+    ]),
+    # Faixa y=15..37 livre para o ícone e os dígitos grandes (assets/oled)
+    ("running", (39,), [
+        ("AC CONTROL+WDT", 12, 6),
+        ("A=FALHA B=CMD", 10, 42),
+        ("WDT: ATIVO", 10, 52),
+    ]),
+    ("fault", DIVIDERS, [
+        ("FALHA INDUZIDA", 12, 6),
+        ("Sem feed WDT", 10, 28),
+        ("Aguard. reset", 10, 40),
+    ]),
+    ("fleet", DIVIDERS, [
+        ("FROTA AC", 12, 6),
+    ]),
+    # Gráficos (oled_graph) nas páginas 2-3 e 5-6, colunas 44..119
+    ("trends", (35,), [
+        ("TENDENCIAS", 12, 6),
+        ("LOOP", 8, 16),
+        ("CMD", 8, 40),
+    ]),
+]
+
+
+def load_font(path):
+    with open(path, encoding="latin-1") as f:
+        text = f.read()
+    body = text[text.index("{") + 1:text.rindex("}")]
+    body = re.sub(r"//[^\n]*", "", body)
+    values = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]{2}", body)]
+    if len(values) != 95 * 8:
+        sys.exit(f"render_screens: fonte com {len(values)} bytes, esperado {95 * 8}")
+    return values
+
+
+def write_file(path, content):
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(content)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("--font", required=True)
+    ap.add_argument("--out", required=True)
+    args = ap.parse_args()
+
+    font = load_font(args.font)
+    os.makedirs(args.out, exist_ok=True)
+
+    header = [
+        "// Gerado por tools/render_screens.py - não editar",
+        "#ifndef SCREENS_H",
+        "#define SCREENS_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define SCREEN_BYTES {SCREEN_BYTES}",
+        "",
+        "typedef enum {",
+    ]
+    header += [f"    SCREEN_{name.upper()}," for name, _, _ in SCREENS]
+    header += [
+        "    SCREEN_COUNT",
+        "} screen_id_t;",
+        "",
+        "// Camadas estáticas no formato do ram_buffer (sem o byte de controle)",
+        "extern const uint8_t *const screen_layers[SCREEN_COUNT];",
+        "",
+        "#endif // SCREENS_H",
+        "",
+    ]
+
+    source = [
+        "// Gerado por tools/render_screens.py - não editar",
+        '#include "screens.h"',
+        "",
+    ]
+    for name, dividers, texts in SCREENS:
+        canvas = Canvas()
+        frame_base(canvas, dividers)
+        for text, x, y in texts:
+            canvas.string(font, text, x, y)
+        source.append(f"static const uint8_t screen_{name}[SCREEN_BYTES] = {{")
+        for i in range(0, SCREEN_BYTES, 16):
+            row = ", ".join(f"0x{b:02X}" for b in canvas.buf[i:i + 16])
+            source.append(f"    {row},")
+        source.append("};")
+        source.append("")
+    source.append("const uint8_t *const screen_layers[SCREEN_COUNT] = {")
+    source += [f"    [SCREEN_{name.upper()}] = screen_{name}," for name, _, _ in SCREENS]
+    source.append("};")
+    source.append("")
+
+    write_file(os.path.join(args.out, "screens.h"), "\n".join(header))
+    write_file(os.path.join(args.out, "screens.c"), "\n".join(source))
+
+
+if __name__ == "__main__":
+    main()
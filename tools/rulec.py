@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+"""
+Compila regras de automação para a linha "@RU <hex>" (lib/rule_engine.h).
+
+Uma regra por linha, "#" começa comentário:
+
+  if no button for 2h and after 18:00 then off
+  if temp above 27 then fan 2
+  if temp below 24.5 and state is fan2 then on
+  if between 22:00 and 06:00 and idle >= 30min then off
+
+Condições (combinadas com and, or, not e parênteses):
+  temp above|below|<op> N     temperatura do chip em graus (aceita 27.5)
+  no button for D             nenhum botão/comando do console há D
+  idle <op> D                 D = 2h, 30min, 90s, 1h30min...
+  after HH:MM, before HH:MM   hora do dia (precisa de hora acertada, 'e')
+  between HH:MM and HH:MM     atravessa a meia-noite se o fim for menor
+  time <op> HH:MM
+  state is|not|<op> ESTADO
+<op> é um de < <= > >= == !=.
+
+Ações (estados da aplicação, em Teste_protocolo.c): off, on, 20, fan1,
+fan2 ("fan 2" também vale). O 22 dispara a falha proposital do firmware
+e é recusado.
+
+A ação dispara quando a condição passa de falsa a verdadeira. A lista
+com o código de cada regra vai para stderr.
+
+Uso: rulec.py regras.txt [> /dev/ttyACM0]
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from ac_profile import crc32_msb
+
+MAGIC = 0x314C5552
+MAX_RULES = 32
+MAX_BYTES = 1024
+STACK_MAX = 8
+MAX_OPS = 64
+
+# Mesmos índices de rule_input_t
+IN_TEMP, IN_IDLE, IN_CLOCK, IN_STATE = range(4)
+INPUT_NAMES = ["temp", "idle", "clock", "state"]
+
+# Mesmos códigos de rule_op_t
+OP_PUSH8, OP_PUSH16, OP_PUSH32, OP_LOAD = 0x01, 0x02, 0x03, 0x04
+CMP_OPS = {"==": 0x10, "!=": 0x11, "<": 0x12, "<=": 0x13, ">": 0x14, ">=": 0x15}
+OP_AND, OP_OR, OP_NOT = 0x20, 0x21, 0x22
+OP_NAMES = {OP_PUSH8: "push8", OP_PUSH16: "push16", OP_PUSH32: "push32", OP_LOAD: "load",
+            OP_AND: "and", OP_OR: "or", OP_NOT: "not"}
+OP_NAMES.update({code: op for op, code in CMP_OPS.items()})
+
+# Mesma ordem de system_state_t
+STATES = {"off": 0, "on": 1, "20": 2, "22": 3, "fan1": 4, "fan2": 5}
+STATE_FAULT = "22"
+
+UNITS = {"h": 3600, "min": 60, "m": 60, "s": 1}
+
+TOKEN = re.compile(r"\s*(?:(\d{1,2}:\d\d)|(\d+(?:\.\d+)?)|([a-z_]+)|(<=|>=|==|!=|<|>|=|\(|\)))")
+
+
+class RuleError(Exception):
+    pass
+
+
+def tokenize(text):
+    tokens, pos = [], 0
+    text = text.strip().lower()
+    while pos < len(text):
+        m = TOKEN.match(text, pos)
+        if not m or m.end() == pos:
+            raise RuleError(f"caractere inesperado: {text[pos:]!r}")
+        clock, number, word, sym = m.groups()
+        if clock:
+            tokens.append(("clock", clock))
+        elif number:
+            tokens.append(("num", number))
+        elif word:
+            tokens.append(("word", word))
+        else:
+            tokens.append(("sym", "==" if sym == "=" else sym))
+        pos = m.end()
+    return tokens
+
+
+class Compiler:
+    """Descida recursiva; cada nó emite o próprio código (pós-ordem)."""
+
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+        self.code = []          # (opcode, operando ou None)
+
+    def peek(self, value=None):
+        if self.pos >= len(self.tokens):
+            return None
+        tok = self.tokens[self.pos]
+        return tok if value is None or tok[1] == value else None
+
+    def take(self, value=None):
+        tok = self.peek()
+        if tok is None:
+            raise RuleError(f"fim inesperado (esperava {value or 'mais'})")
+        if value is not None and tok[1] != value:
+            raise RuleError(f"esperava '{value}', veio '{tok[1]}'")
+        self.pos += 1
+        return tok
+
+    def emit(self, op, arg=None):
+        self.code.append((op, arg))
+
+    def push(self, value):
+        if -128 <= value <= 127:
+            self.emit(OP_PUSH8, value)
+        elif -32768 <= value <= 32767:
+            self.emit(OP_PUSH16, value)
+        else:
+            self.emit(OP_PUSH32, value)
+
+    def compare(self, input_index, op, value):
+        self.emit(OP_LOAD, input_index)
+        self.push(value)
+        self.emit(CMP_OPS[op])
+
+    # ----- valores -----
+
+    def cmp_op(self):
+        tok = self.take()
+        if tok[1] not in CMP_OPS:
+            raise RuleError(f"esperava comparacao, veio '{tok[1]}'")
+        return tok[1]
+
+    def duration(self):
+        total, seen = 0, False
+        while self.peek() and self.peek()[0] == "num":
+            value = float(self.take()[1])
+            unit = self.take()[1]
+            if unit not in UNITS:
+                raise RuleError(f"unidade de tempo desconhecida: {unit} (h, min, s)")
+            total += value * UNITS[unit]
+            seen = True
+        if not seen:
+            raise RuleError("esperava duracao (ex.: 2h, 30min)")
+        return int(round(total))
+
+    def clock(self):
+        tok = self.take()
+        if tok[0] != "clock":
+            raise RuleError(f"esperava hora HH:MM, veio '{tok[1]}'")
+        hh, mm = map(int, tok[1].split(":"))
+        if hh > 23 or mm > 59:
+            raise RuleError(f"hora invalida: {tok[1]}")
+        return hh * 60 + mm
+
+    def temperature(self):
+        tok = self.take()
+        if tok[0] != "num":
+            raise RuleError(f"esperava temperatura, veio '{tok[1]}'")
+        if self.peek("c"):
+            self.take()
+        return int(round(float(tok[1]) * 10))
+
+    def state(self):
+        name = self.take()[1]
+        if name == "fan" and self.peek() and self.peek()[0] == "num":
+            name += self.take()[1]
+        if name not in STATES:
+            raise RuleError(f"estado desconhecido: {name} ({', '.join(STATES)})")
+        return name
+
+    # ----- condições -----
+
+    def condition(self):
+        self.conjunction()
+        while self.peek("or"):
+            self.take()
+            self.conjunction()
+            self.emit(OP_OR)
+
+    def conjunction(self):
+        self.unary()
+        while self.peek("and"):
+            self.take()
+            self.unary()
+            self.emit(OP_AND)
+
+    def unary(self):
+        if self.peek("not"):
+            self.take()
+            self.unary()
+            self.emit(OP_NOT)
+        elif self.peek("("):
+            self.take()
+            self.condition()
+            self.take(")")
+        else:
+            self.atom()
+
+    def atom(self):
+        word = self.take()[1]
+        if word == "temp":
+            if self.peek("above"):
+                self.take()
+                op = ">"
+            elif self.peek("below"):
+                self.take()
+                op = "<"
+            else:
+                op = self.cmp_op()
+            self.compare(IN_TEMP, op, self.temperature())
+        elif word == "no":
+            self.take("button")
+            self.take("for")
+            self.compare(IN_IDLE, ">=", self.duration())
+        elif word == "idle":
+            op = self.cmp_op()
+            self.compare(IN_IDLE, op, self.duration())
+        elif word == "after":
+            self.compare(IN_CLOCK, ">=", self.clock())
+        elif word == "before":
+            self.compare(IN_CLOCK, "<", self.clock())
+        elif word == "between":
+            start = self.clock()
+            self.take("and")
+            end = self.clock()
+            self.compare(IN_CLOCK, ">=", start)
+            self.compare(IN_CLOCK, "<", end)
+            self.emit(OP_AND if start <= end else OP_OR)
+        elif word == "time":
+            op = self.cmp_op()
+            self.compare(IN_CLOCK, op, self.clock())
+        elif word == "state":
+            if self.peek("is"):
+                self.take()
+                op = "=="
+            elif self.peek("not"):
+                self.take()
+                op = "!="
+            else:
+                op = self.cmp_op()
+            self.compare(IN_STATE, op, STATES[self.state()])
+        else:
+            raise RuleError(f"condicao desconhecida: '{word}'")
+
+    def rule(self):
+        self.take("if")
+        self.condition()
+        self.take("then")
+        action = self.state()
+        if self.peek():
+            raise RuleError(f"sobrou '{self.peek()[1]}' depois da acao")
+        if action == STATE_FAULT:
+            raise RuleError("o estado 22 dispara a falha proposital do firmware")
+        return STATES[action]
+
+
+def assemble(code):
+    """Bytes da regra e verificação de pilha/custo (mesmas regras do firmware)."""
+    out = bytearray()
+    depth = 0
+    for op, arg in code:
+        out.append(op)
+        if op == OP_PUSH8:
+            out += struct.pack("<b", arg)
+        elif op == OP_PUSH16:
+            out += struct.pack("<h", arg)
+        elif op == OP_PUSH32:
+            out += struct.pack("<i", arg)
+        elif op == OP_LOAD:
+            out.append(arg)
+        depth += 1 if op in (OP_PUSH8, OP_PUSH16, OP_PUSH32, OP_LOAD) else (0 if op == OP_NOT else -1)
+        if depth > STACK_MAX:
+            raise RuleError(f"condicao profunda demais (pilha de {STACK_MAX})")
+    if len(code) > MAX_OPS:
+        raise RuleError(f"condicao longa demais ({len(code)} instrucoes, max {MAX_OPS})")
+    return bytes(out)
+
+
+def listing(code):
+    parts = []
+    for op, arg in code:
+        if op == OP_LOAD:
+            parts.append(f"load {INPUT_NAMES[arg]}")
+        elif arg is not None:
+            parts.append(f"push {arg}")
+        else:
+            parts.append(OP_NAMES[op])
+    return "; ".join(parts)
+
+
+def compile_rules(lines, path):
+    entries, code, names = [], bytearray(), {v: k for k, v in STATES.items()}
+    for lineno, text in enumerate(lines, 1):
+        text = text.split("#", 1)[0]
+        if not text.strip():
+            continue
+        try:
+            c = Compiler(tokenize(text))
+            action = c.rule()
+            body = assemble(c.code)
+        except RuleError as e:
+            sys.exit(f"rulec: {path}:{lineno}: {e}")
+        if len(entries) == MAX_RULES:
+            sys.exit(f"rulec: no maximo {MAX_RULES} regras")
+        print(f"regra {len(entries)} (linha {lineno}) -> {names[action]}: "
+              f"{len(c.code)} instr, {len(body)} bytes: {listing(c.code)}", file=sys.stderr)
+        entries.append(struct.pack("<HBB", len(code), len(body), action))
+        code += body
+
+    if not entries:
+        sys.exit(f"rulec: {path}: nenhuma regra")
+    body = b"".join(entries) + bytes(code)
+    blob = struct.pack("<IBBHI", MAGIC, len(entries), 0, len(code), crc32_msb(body)) + body
+    if len(blob) > MAX_BYTES:
+        sys.exit(f"rulec: programa com {len(blob)} bytes (max {MAX_BYTES})")
+    return blob
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Regras de automacao -> linha @RU")
+    ap.add_argument("rules", help="arquivo de regras (uma por linha)")
+    args = ap.parse_args()
+
+    with open(args.rules, encoding="utf-8") as f:
+        blob = compile_rules(f.readlines(), args.rules)
+    print("@RU " + blob.hex().upper())
+
+
+if __name__ == "__main__":
+    main()